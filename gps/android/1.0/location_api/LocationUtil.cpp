@@ -119,7 +119,7 @@ void convertGnssLocation(const GnssLocation& in, Location& out)
     out.timestamp = static_cast<uint64_t>(in.timestamp);
 }
 
-void convertGnssConstellationType(GnssSvType& in, GnssConstellationType& out)
+void convertGnssConstellationType(const GnssSvType& in, GnssConstellationType& out)
 {
     switch(in) {
         case GNSS_SV_TYPE_GPS:
@@ -147,7 +147,7 @@ void convertGnssConstellationType(GnssSvType& in, GnssConstellationType& out)
     }
 }
 
-void convertGnssSvid(GnssSv& in, int16_t& out)
+void convertGnssSvid(const GnssSv& in, int16_t& out)
 {
     switch(in.type){
         case GNSS_SV_TYPE_GPS:
@@ -174,7 +174,7 @@ void convertGnssSvid(GnssSv& in, int16_t& out)
     }
 }
 
-void convertGnssSvid(GnssMeasurementsData& in, int16_t& out)
+void convertGnssSvid(const GnssMeasurementsData& in, int16_t& out)
 {
     switch (in.svType) {
         case GNSS_SV_TYPE_GPS:
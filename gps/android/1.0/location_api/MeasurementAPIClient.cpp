@@ -45,11 +45,12 @@ namespace implementation {
 using ::android::hardware::gnss::V1_0::IGnssMeasurement;
 using ::android::hardware::gnss::V1_0::IGnssMeasurementCallback;
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out);
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out);
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out);
 
 MeasurementAPIClient::MeasurementAPIClient() :
     mGnssMeasurementCbIface(nullptr),
@@ -93,10 +94,11 @@ MeasurementAPIClient::startTracking()
     locationCallbacks.gnssNmeaCb = nullptr;
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
+    locationCallbacks.gnssMeasurementsRefCb = nullptr;
     if (mGnssMeasurementCbIface != nullptr) {
-        locationCallbacks.gnssMeasurementsCb =
-            [this](GnssMeasurementsNotification gnssMeasurementsNotification) {
-                onGnssMeasurementsCb(gnssMeasurementsNotification);
+        locationCallbacks.gnssMeasurementsRefCb =
+            [this](const GnssMeasurementsNotification& gnssMeasurementsNotification) {
+                onGnssMeasurementsRefCb(gnssMeasurementsNotification);
             };
     }
 
@@ -124,6 +126,12 @@ void MeasurementAPIClient::measurementClose() {
 // callbacks
 void MeasurementAPIClient::onGnssMeasurementsCb(
         GnssMeasurementsNotification gnssMeasurementsNotification)
+{
+    onGnssMeasurementsRefCb(gnssMeasurementsNotification);
+}
+
+void MeasurementAPIClient::onGnssMeasurementsRefCb(
+        const GnssMeasurementsNotification& gnssMeasurementsNotification)
 {
     LOC_LOGD("%s]: (count: %zu active: %d)",
             __FUNCTION__, gnssMeasurementsNotification.count, mTracking);
@@ -147,7 +155,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
     }
 }
 
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
 {
     memset(&out, 0, sizeof(IGnssMeasurementCallback::GnssMeasurement));
@@ -226,7 +234,8 @@ static void convertGnssMeasurement(GnssMeasurementsData& in,
     out.agcLevelDb = in.agcLevelDb;
 }
 
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out)
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out)
 {
     memset(&out, 0, sizeof(IGnssMeasurementCallback::GnssClock));
     if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
@@ -254,7 +263,7 @@ static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback
     out.hwClockDiscontinuityCount = in.hwClockDiscontinuityCount;
 }
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out)
 {
     out.measurementCount = in.count;
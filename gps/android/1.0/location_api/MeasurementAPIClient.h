@@ -63,6 +63,9 @@ public:
     void onGnssMeasurementsCb(GnssMeasurementsNotification gnssMeasurementsNotification) final;
 
 private:
+    void onGnssMeasurementsRefCb(
+            const GnssMeasurementsNotification& gnssMeasurementsNotification);
+
     std::mutex mMutex;
     sp<V1_0::IGnssMeasurementCallback> mGnssMeasurementCbIface;
 
@@ -92,6 +92,10 @@ public:
     void onStopTrackingCb(LocationError error) final;
 
 private:
+    void onGnssSvRefCb(const GnssSvNotification& gnssSvNotification);
+    void onGnssNmeaSentencesCb(
+            const GnssNmeaSentencesNotification& gnssNmeaSentencesNotification);
+
     sp<V1_0::IGnssCallback> mGnssCbIface;
     sp<V1_0::IGnssNiCallback> mGnssNiCbIface;
     std::mutex mMutex;
@@ -45,13 +45,14 @@ namespace implementation {
 using ::android::hardware::gnss::V1_0::IGnssMeasurement;
 using ::android::hardware::gnss::V1_1::IGnssMeasurementCallback;
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+static void convertGnssData_1_1(const GnssMeasurementsNotification& in,
         IGnssMeasurementCallback::GnssData& out);
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out);
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out);
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out);
 
 MeasurementAPIClient::MeasurementAPIClient() :
     mGnssMeasurementCbIface(nullptr),
@@ -112,10 +113,11 @@ MeasurementAPIClient::startTracking(
     locationCallbacks.gnssNmeaCb = nullptr;
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
+    locationCallbacks.gnssMeasurementsRefCb = nullptr;
     if (mGnssMeasurementCbIface_1_1 != nullptr || mGnssMeasurementCbIface != nullptr) {
-        locationCallbacks.gnssMeasurementsCb =
-            [this](GnssMeasurementsNotification gnssMeasurementsNotification) {
-                onGnssMeasurementsCb(gnssMeasurementsNotification);
+        locationCallbacks.gnssMeasurementsRefCb =
+            [this](const GnssMeasurementsNotification& gnssMeasurementsNotification) {
+                onGnssMeasurementsRefCb(gnssMeasurementsNotification);
             };
     }
 
@@ -147,6 +149,12 @@ void MeasurementAPIClient::measurementClose() {
 // callbacks
 void MeasurementAPIClient::onGnssMeasurementsCb(
         GnssMeasurementsNotification gnssMeasurementsNotification)
+{
+    onGnssMeasurementsRefCb(gnssMeasurementsNotification);
+}
+
+void MeasurementAPIClient::onGnssMeasurementsRefCb(
+        const GnssMeasurementsNotification& gnssMeasurementsNotification)
 {
     LOC_LOGD("%s]: (count: %zu active: %d)",
             __FUNCTION__, gnssMeasurementsNotification.count, mTracking);
@@ -181,7 +189,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
     }
 }
 
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
 {
     memset(&out, 0, sizeof(IGnssMeasurementCallback::GnssMeasurement));
@@ -260,7 +268,8 @@ static void convertGnssMeasurement(GnssMeasurementsData& in,
     out.agcLevelDb = in.agcLevelDb;
 }
 
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out)
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out)
 {
     memset(&out, 0, sizeof(IGnssMeasurementCallback::GnssClock));
     if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
@@ -288,7 +297,7 @@ static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback
     out.hwClockDiscontinuityCount = in.hwClockDiscontinuityCount;
 }
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out)
 {
     out.measurementCount = in.count;
@@ -303,7 +312,7 @@ static void convertGnssData(GnssMeasurementsNotification& in,
     convertGnssClock(in.clock, out.clock);
 }
 
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+static void convertGnssData_1_1(const GnssMeasurementsNotification& in,
         IGnssMeasurementCallback::GnssData& out)
 {
     out.measurements.resize(in.count);
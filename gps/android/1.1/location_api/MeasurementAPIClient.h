@@ -69,6 +69,9 @@ public:
     void onGnssMeasurementsCb(GnssMeasurementsNotification gnssMeasurementsNotification) final;
 
 private:
+    void onGnssMeasurementsRefCb(
+            const GnssMeasurementsNotification& gnssMeasurementsNotification);
+
     std::mutex mMutex;
     sp<V1_0::IGnssMeasurementCallback> mGnssMeasurementCbIface;
     sp<IGnssMeasurementCallback> mGnssMeasurementCbIface_1_1;
@@ -33,6 +33,7 @@
 
 #include <log_util.h>
 #include <loc_cfg.h>
+#include <loc_nmea.h>
 
 #include "LocationUtil.h"
 #include "GnssAPIClient.h"
@@ -49,8 +50,9 @@ using ::android::hardware::gnss::V2_0::IGnssCallback;
 using ::android::hardware::gnss::V1_0::IGnssNiCallback;
 using ::android::hardware::gnss::V2_0::GnssLocation;
 
-static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out);
-static void convertGnssSvStatus(GnssSvNotification& in,
+static void convertGnssSvStatus(const GnssSvNotification& in,
+        V1_0::IGnssCallback::GnssSvStatus& out);
+static void convertGnssSvStatus(const GnssSvNotification& in,
         hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out);
 
 GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
@@ -145,13 +147,14 @@ void GnssAPIClient::setCallbacks()
         }
     }
 
-    locationCallbacks.gnssSvCb = [this](GnssSvNotification gnssSvNotification) {
-        onGnssSvCb(gnssSvNotification);
+    locationCallbacks.gnssSvRefCb = [this](const GnssSvNotification& gnssSvNotification) {
+        onGnssSvRefCb(gnssSvNotification);
     };
 
-    locationCallbacks.gnssNmeaCb = [this](GnssNmeaNotification gnssNmeaNotification) {
-        onGnssNmeaCb(gnssNmeaNotification);
-    };
+    locationCallbacks.gnssNmeaSentencesCb =
+        [this](const GnssNmeaSentencesNotification& gnssNmeaSentencesNotification) {
+            onGnssNmeaSentencesCb(gnssNmeaSentencesNotification);
+        };
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
 
@@ -550,6 +553,11 @@ void GnssAPIClient::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotificatio
 }
 
 void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
+{
+    onGnssSvRefCb(gnssSvNotification);
+}
+
+void GnssAPIClient::onGnssSvRefCb(const GnssSvNotification& gnssSvNotification)
 {
     LOC_LOGD("%s]: (count: %u)", __FUNCTION__, gnssSvNotification.count);
     mMutex.lock();
@@ -577,6 +585,21 @@ void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
 }
 
 void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
+{
+    std::string buffer;
+    std::vector<GnssNmeaSentence> sentences;
+    loc_nmea_split(gnssNmeaNotification.nmea, gnssNmeaNotification.length, buffer, sentences);
+
+    GnssNmeaSentencesNotification sentencesNotification = {};
+    sentencesNotification.size = sizeof(GnssNmeaSentencesNotification);
+    sentencesNotification.timestamp = gnssNmeaNotification.timestamp;
+    sentencesNotification.count = sentences.size();
+    sentencesNotification.sentences = sentences.data();
+    onGnssNmeaSentencesCb(sentencesNotification);
+}
+
+void GnssAPIClient::onGnssNmeaSentencesCb(
+        const GnssNmeaSentencesNotification& gnssNmeaSentencesNotification)
 {
     mMutex.lock();
     auto gnssCbIface(mGnssCbIface);
@@ -584,27 +607,36 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
     mMutex.unlock();
 
     if (gnssCbIface != nullptr || gnssCbIface_2_0 != nullptr) {
-        const std::string s(gnssNmeaNotification.nmea);
-        std::stringstream ss(s);
-        std::string each;
-        while(std::getline(ss, each, '\n')) {
-            each += '\n';
+        auto timestamp =
+                static_cast<V1_0::GnssUtcTime>(gnssNmeaSentencesNotification.timestamp);
+        for (uint32_t i = 0; i < gnssNmeaSentencesNotification.count; i++) {
+            const GnssNmeaSentence& sentence = gnssNmeaSentencesNotification.sentences[i];
+            if (0 == sentence.length) {
+                continue;
+            }
+            // sentences are NULL terminated, pass them to hidl in place and
+            // only copy the odd one that lacks the line feed the framework expects
+            std::string terminated;
             android::hardware::hidl_string nmeaString;
-            nmeaString.setToExternal(each.c_str(), each.length());
+            if ('\n' == sentence.sentence[sentence.length - 1]) {
+                nmeaString.setToExternal(sentence.sentence, sentence.length);
+            } else {
+                terminated.assign(sentence.sentence, sentence.length);
+                terminated += '\n';
+                nmeaString.setToExternal(terminated.c_str(), terminated.length());
+            }
             if (gnssCbIface_2_0 != nullptr) {
-                auto r = gnssCbIface_2_0->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+                auto r = gnssCbIface_2_0->gnssNmeaCb(timestamp, nmeaString);
                 if (!r.isOk()) {
                     LOC_LOGE("%s] Error from gnssCbIface_2_0 nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
+                             __func__, sentence.sentence, sentence.length,
                              r.description().c_str());
                 }
             } else if (gnssCbIface != nullptr) {
-                auto r = gnssCbIface->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+                auto r = gnssCbIface->gnssNmeaCb(timestamp, nmeaString);
                 if (!r.isOk()) {
                     LOC_LOGE("%s] Error from gnssNmeaCb nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
+                             __func__, sentence.sentence, sentence.length,
                              r.description().c_str());
                 }
             }
@@ -683,7 +715,8 @@ void GnssAPIClient::onStopTrackingCb(LocationError error)
     }
 }
 
-static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out)
+static void convertGnssSvStatus(const GnssSvNotification& in,
+        V1_0::IGnssCallback::GnssSvStatus& out)
 {
     memset(&out, 0, sizeof(IGnssCallback::GnssSvStatus));
     out.numSvs = in.count;
@@ -711,7 +744,7 @@ static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::Gns
     }
 }
 
-static void convertGnssSvStatus(GnssSvNotification& in,
+static void convertGnssSvStatus(const GnssSvNotification& in,
         hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out)
 {
     out.resize(in.count);
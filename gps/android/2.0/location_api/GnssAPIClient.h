@@ -97,6 +97,9 @@ private:
     void setCallbacks();
     void setFlpCallbacks();
     void initLocationOptions();
+    void onGnssSvRefCb(const GnssSvNotification& gnssSvNotification);
+    void onGnssNmeaSentencesCb(
+            const GnssNmeaSentencesNotification& gnssNmeaSentencesNotification);
     sp<V1_0::IGnssCallback> mGnssCbIface;
     sp<V1_0::IGnssNiCallback> mGnssNiCbIface;
     std::mutex mMutex;
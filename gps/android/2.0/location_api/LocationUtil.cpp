@@ -203,7 +203,7 @@ void convertGnssLocation(const V2_0::GnssLocation& in, Location& out)
     convertGnssLocation(in.v1_0, out);
 }
 
-void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& out)
+void convertGnssConstellationType(const GnssSvType& in, V1_0::GnssConstellationType& out)
 {
     switch(in) {
         case GNSS_SV_TYPE_GPS:
@@ -231,7 +231,7 @@ void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& o
     }
 }
 
-void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& out)
+void convertGnssConstellationType(const GnssSvType& in, V2_0::GnssConstellationType& out)
 {
     switch(in) {
         case GNSS_SV_TYPE_GPS:
@@ -262,7 +262,7 @@ void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& o
     }
 }
 
-void convertGnssSvid(GnssSv& in, int16_t& out)
+void convertGnssSvid(const GnssSv& in, int16_t& out)
 {
     switch (in.type) {
         case GNSS_SV_TYPE_GPS:
@@ -289,7 +289,7 @@ void convertGnssSvid(GnssSv& in, int16_t& out)
     }
 }
 
-void convertGnssSvid(GnssMeasurementsData& in, int16_t& out)
+void convertGnssSvid(const GnssMeasurementsData& in, int16_t& out)
 {
     switch (in.svType) {
         case GNSS_SV_TYPE_GPS:
@@ -44,10 +44,10 @@ void convertGnssLocation(Location& in, V1_0::GnssLocation& out);
 void convertGnssLocation(Location& in, V2_0::GnssLocation& out);
 void convertGnssLocation(const V1_0::GnssLocation& in, Location& out);
 void convertGnssLocation(const V2_0::GnssLocation& in, Location& out);
-void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& out);
-void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& out);
-void convertGnssSvid(GnssSv& in, int16_t& out);
-void convertGnssSvid(GnssMeasurementsData& in, int16_t& out);
+void convertGnssConstellationType(const GnssSvType& in, V1_0::GnssConstellationType& out);
+void convertGnssConstellationType(const GnssSvType& in, V2_0::GnssConstellationType& out);
+void convertGnssSvid(const GnssSv& in, int16_t& out);
+void convertGnssSvid(const GnssMeasurementsData& in, int16_t& out);
 void convertGnssEphemerisType(GnssEphemerisType& in, GnssDebug::SatelliteEphemerisType& out);
 void convertGnssEphemerisSource(GnssEphemerisSource& in, GnssDebug::SatelliteEphemerisSource& out);
 void convertGnssEphemerisHealth(GnssEphemerisHealth& in, GnssDebug::SatelliteEphemerisHealth& out);
@@ -46,16 +46,17 @@ namespace implementation {
 using ::android::hardware::gnss::V1_0::IGnssMeasurement;
 using ::android::hardware::gnss::V2_0::IGnssMeasurementCallback;
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+static void convertGnssData_1_1(const GnssMeasurementsNotification& in,
         V1_1::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_2_0(GnssMeasurementsNotification& in,
+static void convertGnssData_2_0(const GnssMeasurementsNotification& in,
         V2_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out);
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out);
-static void convertGnssMeasurementsCodeType(GnssMeasurementsCodeType& in,
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out);
+static void convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& in,
         ::android::hardware::hidl_string& out);
 
 MeasurementAPIClient::MeasurementAPIClient() :
@@ -133,12 +134,13 @@ MeasurementAPIClient::startTracking(
     locationCallbacks.gnssNmeaCb = nullptr;
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
+    locationCallbacks.gnssMeasurementsRefCb = nullptr;
     if (mGnssMeasurementCbIface_2_0 != nullptr ||
         mGnssMeasurementCbIface_1_1 != nullptr ||
         mGnssMeasurementCbIface != nullptr) {
-        locationCallbacks.gnssMeasurementsCb =
-            [this](GnssMeasurementsNotification gnssMeasurementsNotification) {
-                onGnssMeasurementsCb(gnssMeasurementsNotification);
+        locationCallbacks.gnssMeasurementsRefCb =
+            [this](const GnssMeasurementsNotification& gnssMeasurementsNotification) {
+                onGnssMeasurementsRefCb(gnssMeasurementsNotification);
             };
     }
 
@@ -170,6 +172,12 @@ void MeasurementAPIClient::measurementClose() {
 // callbacks
 void MeasurementAPIClient::onGnssMeasurementsCb(
         GnssMeasurementsNotification gnssMeasurementsNotification)
+{
+    onGnssMeasurementsRefCb(gnssMeasurementsNotification);
+}
+
+void MeasurementAPIClient::onGnssMeasurementsRefCb(
+        const GnssMeasurementsNotification& gnssMeasurementsNotification)
 {
     LOC_LOGD("%s]: (count: %u active: %d)",
             __FUNCTION__, gnssMeasurementsNotification.count, mTracking);
@@ -215,7 +223,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
     }
 }
 
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
 {
     memset(&out, 0, sizeof(out));
@@ -294,7 +302,8 @@ static void convertGnssMeasurement(GnssMeasurementsData& in,
     out.agcLevelDb = in.agcLevelDb;
 }
 
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out)
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out)
 {
     memset(&out, 0, sizeof(out));
     if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
@@ -322,7 +331,7 @@ static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback
     out.hwClockDiscontinuityCount = in.hwClockDiscontinuityCount;
 }
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
@@ -338,7 +347,7 @@ static void convertGnssData(GnssMeasurementsNotification& in,
     convertGnssClock(in.clock, out.clock);
 }
 
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
+static void convertGnssData_1_1(const GnssMeasurementsNotification& in,
         V1_1::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
@@ -361,7 +370,7 @@ static void convertGnssData_1_1(GnssMeasurementsNotification& in,
     convertGnssClock(in.clock, out.clock);
 }
 
-static void convertGnssData_2_0(GnssMeasurementsNotification& in,
+static void convertGnssData_2_0(const GnssMeasurementsNotification& in,
         V2_0::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
@@ -460,7 +469,7 @@ static void convertGnssData_2_0(GnssMeasurementsNotification& in,
     }
 }
 
-static void convertGnssMeasurementsCodeType(GnssMeasurementsCodeType& in,
+static void convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& in,
         ::android::hardware::hidl_string& out)
 {
     switch(in) {
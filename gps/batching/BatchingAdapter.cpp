@@ -596,7 +596,7 @@ BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
 {
     LOC_LOGD("%s]: count %zu batchMode %d", __func__, count, batchingMode);
 
-    struct MsgReportLocations : public LocMsg {
+    struct MsgReportLocations : public LocMsg, public LocPooledMsg {
         BatchingAdapter& mAdapter;
         Location* mLocations;
         size_t mCount;
@@ -607,21 +607,16 @@ BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
                                   BatchingMode batchingMode) :
             LocMsg(),
             mAdapter(adapter),
-            mLocations(new Location[count]),
+            mLocations((Location*)LocMsg::poolAlloc(sizeof(Location) * count)),
             mCount(count),
             mBatchingMode(batchingMode)
         {
-            if (nullptr == mLocations) {
-                LOC_LOGE("%s]: new failed to allocate mLocations", __func__);
-                return;
-            }
             for (size_t i=0; i < mCount; ++i) {
                 mLocations[i] = locations[i];
             }
         }
         inline virtual ~MsgReportLocations() {
-            if (nullptr != mLocations)
-                delete[] mLocations;
+            LocMsg::poolFree(mLocations);
         }
         inline virtual void proc() const {
             mAdapter.reportLocations(mLocations, mCount, mBatchingMode);
@@ -49,6 +49,48 @@ LOCAL_CFLAGS += $(GNSS_CFLAGS)
 
 include $(BUILD_SHARED_LIBRARY)
 
+# Measures the adapter and LocApi messages of a geofence command, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_api_geofence_bench
+LOCAL_SRC_FILES := loc_api_geofence_bench.cpp
+LOCAL_SHARED_LIBRARIES := \
+    libloc_core \
+    libgps.utils
+LOCAL_C_INCLUDES:= \
+    $(LOCAL_PATH)/data-items \
+    $(LOCAL_PATH)/data-items/common \
+    $(LOCAL_PATH)/observer
+LOCAL_HEADER_LIBRARIES := \
+    libutils_headers \
+    libgps.utils_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+# Checks the debug NMEA parsers against the original ones and times them, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := system_status_bench
+LOCAL_SRC_FILES := system_status_bench.cpp
+LOCAL_SHARED_LIBRARIES := \
+    libloc_core \
+    libgps.utils
+LOCAL_C_INCLUDES:= \
+    $(LOCAL_PATH)/data-items \
+    $(LOCAL_PATH)/data-items/common \
+    $(LOCAL_PATH)/observer
+LOCAL_HEADER_LIBRARIES := \
+    libutils_headers \
+    libgps.utils_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := libloc_core_headers
 LOCAL_EXPORT_C_INCLUDE_DIRS := \
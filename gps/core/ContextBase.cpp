@@ -92,6 +92,7 @@ const loc_param_s_type ContextBase::mGps_conf_table[] =
   {"CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED",
            &mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED, NULL, 'n'},
   {"NI_SUPL_DENY_ON_NFW_LOCKED",  &mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED, NULL, 'n'},
+  {"GEOFENCE_OVERFLOW_ENABLED",      &mGps_conf.GEOFENCE_OVERFLOW_ENABLED,      NULL, 'n'},
 };
 
 const loc_param_s_type ContextBase::mSap_conf_table[] =
@@ -175,6 +176,9 @@ void ContextBase::readConfig()
         /* inject supl config to modem with config values from config.xml or gps.conf, default 1 */
         mGps_conf.AGPS_CONFIG_INJECT = 1;
 
+        /* keep the geofences the modem has no room for on the AP, default 0 */
+        mGps_conf.GEOFENCE_OVERFLOW_ENABLED = 0;
+
         /* default configuration value of constrained time uncertainty mode:
            feature disabled, time uncertainty threshold defined by modem,
            and unlimited power budget */
@@ -213,6 +217,50 @@ void ContextBase::readConfig()
     }
 }
 
+LocConfChangeMask ContextBase::reloadConfig()
+{
+    loc_gps_cfg_s_type conf = mGps_conf;
+    const loc_param_s_type reload_table[] =
+    {
+      {"INTERMEDIATE_POS",               &conf.INTERMEDIATE_POS,               NULL, 'n'},
+      {"ACCURACY_THRES",                 &conf.ACCURACY_THRES,                 NULL, 'n'},
+      {"NMEA_PROVIDER",                  &conf.NMEA_PROVIDER,                  NULL, 'n'},
+      {"CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED",
+               &conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED, NULL, 'n'},
+    };
+    const loc_logger_s_type logger = loc_logger;
+    // this also applies the logging items, as at start up
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, reload_table);
+
+    LocConfChangeMask changed = 0;
+    if (conf.INTERMEDIATE_POS != mGps_conf.INTERMEDIATE_POS ||
+        conf.ACCURACY_THRES != mGps_conf.ACCURACY_THRES) {
+        // LocApiBase::reportPosition() picks these up with the next fix
+        mGps_conf.INTERMEDIATE_POS = conf.INTERMEDIATE_POS;
+        mGps_conf.ACCURACY_THRES = conf.ACCURACY_THRES;
+        changed |= LOC_CONF_CHANGE_FIX_FILTER;
+    }
+    if (conf.NMEA_PROVIDER != mGps_conf.NMEA_PROVIDER ||
+        conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED !=
+                mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED) {
+        mGps_conf.NMEA_PROVIDER = conf.NMEA_PROVIDER;
+        mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED = conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED;
+        changed |= LOC_CONF_CHANGE_NMEA;
+    }
+    if (logger.DEBUG_LEVEL != loc_logger.DEBUG_LEVEL ||
+        logger.TIMESTAMP != loc_logger.TIMESTAMP ||
+        logger.LOG_BUFFER_ENABLE != loc_logger.LOG_BUFFER_ENABLE ||
+        logger.LOG_BUFFER_BINARY != loc_logger.LOG_BUFFER_BINARY ||
+        logger.LOGCAT_LEVEL != loc_logger.LOGCAT_LEVEL) {
+        changed |= LOC_CONF_CHANGE_LOGGING;
+    }
+
+    LOC_LOGi("changed 0x%x, INTERMEDIATE_POS %u ACCURACY_THRES %u NMEA_PROVIDER %u "
+             "DEBUG_LEVEL %lu", changed, mGps_conf.INTERMEDIATE_POS,
+             mGps_conf.ACCURACY_THRES, mGps_conf.NMEA_PROVIDER, loc_logger.DEBUG_LEVEL);
+    return changed;
+}
+
 uint32_t ContextBase::getCarrierCapabilities() {
     #define carrierMSA (uint32_t)0x2
     #define carrierMSB (uint32_t)0x1
@@ -76,8 +76,21 @@ typedef struct loc_gps_cfg_s
     uint32_t       GNSS_DEPLOYMENT;
     uint32_t       CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED;
     uint32_t       NI_SUPL_DENY_ON_NFW_LOCKED;
+    uint32_t       GEOFENCE_OVERFLOW_ENABLED;
 } loc_gps_cfg_s_type;
 
+/* gps.conf items that ContextBase::reloadConfig() takes in at run time,
+   grouped by what has to be reconfigured for them. All the others are
+   only read at start up. */
+typedef uint32_t LocConfChangeMask;
+/* INTERMEDIATE_POS, ACCURACY_THRES */
+#define LOC_CONF_CHANGE_FIX_FILTER  ((LocConfChangeMask)0x00000001)
+/* NMEA_PROVIDER, CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED */
+#define LOC_CONF_CHANGE_NMEA        ((LocConfChangeMask)0x00000002)
+/* DEBUG_LEVEL, TIMESTAMP, LOG_BUFFER_ENABLED, LOG_BUFFER_BINARY,
+   LOG_BUFFER_LOGCAT_LEVEL */
+#define LOC_CONF_CHANGE_LOGGING     ((LocConfChangeMask)0x00000004)
+
 /* NOTE: the implementaiton of the parser casts number
    fields to 32 bit. To ensure all 'n' fields working,
    they must all be 32 bit fields. */
@@ -158,6 +171,13 @@ public:
     static bool sGnssMeasurementSupported;
 
     void readConfig();
+    /*
+        Re-reads gps.conf once it is edited, and updates the items that
+        can change at run time, see LocConfChangeMask. To be called on the
+        MsgTask thread, where mGps_conf is also updated by the framework.
+        Returns which groups of items changed.
+    */
+    LocConfChangeMask reloadConfig();
     static uint32_t getCarrierCapabilities();
     void setEngineCapabilities(uint64_t supportedMsgMask,
             uint8_t *featureList, bool gnssMeasurementSupported);
@@ -130,6 +130,10 @@ public:
         mMsgTask->sendMsg(msg);
     }
 
+    inline void sendMsg(const LocMsg* msg, LocMsgPriority priority) const {
+        mMsgTask->sendMsg(msg, priority);
+    }
+
     inline void updateEvtMask(LOC_API_ADAPTER_EVENT_MASK_T event,
                               loc_registration_mask_status status)
     {
@@ -31,6 +31,7 @@
 
 #include <dlfcn.h>
 #include <inttypes.h>
+#include <memory>
 #include <gps_extended_c.h>
 #include <LocApiBase.h>
 #include <LocAdapterBase.h>
@@ -149,6 +150,9 @@ struct LocCloseMsg : public LocMsg {
 };
 
 MsgTask* LocApiBase::mMsgTask = nullptr;
+// number of ring slots backing the LocApiMsgTask msg_q
+static const size_t LOC_API_MSG_TASK_Q_SIZE = 256;
+static const uint32_t LOC_API_MSG_TASK_BATCH_SIZE = 16;
 volatile int32_t LocApiBase::mMsgTaskRefCount = 0;
 
 LocApiBase::LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
@@ -160,7 +164,8 @@ LocApiBase::LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
 
     android_atomic_inc(&mMsgTaskRefCount);
     if (nullptr == mMsgTask) {
-        mMsgTask = new MsgTask("LocApiMsgTask", false);
+        mMsgTask = new MsgTask("LocApiMsgTask", false, LOC_API_MSG_TASK_Q_SIZE);
+        mMsgTask->setBatchDrain(LOC_API_MSG_TASK_BATCH_SIZE);
     }
 }
 
@@ -806,6 +811,103 @@ void LocApiBase::modifyGeofence(uint32_t /*hwId*/, uint32_t /*clientId*/,
          const GeofenceOption& /*options*/, LocApiResponse* /*adapterResponse*/)
 DEFAULT_IMPL()
 
+// Collects the single responses of a batched geofence request that is
+// played as one call per geofence. The responses all run on the context
+// thread, so no locking is needed.
+struct LocApiGeofencesBatch {
+    LocApiGeofencesData mData;
+    size_t mPending;
+    LocApiResponseData<LocApiGeofencesData>* mAdapterResponseData;
+    inline LocApiGeofencesBatch(size_t count,
+                                LocApiResponseData<LocApiGeofencesData>* adapterResponseData) :
+        mPending(count), mAdapterResponseData(adapterResponseData) {
+        mData.errs.assign(count, LOCATION_ERROR_GENERAL_FAILURE);
+    }
+    static std::shared_ptr<LocApiGeofencesBatch> create(size_t count,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData) {
+        std::shared_ptr<LocApiGeofencesBatch> batch =
+                std::make_shared<LocApiGeofencesBatch>(count, adapterResponseData);
+        if (0 == count) {
+            batch->returnToSender();
+        }
+        return batch;
+    }
+    inline void done(size_t i, LocationError err) {
+        mData.errs[i] = err;
+        if (0 == --mPending) {
+            returnToSender();
+        }
+    }
+    inline void returnToSender() {
+        if (nullptr != mAdapterResponseData) {
+            mAdapterResponseData->returnToSender(LOCATION_ERROR_SUCCESS, mData);
+            mAdapterResponseData = nullptr;
+        }
+    }
+};
+
+void LocApiBase::addGeofences(size_t count, const uint32_t* clientIds,
+        const GeofenceOption* options, const GeofenceInfo* infos,
+        LocApiResponseData<LocApiGeofencesData>* adapterResponseData)
+{
+    std::shared_ptr<LocApiGeofencesBatch> batch =
+            LocApiGeofencesBatch::create(count, adapterResponseData);
+    batch->mData.hwIds.assign(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        addGeofence(clientIds[i], options[i], infos[i],
+                new LocApiResponseData<LocApiGeofenceData>(*mContext,
+                [batch, i] (LocationError err, LocApiGeofenceData data) {
+            batch->mData.hwIds[i] = data.hwId;
+            batch->done(i, err);
+        }));
+    }
+}
+
+void LocApiBase::removeGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+        LocApiResponseData<LocApiGeofencesData>* adapterResponseData)
+{
+    std::shared_ptr<LocApiGeofencesBatch> batch =
+            LocApiGeofencesBatch::create(count, adapterResponseData);
+    for (size_t i = 0; i < count; i++) {
+        removeGeofence(hwIds[i], clientIds[i], new LocApiResponse(*mContext,
+                [batch, i] (LocationError err) { batch->done(i, err); }));
+    }
+}
+
+void LocApiBase::pauseGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+        LocApiResponseData<LocApiGeofencesData>* adapterResponseData)
+{
+    std::shared_ptr<LocApiGeofencesBatch> batch =
+            LocApiGeofencesBatch::create(count, adapterResponseData);
+    for (size_t i = 0; i < count; i++) {
+        pauseGeofence(hwIds[i], clientIds[i], new LocApiResponse(*mContext,
+                [batch, i] (LocationError err) { batch->done(i, err); }));
+    }
+}
+
+void LocApiBase::resumeGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+        LocApiResponseData<LocApiGeofencesData>* adapterResponseData)
+{
+    std::shared_ptr<LocApiGeofencesBatch> batch =
+            LocApiGeofencesBatch::create(count, adapterResponseData);
+    for (size_t i = 0; i < count; i++) {
+        resumeGeofence(hwIds[i], clientIds[i], new LocApiResponse(*mContext,
+                [batch, i] (LocationError err) { batch->done(i, err); }));
+    }
+}
+
+void LocApiBase::modifyGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+        const GeofenceOption* options,
+        LocApiResponseData<LocApiGeofencesData>* adapterResponseData)
+{
+    std::shared_ptr<LocApiGeofencesBatch> batch =
+            LocApiGeofencesBatch::create(count, adapterResponseData);
+    for (size_t i = 0; i < count; i++) {
+        modifyGeofence(hwIds[i], clientIds[i], options[i], new LocApiResponse(*mContext,
+                [batch, i] (LocationError err) { batch->done(i, err); }));
+    }
+}
+
 void LocApiBase::startTimeBasedTracking(const TrackingOptions& /*options*/,
         LocApiResponse* /*adapterResponse*/)
 DEFAULT_IMPL()
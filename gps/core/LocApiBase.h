@@ -31,6 +31,7 @@
 
 #include <stddef.h>
 #include <ctype.h>
+#include <vector>
 #include <gps_extended.h>
 #include <LocationAPI.h>
 #include <MsgTask.h>
@@ -81,6 +82,13 @@ typedef struct
     uint32_t hwId;
 } LocApiGeofenceData;
 
+// per geofence results of a batched geofence request, in request order
+typedef struct
+{
+    std::vector<LocationError> errs;
+    std::vector<uint32_t> hwIds; // addGeofences() only
+} LocApiGeofencesData;
+
 struct LocApiMsg: LocMsg {
     private:
         std::function<void ()> mProcImpl;
@@ -318,6 +326,26 @@ public:
     void updateEvtMask();
     void updateNmeaMask(uint32_t mask);
 
+    /* Batched forms of the geofence calls above. Only the adapter side is
+       batched: the adapter queues one call and gets one response for the whole
+       command. They are not virtual, so that the vtable stays the one LocApi
+       implementations were built against, and the modem still gets one request
+       per geofence through the single calls. The arrays need to be valid only
+       for the duration of the call. adapterResponseData is returned once,
+       after the last single response, with the status of every geofence. */
+    void addGeofences(size_t count, const uint32_t* clientIds,
+            const GeofenceOption* options, const GeofenceInfo* infos,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData);
+    void removeGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData);
+    void pauseGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData);
+    void resumeGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData);
+    void modifyGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+            const GeofenceOption* options,
+            LocApiResponseData<LocApiGeofencesData>* adapterResponseData);
+
     virtual void updateSystemPowerState(PowerStateType systemPowerState);
     virtual void configRobustLocation(bool enable, bool enableForE911,
                                       LocApiResponse* adapterResponse=nullptr);
@@ -42,6 +42,10 @@ const MsgTask* LocContext::mMsgTask = NULL;
 ContextBase* LocContext::mContext = NULL;
 // the name must be shorter than 15 chars
 const char* LocContext::mLocationHalName = "Loc_hal_worker";
+// all adapters share the worker, back it with the lock-free ring msg_q
+// and let it drain bursts (SV + NMEA + position of one epoch) at once
+static const size_t LOC_HAL_WORKER_Q_SIZE = 512;
+static const uint32_t LOC_HAL_WORKER_BATCH_SIZE = 16;
 #ifndef USE_GLIB
 const char* LocContext::mLBSLibName = "liblbs_core.so";
 #else
@@ -54,7 +58,9 @@ const MsgTask* LocContext::getMsgTask(LocThread::tCreate tCreator,
                                           const char* name, bool joinable)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(tCreator, name, joinable);
+        MsgTask* msgTask = new MsgTask(tCreator, name, joinable, LOC_HAL_WORKER_Q_SIZE);
+        msgTask->setBatchDrain(LOC_HAL_WORKER_BATCH_SIZE);
+        mMsgTask = msgTask;
     }
     return mMsgTask;
 }
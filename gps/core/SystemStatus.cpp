@@ -32,8 +32,10 @@
 #include <string>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <sched.h>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <loc_nmea.h>
@@ -51,45 +53,182 @@ namespace loc_core
 class SystemStatusNmeaBase
 {
 protected:
-    std::vector<std::string> mField;
-
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    // fields are not copied out of the sentence, mFieldStart[i] is the offset of
+    // field i in mNmea and field i ends one character (the ',' or '*') before
+    // mFieldStart[i+1]
+    enum { MAX_FIELDS = 2 + SV_ALL_NUM*3 };
+    const char* mNmea;
+    uint32_t mFieldCount;
+    uint16_t mFieldStart[MAX_FIELDS + 1];
+
+    SystemStatusNmeaBase(const char *str_in, uint32_t len_in) :
+        mNmea(str_in),
+        mFieldCount(0)
     {
         // check size and talker
         if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
-        // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        // fields run up to the checksum field
+        uint32_t end = 0;
+        while ((end < len_in) && ('*' != str_in[end]) && ('\0' != str_in[end])) {
+            end++;
+        }
+        if ((end >= len_in) || ('*' != str_in[end])) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
+
+        // tokenize in place
+        mFieldStart[0] = 0;
+        for (uint32_t i = 0; (i <= end) && (mFieldCount < MAX_FIELDS); i++) {
+            if ((',' == str_in[i]) || (i == end)) {
+                mFieldStart[++mFieldCount] = i + 1;
             }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
         }
     }
 
     virtual ~SystemStatusNmeaBase() { }
 
+    inline const char* fieldBegin(uint32_t i) const { return mNmea + mFieldStart[i]; }
+    inline const char* fieldEnd(uint32_t i) const { return mNmea + mFieldStart[i+1] - 1; }
+
+    // numeric conversions follow atoi/atof/strtol/strtoull on the field text
+    // and stop at the first character that is not part of the number
+    int32_t toInt(uint32_t i) const;
+    uint64_t toUint64(uint32_t i) const;
+    uint64_t toHex(uint32_t i) const;
+    double toDouble(uint32_t i) const;
+
 public:
     static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
     static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
 };
 
+static const char* nmeaSkipSign(const char* first, const char* last, bool& negative)
+{
+    while ((first < last) && (' ' == *first || '\t' == *first)) {
+        first++;
+    }
+    negative = false;
+    if ((first < last) && ('-' == *first || '+' == *first)) {
+        negative = ('-' == *first);
+        first++;
+    }
+    return first;
+}
+
+static const char* nmeaParseDec(const char* first, const char* last, uint64_t& value)
+{
+    value = 0;
+    while ((first < last) && (*first >= '0') && (*first <= '9')) {
+        value = value * 10 + (*first - '0');
+        first++;
+    }
+    return first;
+}
+
+int32_t SystemStatusNmeaBase::toInt(uint32_t i) const
+{
+    bool negative;
+    uint64_t value;
+    nmeaParseDec(nmeaSkipSign(fieldBegin(i), fieldEnd(i), negative), fieldEnd(i), value);
+    return negative ? -(int32_t)value : (int32_t)value;
+}
+
+uint64_t SystemStatusNmeaBase::toUint64(uint32_t i) const
+{
+    bool negative;
+    uint64_t value;
+    nmeaParseDec(nmeaSkipSign(fieldBegin(i), fieldEnd(i), negative), fieldEnd(i), value);
+    return negative ? -value : value;
+}
+
+uint64_t SystemStatusNmeaBase::toHex(uint32_t i) const
+{
+    bool negative;
+    const char* last = fieldEnd(i);
+    const char* p = nmeaSkipSign(fieldBegin(i), last, negative);
+    if ((last - p > 2) && ('0' == p[0]) && ('x' == p[1] || 'X' == p[1]) && isxdigit(p[2])) {
+        p += 2;
+    }
+    uint64_t value = 0;
+    for (; p < last; p++) {
+        if (*p >= '0' && *p <= '9') {
+            value = (value << 4) | (*p - '0');
+        } else if (*p >= 'a' && *p <= 'f') {
+            value = (value << 4) | (*p - 'a' + 10);
+        } else if (*p >= 'A' && *p <= 'F') {
+            value = (value << 4) | (*p - 'A' + 10);
+        } else {
+            break;
+        }
+    }
+    return negative ? -value : value;
+}
+
+double SystemStatusNmeaBase::toDouble(uint32_t i) const
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char* first = fieldBegin(i);
+    const char* last = fieldEnd(i);
+    bool negative;
+    const char* p = nmeaSkipSign(first, last, negative);
+
+    // mantissa digits and decimal exponent
+    uint64_t mantissa = 0;
+    int32_t digits = 0;
+    int32_t exponent = 0;
+    bool seenDigit = false;
+    bool seenPoint = false;
+    for (; p < last; p++) {
+        if (*p >= '0' && *p <= '9') {
+            seenDigit = true;
+            if (0 != mantissa || '0' != *p) {
+                digits++;
+            }
+            mantissa = mantissa * 10 + (*p - '0');
+            if (seenPoint) {
+                exponent--;
+            }
+        } else if ('.' == *p && !seenPoint) {
+            seenPoint = true;
+        } else {
+            break;
+        }
+    }
+    if (seenDigit && (p + 1 < last) && ('e' == *p || 'E' == *p)) {
+        const char* q = p + 1;
+        bool expNegative = ('-' == *q);
+        if ('-' == *q || '+' == *q) {
+            q++;
+        }
+        if ((q < last) && (*q >= '0') && (*q <= '9')) {
+            uint64_t expValue;
+            p = nmeaParseDec(q, last, expValue);
+            expValue = std::min<uint64_t>(expValue, 1000);
+            exponent += expNegative ? -(int32_t)expValue : (int32_t)expValue;
+        }
+    }
+
+    // exact when the mantissa fits a double and the power of ten is exact,
+    // anything else (long mantissa, big exponent, inf, nan, hex) is left to strtod
+    if (seenDigit && (digits <= 15) && (exponent >= -22) && (exponent <= 22) &&
+        !((p < last) && ('x' == *p || 'X' == *p))) {
+        double value = (double)mantissa;
+        value = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+        return negative ? -value : value;
+    }
+
+    char buf[64];
+    size_t length = std::min<size_t>(last - first, sizeof(buf) - 1);
+    memcpy(buf, first, length);
+    buf[length] = '\0';
+    return strtod(buf, NULL);
+}
+
 /******************************************************************************
  SystemStatusPQWM1
 ******************************************************************************/
@@ -209,47 +348,47 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         memset(&mM1, 0, sizeof(mM1));
-        if (mField.size() <= eMax0) {
-            LOC_LOGE("PQWM1parser - invalid size=%zu", mField.size());
+        if (mFieldCount <= eMax0) {
+            LOC_LOGE("PQWM1parser - invalid size=%u", mFieldCount);
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+        mM1.mGpsWeek = toInt(eGpsWeek);
+        mM1.mGpsTowMs = toInt(eGpsTowMs);
+        mM1.mTimeValid = toInt(eTimeValid);
+        mM1.mTimeSource = toInt(eTimeSource);
+        mM1.mTimeUnc = toInt(eTimeUnc);
+        mM1.mClockFreqBias = toInt(eClockFreqBias);
+        mM1.mClockFreqBiasUnc = toInt(eClockFreqBiasUnc);
+        mM1.mXoState = toInt(eXoState);
+        mM1.mPgaGain = toInt(ePgaGain);
+        mM1.mGpsBpAmpI = toInt(eGpsBpAmpI);
+        mM1.mGpsBpAmpQ = toInt(eGpsBpAmpQ);
+        mM1.mAdcI = toInt(eAdcI);
+        mM1.mAdcQ = toInt(eAdcQ);
+        mM1.mJammerGps = toInt(eJammerGps);
+        mM1.mJammerGlo = toInt(eJammerGlo);
+        mM1.mJammerBds = toInt(eJammerBds);
+        mM1.mJammerGal = toInt(eJammerGal);
+        mM1.mRecErrorRecovery = toInt(eRecErrorRecovery);
+        mM1.mAgcGps = toDouble(eAgcGps);
+        mM1.mAgcGlo = toDouble(eAgcGlo);
+        mM1.mAgcBds = toDouble(eAgcBds);
+        mM1.mAgcGal = toDouble(eAgcGal);
+        if (mFieldCount > eLeapSecUnc) {
+            mM1.mLeapSeconds = toInt(eLeapSeconds);
+            mM1.mLeapSecUnc = toInt(eLeapSecUnc);
         }
-        if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+        if (mFieldCount > eGalBpAmpQ) {
+            mM1.mGloBpAmpI = toInt(eGloBpAmpI);
+            mM1.mGloBpAmpQ = toInt(eGloBpAmpQ);
+            mM1.mBdsBpAmpI = toInt(eBdsBpAmpI);
+            mM1.mBdsBpAmpQ = toInt(eBdsBpAmpQ);
+            mM1.mGalBpAmpI = toInt(eGalBpAmpI);
+            mM1.mGalBpAmpQ = toInt(eGalBpAmpQ);
         }
-        if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+        if (mFieldCount > eTimeUncNs) {
+            mM1.mTimeUncNs = toUint64(eTimeUncNs);
         }
     }
 
@@ -301,17 +440,17 @@ public:
     SystemStatusPQWP1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = toHex(eEpiValidity);
+        mP1.mEpiLat = toDouble(eEpiLat);
+        mP1.mEpiLon = toDouble(eEpiLon);
+        mP1.mEpiAlt = toDouble(eEpiAlt);
+        mP1.mEpiHepe = toInt(eEpiHepe);
+        mP1.mEpiAltUnc = toDouble(eEpiAltUnc);
+        mP1.mEpiSrc = toInt(eEpiSrc);
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -356,15 +495,15 @@ public:
     SystemStatusPQWP2parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = toDouble(eBestLat);
+        mP2.mBestLon = toDouble(eBestLon);
+        mP2.mBestAlt = toDouble(eBestAlt);
+        mP2.mBestHepe = toDouble(eBestHepe);
+        mP2.mBestAltUnc = toDouble(eBestAltUnc);
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -432,22 +571,22 @@ public:
     SystemStatusPQWP3parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = toHex(eXtraValidMask);
+        mP3.mGpsXtraAge = toInt(eGpsXtraAge);
+        mP3.mGloXtraAge = toInt(eGloXtraAge);
+        mP3.mBdsXtraAge = toInt(eBdsXtraAge);
+        mP3.mGalXtraAge = toInt(eGalXtraAge);
+        mP3.mQzssXtraAge = toInt(eQzssXtraAge);
+        mP3.mGpsXtraValid = toHex(eGpsXtraValid);
+        mP3.mGloXtraValid = toHex(eGloXtraValid);
+        mP3.mBdsXtraValid = toHex(eBdsXtraValid);
+        mP3.mGalXtraValid = toHex(eGalXtraValid);
+        mP3.mQzssXtraValid = toHex(eQzssXtraValid);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -492,15 +631,15 @@ public:
     SystemStatusPQWP4parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = toHex(eGpsEpheValid);
+        mP4.mGloEpheValid = toHex(eGloEpheValid);
+        mP4.mBdsEpheValid = toHex(eBdsEpheValid);
+        mP4.mGalEpheValid = toHex(eGalEpheValid);
+        mP4.mQzssEpheValid = toHex(eQzssEpheValid);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -582,26 +721,26 @@ public:
     SystemStatusPQWP5parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = toHex(eGpsUnknownMask);
+        mP5.mGloUnknownMask = toHex(eGloUnknownMask);
+        mP5.mBdsUnknownMask = toHex(eBdsUnknownMask);
+        mP5.mGalUnknownMask = toHex(eGalUnknownMask);
+        mP5.mQzssUnknownMask = toHex(eQzssUnknownMask);
+        mP5.mGpsGoodMask = toHex(eGpsGoodMask);
+        mP5.mGloGoodMask = toHex(eGloGoodMask);
+        mP5.mBdsGoodMask = toHex(eBdsGoodMask);
+        mP5.mGalGoodMask = toHex(eGalGoodMask);
+        mP5.mQzssGoodMask = toHex(eQzssGoodMask);
+        mP5.mGpsBadMask = toHex(eGpsBadMask);
+        mP5.mGloBadMask = toHex(eGloBadMask);
+        mP5.mBdsBadMask = toHex(eBdsBadMask);
+        mP5.mGalBadMask = toHex(eGalBadMask);
+        mP5.mQzssBadMask = toHex(eQzssBadMask);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -634,11 +773,11 @@ public:
     SystemStatusPQWP6parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = toHex(eFixInfoMask);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -670,20 +809,20 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         uint32_t svLimit = SV_ALL_NUM;
-        if (mField.size() < eMin) {
-            LOC_LOGE("PQWP7parser - invalid size=%zu", mField.size());
+        if (mFieldCount < eMin) {
+            LOC_LOGE("PQWP7parser - invalid size=%u", mFieldCount);
             return;
         }
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             // Try reducing limit, accounting for possibly missing NAVIC support
             svLimit = SV_ALL_NUM_MIN;
         }
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(toInt(i*3+2));
+            mP7.mNav[i].mSource = GnssEphemerisSource(toInt(i*3+3));
+            mP7.mNav[i].mAgeSec = toInt(i*3+4);
         }
     }
 
@@ -720,12 +859,12 @@ public:
     SystemStatusPQWS1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = toInt(eFixInfoMask);
+        mS1.mHepeLimit = toInt(eHepeLimit);
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1259,6 +1398,9 @@ void SystemStatusLocation::dump()
 /******************************************************************************
  SystemStatus
 ******************************************************************************/
+// lock free copies a reader tries before it locks the writers out
+#define SYSTEM_STATUS_READ_ATTEMPTS 3
+
 pthread_mutex_t   SystemStatus::mMutexSystemStatus = PTHREAD_MUTEX_INITIALIZER;
 SystemStatus*     SystemStatus::mInstance = NULL;
 
@@ -1293,7 +1435,8 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mSequence(0)
 {
     int result = 0;
     ENTRY_LOG ();
@@ -1343,45 +1486,116 @@ SystemStatus::SystemStatus(const MsgTask* msgTask) :
 /******************************************************************************
  SystemStatus - storing dataitems
 ******************************************************************************/
+void SystemStatus::beginUpdate()
+{
+    pthread_mutex_lock(&mMutexSystemStatus);
+    mSequence.store(mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SystemStatus::endUpdate()
+{
+    mSequence.store(mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    pthread_mutex_unlock(&mMutexSystemStatus);
+}
+
+uint32_t SystemStatus::beginRead(uint32_t attempt) const
+{
+    if (attempt >= SYSTEM_STATUS_READ_ATTEMPTS) {
+        // writers kept updating under the copy, copy with them locked out
+        pthread_mutex_lock(&mMutexSystemStatus);
+        return mSequence.load(std::memory_order_relaxed);
+    }
+    return mSequence.load(std::memory_order_acquire);
+}
+
+bool SystemStatus::endRead(uint32_t sequence, uint32_t attempt) const
+{
+    if (attempt >= SYSTEM_STATUS_READ_ATTEMPTS) {
+        pthread_mutex_unlock(&mMutexSystemStatus);
+        return true;
+    }
+    // true when no writer was updating while the reports were read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (0 == (sequence & 1)) && (mSequence.load(std::memory_order_relaxed) == sequence);
+}
+
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
 {
     if (s.ignore()) {
         return false;
     }
-    if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
+
+    std::lock_guard<std::mutex> lock(report.mLock);
+    typename TYPE_REPORT::History& history = report.mHistory;
+    if (!history.empty() &&
+        history.back().equals(static_cast<TYPE_ITEM&>(s.collate(history.back())))) {
         // there is no change - just update reported timestamp
-        report.back().mUtcReported = s.mUtcReported;
+        history.back().mUtcReported = s.mUtcReported;
         return false;
     }
 
-    // first event or updated
-    report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    // first event or updated, the history drops its oldest item when full
+    history.push_back(s);
     return true;
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
-    report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    std::lock_guard<std::mutex> lock(report.mLock);
+    report.mHistory.push_back(s);
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
-void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
+void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& report) const
 {
+    std::lock_guard<std::mutex> lock(report.mLock);
+    const typename TYPE_ITEM::History& c = report.mHistory;
     reportout.clear();
     if (c.size() >= 1) {
         reportout.push_back(c.back());
+    }
+}
+
+template <typename TYPE_REPORT>
+void SystemStatus::dumpIteminReport(TYPE_REPORT& reportout) const
+{
+    if (reportout.size() >= 1) {
         reportout.back().dump();
     }
 }
 
+template <typename TYPE_REPORT, typename TYPE_ITEM>
+void SystemStatus::getItemsinReport(TYPE_REPORT& reportout, const TYPE_ITEM& report,
+                                    bool selected, uint32_t maxItems, const timespec* since) const
+{
+    reportout.clear();
+    if (!selected) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(report.mLock);
+    const typename TYPE_ITEM::History& c = report.mHistory;
+
+    // walk back from the latest item to find the oldest one to copy
+    uint32_t first = c.size();
+    while ((first > 0) && (c.size() - first < maxItems)) {
+        const timespec& reported = c[first - 1].mUtcReported;
+        if ((nullptr != since) &&
+            ((reported.tv_sec < since->tv_sec) ||
+             ((reported.tv_sec == since->tv_sec) && (reported.tv_nsec < since->tv_nsec)))) {
+            break;
+        }
+        first--;
+    }
+
+    reportout.reserve(c.size() - first);
+    for (uint32_t i = first; i < c.size(); i++) {
+        reportout.push_back(c[i]);
+    }
+}
+
 /******************************************************************************
 @brief      API to set report data into internal buffer
 
@@ -1396,56 +1610,66 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
-    pthread_mutex_lock(&mMutexSystemStatus);
-
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
-    }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
-    }
-    else {
+    beginUpdate();
+
+    // parse the received nmea strings here, loc_nmea_is_debug has checked
+    // the "$PQW" prefix so the sentence tag is told apart by data[4..5]
+    switch (data[4]) {
+    case 'M':
+        if ('1' == data[5]) {
+            SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
+            setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
+            setIteminReport(mCache.mXoState, SystemStatusXoState(s));
+            setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
+            setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
+        }
+        break;
+    case 'P':
+        switch (data[5]) {
+        case '1':
+            setIteminReport(mCache.mInjectedPosition,
+                    SystemStatusInjectedPosition(SystemStatusPQWP1parser(data, len).get()));
+            break;
+        case '2':
+            setIteminReport(mCache.mBestPosition,
+                    SystemStatusBestPosition(SystemStatusPQWP2parser(data, len).get()));
+            break;
+        case '3':
+            setIteminReport(mCache.mXtra,
+                    SystemStatusXtra(SystemStatusPQWP3parser(data, len).get()));
+            break;
+        case '4':
+            setIteminReport(mCache.mEphemeris,
+                    SystemStatusEphemeris(SystemStatusPQWP4parser(data, len).get()));
+            break;
+        case '5':
+            setIteminReport(mCache.mSvHealth,
+                    SystemStatusSvHealth(SystemStatusPQWP5parser(data, len).get()));
+            break;
+        case '6':
+            setIteminReport(mCache.mPdr,
+                    SystemStatusPdr(SystemStatusPQWP6parser(data, len).get()));
+            break;
+        case '7':
+            setIteminReport(mCache.mNavData,
+                    SystemStatusNavData(SystemStatusPQWP7parser(data, len).get()));
+            break;
+        default:
+            break;
+        }
+        break;
+    case 'S':
+        if ('1' == data[5]) {
+            setIteminReport(mCache.mPositionFailure,
+                    SystemStatusPositionFailure(SystemStatusPQWS1parser(data, len).get()));
+        }
+        break;
+    default:
         // do nothing
+        break;
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    endUpdate();
     return true;
 }
 
@@ -1460,7 +1684,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
                                  const GpsLocationExtended& locationEx)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    beginUpdate();
 
     ret = setIteminReport(mCache.mLocation, SystemStatusLocation(location, locationEx));
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
@@ -1469,7 +1693,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
              location.gpsLocation.altitude,
              location.gpsLocation.speed);
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    endUpdate();
     return ret;
 }
 
@@ -1483,7 +1707,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
 bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    beginUpdate();
     switch(dataitem->getId())
     {
         case AIRPLANEMODE_DATA_ITEM_ID:
@@ -1577,7 +1801,7 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
         default:
             break;
     }
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    endUpdate();
     return ret;
 }
 
@@ -1591,9 +1815,17 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    if (!isLatestOnly) {
+        // copy entire reports and return them
+        return getReport(report, SYSTEM_STATUS_REPORT_ALL, SystemStatusItemBase::maxItem);
+    }
+
+    // a writer updating in the middle of the copy makes it start over
+    uint32_t attempt = 0;
+    uint32_t sequence;
+    do {
+        sequence = beginRead(attempt);
 
-    if (isLatestOnly) {
         // push back only the latest report and return it
         getIteminReport(report.mLocation, mCache.mLocation);
 
@@ -1634,53 +1866,142 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
         getIteminReport(report.mMccMnc, mCache.mMccMnc);
         getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail);
         getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
-    }
-    else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
-        report = mCache;
-    }
+    } while (!endRead(sequence, attempt++));
+
+    dumpIteminReport(report.mLocation);
+
+    dumpIteminReport(report.mTimeAndClock);
+    dumpIteminReport(report.mXoState);
+    dumpIteminReport(report.mRfAndParams);
+    dumpIteminReport(report.mErrRecovery);
+
+    dumpIteminReport(report.mInjectedPosition);
+    dumpIteminReport(report.mBestPosition);
+    dumpIteminReport(report.mXtra);
+    dumpIteminReport(report.mEphemeris);
+    dumpIteminReport(report.mSvHealth);
+    dumpIteminReport(report.mPdr);
+    dumpIteminReport(report.mNavData);
+
+    dumpIteminReport(report.mPositionFailure);
+
+    dumpIteminReport(report.mAirplaneMode);
+    dumpIteminReport(report.mENH);
+    dumpIteminReport(report.mGPSState);
+    dumpIteminReport(report.mNLPStatus);
+    dumpIteminReport(report.mWifiHardwareState);
+    dumpIteminReport(report.mNetworkInfo);
+    dumpIteminReport(report.mRilServiceInfo);
+    dumpIteminReport(report.mRilCellInfo);
+    dumpIteminReport(report.mServiceStatus);
+    dumpIteminReport(report.mModel);
+    dumpIteminReport(report.mManufacturer);
+    dumpIteminReport(report.mAssistedGps);
+    dumpIteminReport(report.mScreenState);
+    dumpIteminReport(report.mPowerConnectState);
+    dumpIteminReport(report.mTimeZoneChange);
+    dumpIteminReport(report.mTimeChange);
+    dumpIteminReport(report.mWifiSupplicantStatus);
+    dumpIteminReport(report.mShutdownState);
+    dumpIteminReport(report.mTac);
+    dumpIteminReport(report.mMccMnc);
+    dumpIteminReport(report.mBtDeviceScanDetail);
+    dumpIteminReport(report.mBtLeDeviceScanDetail);
+
+    return true;
+}
+
+/******************************************************************************
+@brief      API to get a snapshot of selected reports
+
+@param[In]  reports    reports to fill, the ones not selected are left empty
+@param[In]  reportMask SYSTEM_STATUS_REPORT_*_BIT of the reports to copy
+@param[In]  maxItems   copy at most this many latest items of each report
+@param[In]  since      when not NULL, copy only the items reported at or after it
+
+@return     true when successfully done
+******************************************************************************/
+bool SystemStatus::getReport(SystemStatusReports& report, SystemStatusReportMask reportMask,
+                             uint32_t maxItems, const timespec* since) const
+{
+    // a writer updating in the middle of the copy makes it start over
+    uint32_t attempt = 0;
+    uint32_t sequence;
+    do {
+        sequence = beginRead(attempt);
+
+        getItemsinReport(report.mLocation, mCache.mLocation,
+                         reportMask & SYSTEM_STATUS_REPORT_LOCATION_BIT, maxItems, since);
+        getItemsinReport(report.mTimeAndClock, mCache.mTimeAndClock,
+                         reportMask & SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT, maxItems, since);
+        getItemsinReport(report.mXoState, mCache.mXoState,
+                         reportMask & SYSTEM_STATUS_REPORT_XO_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mRfAndParams, mCache.mRfAndParams,
+                         reportMask & SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT, maxItems, since);
+        getItemsinReport(report.mErrRecovery, mCache.mErrRecovery,
+                         reportMask & SYSTEM_STATUS_REPORT_ERR_RECOVERY_BIT, maxItems, since);
+        getItemsinReport(report.mInjectedPosition, mCache.mInjectedPosition,
+                         reportMask & SYSTEM_STATUS_REPORT_INJECTED_POSITION_BIT, maxItems, since);
+        getItemsinReport(report.mBestPosition, mCache.mBestPosition,
+                         reportMask & SYSTEM_STATUS_REPORT_BEST_POSITION_BIT, maxItems, since);
+        getItemsinReport(report.mXtra, mCache.mXtra,
+                         reportMask & SYSTEM_STATUS_REPORT_XTRA_BIT, maxItems, since);
+        getItemsinReport(report.mEphemeris, mCache.mEphemeris,
+                         reportMask & SYSTEM_STATUS_REPORT_EPHEMERIS_BIT, maxItems, since);
+        getItemsinReport(report.mSvHealth, mCache.mSvHealth,
+                         reportMask & SYSTEM_STATUS_REPORT_SV_HEALTH_BIT, maxItems, since);
+        getItemsinReport(report.mPdr, mCache.mPdr,
+                         reportMask & SYSTEM_STATUS_REPORT_PDR_BIT, maxItems, since);
+        getItemsinReport(report.mNavData, mCache.mNavData,
+                         reportMask & SYSTEM_STATUS_REPORT_NAV_DATA_BIT, maxItems, since);
+        getItemsinReport(report.mPositionFailure, mCache.mPositionFailure,
+                         reportMask & SYSTEM_STATUS_REPORT_POSITION_FAILURE_BIT, maxItems, since);
+        getItemsinReport(report.mAirplaneMode, mCache.mAirplaneMode,
+                         reportMask & SYSTEM_STATUS_REPORT_AIRPLANE_MODE_BIT, maxItems, since);
+        getItemsinReport(report.mENH, mCache.mENH,
+                         reportMask & SYSTEM_STATUS_REPORT_ENH_BIT, maxItems, since);
+        getItemsinReport(report.mGPSState, mCache.mGPSState,
+                         reportMask & SYSTEM_STATUS_REPORT_GPS_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mNLPStatus, mCache.mNLPStatus,
+                         reportMask & SYSTEM_STATUS_REPORT_NLP_STATUS_BIT, maxItems, since);
+        getItemsinReport(report.mWifiHardwareState, mCache.mWifiHardwareState,
+                         reportMask & SYSTEM_STATUS_REPORT_WIFI_HARDWARE_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mNetworkInfo, mCache.mNetworkInfo,
+                         reportMask & SYSTEM_STATUS_REPORT_NETWORK_INFO_BIT, maxItems, since);
+        getItemsinReport(report.mRilServiceInfo, mCache.mRilServiceInfo,
+                         reportMask & SYSTEM_STATUS_REPORT_RIL_SERVICE_INFO_BIT, maxItems, since);
+        getItemsinReport(report.mRilCellInfo, mCache.mRilCellInfo,
+                         reportMask & SYSTEM_STATUS_REPORT_RIL_CELL_INFO_BIT, maxItems, since);
+        getItemsinReport(report.mServiceStatus, mCache.mServiceStatus,
+                         reportMask & SYSTEM_STATUS_REPORT_SERVICE_STATUS_BIT, maxItems, since);
+        getItemsinReport(report.mModel, mCache.mModel,
+                         reportMask & SYSTEM_STATUS_REPORT_MODEL_BIT, maxItems, since);
+        getItemsinReport(report.mManufacturer, mCache.mManufacturer,
+                         reportMask & SYSTEM_STATUS_REPORT_MANUFACTURER_BIT, maxItems, since);
+        getItemsinReport(report.mAssistedGps, mCache.mAssistedGps,
+                         reportMask & SYSTEM_STATUS_REPORT_ASSISTED_GPS_BIT, maxItems, since);
+        getItemsinReport(report.mScreenState, mCache.mScreenState,
+                         reportMask & SYSTEM_STATUS_REPORT_SCREEN_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mPowerConnectState, mCache.mPowerConnectState,
+                         reportMask & SYSTEM_STATUS_REPORT_POWER_CONNECT_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mTimeZoneChange, mCache.mTimeZoneChange,
+                         reportMask & SYSTEM_STATUS_REPORT_TIME_ZONE_CHANGE_BIT, maxItems, since);
+        getItemsinReport(report.mTimeChange, mCache.mTimeChange,
+                         reportMask & SYSTEM_STATUS_REPORT_TIME_CHANGE_BIT, maxItems, since);
+        getItemsinReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus,
+                         reportMask & SYSTEM_STATUS_REPORT_WIFI_SUPPLICANT_STATUS_BIT, maxItems, since);
+        getItemsinReport(report.mShutdownState, mCache.mShutdownState,
+                         reportMask & SYSTEM_STATUS_REPORT_SHUTDOWN_STATE_BIT, maxItems, since);
+        getItemsinReport(report.mTac, mCache.mTac,
+                         reportMask & SYSTEM_STATUS_REPORT_TAC_BIT, maxItems, since);
+        getItemsinReport(report.mMccMnc, mCache.mMccMnc,
+                         reportMask & SYSTEM_STATUS_REPORT_MCC_MNC_BIT, maxItems, since);
+        getItemsinReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail,
+                         reportMask & SYSTEM_STATUS_REPORT_BT_DEVICE_SCAN_DETAIL_BIT, maxItems, since);
+        getItemsinReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail,
+                         reportMask & SYSTEM_STATUS_REPORT_BT_LE_DEVICE_SCAN_DETAIL_BIT, maxItems, since);
+    } while (!endRead(sequence, attempt++));
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
 
@@ -1693,7 +2014,7 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
 ******************************************************************************/
 bool SystemStatus::setDefaultGnssEngineStates(void)
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    beginUpdate();
 
     setDefaultIteminReport(mCache.mLocation, SystemStatusLocation());
 
@@ -1712,7 +2033,7 @@ bool SystemStatus::setDefaultGnssEngineStates(void)
 
     setDefaultIteminReport(mCache.mPositionFailure, SystemStatusPositionFailure());
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    endUpdate();
     return true;
 }
 
@@ -32,6 +32,8 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include <algorithm>
 #include <iterator>
 #include <loc_pla.h>
@@ -816,58 +818,163 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory - fixed capacity history of a report, when full the
+ oldest item is dropped to make room for the new one
+******************************************************************************/
+template <typename TYPE_ITEM>
+class SystemStatusHistory
+{
+private:
+    TYPE_ITEM mItems[SystemStatusItemBase::maxItem];
+    uint32_t  mFirst;
+    uint32_t  mCount;
+
+public:
+    inline SystemStatusHistory() : mFirst(0), mCount(0) {}
+    inline bool empty() const { return (0 == mCount); }
+    inline uint32_t size() const { return mCount; }
+    inline void clear() { mFirst = 0; mCount = 0; }
+    // index 0 is the oldest item
+    inline TYPE_ITEM& operator[](uint32_t i) {
+        return mItems[(mFirst + i) % SystemStatusItemBase::maxItem];
+    }
+    inline const TYPE_ITEM& operator[](uint32_t i) const {
+        return mItems[(mFirst + i) % SystemStatusItemBase::maxItem];
+    }
+    inline TYPE_ITEM& back() { return (*this)[mCount - 1]; }
+    inline const TYPE_ITEM& back() const { return (*this)[mCount - 1]; }
+    inline void push_back(const TYPE_ITEM& item) {
+        if (mCount < SystemStatusItemBase::maxItem) {
+            mCount++;
+        } else {
+            mFirst = (mFirst + 1) % SystemStatusItemBase::maxItem;
+        }
+        back() = item;
+    }
+};
+
+/******************************************************************************
+ SystemStatusLockedHistory - history of a report with a lock of its own. The
+ writer updates the history in place and readers copy out of it, each holding
+ the lock of just this one report while doing so
+******************************************************************************/
+template <typename TYPE_ITEM>
+class SystemStatusLockedHistory
+{
+public:
+    typedef SystemStatusHistory<TYPE_ITEM> History;
+
+    mutable std::mutex mLock;
+    History mHistory;
+
+    inline void clear() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mHistory.clear();
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
-class SystemStatusReports
+template <template <typename> class TYPE_CONTAINER>
+class SystemStatusReportsBase
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    TYPE_CONTAINER<SystemStatusLocation>      mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    TYPE_CONTAINER<SystemStatusTimeAndClock>  mTimeAndClock;
+    TYPE_CONTAINER<SystemStatusXoState>       mXoState;
+    TYPE_CONTAINER<SystemStatusRfAndParams>   mRfAndParams;
+    TYPE_CONTAINER<SystemStatusErrRecovery>   mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    TYPE_CONTAINER<SystemStatusInjectedPosition> mInjectedPosition;
+    TYPE_CONTAINER<SystemStatusBestPosition>  mBestPosition;
+    TYPE_CONTAINER<SystemStatusXtra>          mXtra;
+    TYPE_CONTAINER<SystemStatusEphemeris>     mEphemeris;
+    TYPE_CONTAINER<SystemStatusSvHealth>      mSvHealth;
+    TYPE_CONTAINER<SystemStatusPdr>           mPdr;
+    TYPE_CONTAINER<SystemStatusNavData>       mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    TYPE_CONTAINER<SystemStatusPositionFailure> mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    TYPE_CONTAINER<SystemStatusAirplaneMode>  mAirplaneMode;
+    TYPE_CONTAINER<SystemStatusENH>           mENH;
+    TYPE_CONTAINER<SystemStatusGpsState>      mGPSState;
+    TYPE_CONTAINER<SystemStatusNLPStatus>     mNLPStatus;
+    TYPE_CONTAINER<SystemStatusWifiHardwareState> mWifiHardwareState;
+    TYPE_CONTAINER<SystemStatusNetworkInfo>   mNetworkInfo;
+    TYPE_CONTAINER<SystemStatusServiceInfo>   mRilServiceInfo;
+    TYPE_CONTAINER<SystemStatusRilCellInfo>   mRilCellInfo;
+    TYPE_CONTAINER<SystemStatusServiceStatus> mServiceStatus;
+    TYPE_CONTAINER<SystemStatusModel>         mModel;
+    TYPE_CONTAINER<SystemStatusManufacturer>  mManufacturer;
+    TYPE_CONTAINER<SystemStatusAssistedGps>   mAssistedGps;
+    TYPE_CONTAINER<SystemStatusScreenState>   mScreenState;
+    TYPE_CONTAINER<SystemStatusPowerConnectState> mPowerConnectState;
+    TYPE_CONTAINER<SystemStatusTimeZoneChange> mTimeZoneChange;
+    TYPE_CONTAINER<SystemStatusTimeChange>    mTimeChange;
+    TYPE_CONTAINER<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    TYPE_CONTAINER<SystemStatusShutdownState> mShutdownState;
+    TYPE_CONTAINER<SystemStatusTac>           mTac;
+    TYPE_CONTAINER<SystemStatusMccMnc>        mMccMnc;
+    TYPE_CONTAINER<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    TYPE_CONTAINER<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
 };
 
+template <typename TYPE_ITEM>
+using SystemStatusVector = std::vector<TYPE_ITEM>;
+
+// reports handed out by SystemStatus::getReport
+class SystemStatusReports : public SystemStatusReportsBase<SystemStatusVector> {};
+
+// reports kept by SystemStatus
+class SystemStatusReportsHistory : public SystemStatusReportsBase<SystemStatusLockedHistory> {};
+
+/* Select reports for SystemStatus::getReport */
+typedef uint64_t SystemStatusReportMask;
+#define SYSTEM_STATUS_REPORT_LOCATION_BIT                      (1ULL << 0)
+#define SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT                (1ULL << 1)
+#define SYSTEM_STATUS_REPORT_XO_STATE_BIT                      (1ULL << 2)
+#define SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT                 (1ULL << 3)
+#define SYSTEM_STATUS_REPORT_ERR_RECOVERY_BIT                  (1ULL << 4)
+#define SYSTEM_STATUS_REPORT_INJECTED_POSITION_BIT             (1ULL << 5)
+#define SYSTEM_STATUS_REPORT_BEST_POSITION_BIT                 (1ULL << 6)
+#define SYSTEM_STATUS_REPORT_XTRA_BIT                          (1ULL << 7)
+#define SYSTEM_STATUS_REPORT_EPHEMERIS_BIT                     (1ULL << 8)
+#define SYSTEM_STATUS_REPORT_SV_HEALTH_BIT                     (1ULL << 9)
+#define SYSTEM_STATUS_REPORT_PDR_BIT                           (1ULL << 10)
+#define SYSTEM_STATUS_REPORT_NAV_DATA_BIT                      (1ULL << 11)
+#define SYSTEM_STATUS_REPORT_POSITION_FAILURE_BIT              (1ULL << 12)
+#define SYSTEM_STATUS_REPORT_AIRPLANE_MODE_BIT                 (1ULL << 13)
+#define SYSTEM_STATUS_REPORT_ENH_BIT                           (1ULL << 14)
+#define SYSTEM_STATUS_REPORT_GPS_STATE_BIT                     (1ULL << 15)
+#define SYSTEM_STATUS_REPORT_NLP_STATUS_BIT                    (1ULL << 16)
+#define SYSTEM_STATUS_REPORT_WIFI_HARDWARE_STATE_BIT           (1ULL << 17)
+#define SYSTEM_STATUS_REPORT_NETWORK_INFO_BIT                  (1ULL << 18)
+#define SYSTEM_STATUS_REPORT_RIL_SERVICE_INFO_BIT              (1ULL << 19)
+#define SYSTEM_STATUS_REPORT_RIL_CELL_INFO_BIT                 (1ULL << 20)
+#define SYSTEM_STATUS_REPORT_SERVICE_STATUS_BIT                (1ULL << 21)
+#define SYSTEM_STATUS_REPORT_MODEL_BIT                         (1ULL << 22)
+#define SYSTEM_STATUS_REPORT_MANUFACTURER_BIT                  (1ULL << 23)
+#define SYSTEM_STATUS_REPORT_ASSISTED_GPS_BIT                  (1ULL << 24)
+#define SYSTEM_STATUS_REPORT_SCREEN_STATE_BIT                  (1ULL << 25)
+#define SYSTEM_STATUS_REPORT_POWER_CONNECT_STATE_BIT           (1ULL << 26)
+#define SYSTEM_STATUS_REPORT_TIME_ZONE_CHANGE_BIT              (1ULL << 27)
+#define SYSTEM_STATUS_REPORT_TIME_CHANGE_BIT                   (1ULL << 28)
+#define SYSTEM_STATUS_REPORT_WIFI_SUPPLICANT_STATUS_BIT        (1ULL << 29)
+#define SYSTEM_STATUS_REPORT_SHUTDOWN_STATE_BIT                (1ULL << 30)
+#define SYSTEM_STATUS_REPORT_TAC_BIT                           (1ULL << 31)
+#define SYSTEM_STATUS_REPORT_MCC_MNC_BIT                       (1ULL << 32)
+#define SYSTEM_STATUS_REPORT_BT_DEVICE_SCAN_DETAIL_BIT         (1ULL << 33)
+#define SYSTEM_STATUS_REPORT_BT_LE_DEVICE_SCAN_DETAIL_BIT      (1ULL << 34)
+#define SYSTEM_STATUS_REPORT_ALL                               (~0ULL)
+
 /******************************************************************************
  SystemStatus
 ******************************************************************************/
@@ -882,8 +989,17 @@ private:
     inline ~SystemStatus() {}
 
     // Data members
+    // writers serialize on mMutexSystemStatus and make mSequence odd while they
+    // update, readers take only the lock of each report they copy and retry
+    // when mSequence changed under them, see beginRead()
     static pthread_mutex_t                    mMutexSystemStatus;
-    SystemStatusReports mCache;
+    std::atomic<uint32_t>                     mSequence;
+    SystemStatusReportsHistory mCache;
+
+    void beginUpdate();
+    void endUpdate();
+    uint32_t beginRead(uint32_t attempt) const;
+    bool endRead(uint32_t sequence, uint32_t attempt) const;
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
@@ -895,6 +1011,13 @@ private:
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const;
 
+    template <typename TYPE_REPORT>
+    void dumpIteminReport(TYPE_REPORT& reportout) const;
+
+    template <typename TYPE_REPORT, typename TYPE_ITEM>
+    void getItemsinReport(TYPE_REPORT& reportout, const TYPE_ITEM& c, bool selected,
+                          uint32_t maxItems, const timespec* since) const;
+
 public:
     // Static methods
     static SystemStatus* getInstance(const MsgTask* msgTask);
@@ -906,6 +1029,10 @@ public:
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
     bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    // copy only the selected reports, at most maxItems latest items of each
+    // and if since is given only the items still reported at or after it
+    bool getReport(SystemStatusReports& reports, SystemStatusReportMask reportMask,
+                   uint32_t maxItems, const timespec* since = nullptr) const;
     bool setDefaultGnssEngineStates(void);
     bool eventConnectionStatus(bool connected, int8_t type,
                                bool roaming, NetworkHandle networkHandle);
@@ -0,0 +1,218 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Measures what one geofence add command of <count> geofences costs between
+// the adapter and LocApi, with a mock LocApi whose modem takes <us> per
+// request:
+//     loc_api_geofence_bench [<count> [<us> ...]]
+// "per geofence" is how GeofenceAdapter used to queue the command: one
+// addToCallQueue() and one addGeofence() per geofence. "batched" is one
+// addToCallQueue() and one LocApiBase::addGeofences(). Reported per case are
+// the modem requests, the messages posted to the LocApi thread, the
+// responses LocApi returned to the adapter thread, the reports the caller
+// got, and the time until the command was answered.
+
+#include "LocApiBase.h"
+#include "ContextBase.h"
+#include <MsgTask.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace loc_core;
+
+// LocApi whose calls are posted to the LocApi thread like LocApiV02's, where
+// each geofence call blocks for the modem round trip
+class MockLocApi : public LocApiBase {
+public:
+    atomic<uint32_t> mModemRequests;
+    atomic<uint32_t> mApiMsgs;
+    atomic<uint32_t> mResponses;
+    useconds_t mRoundTripUs;
+    uint32_t mNextHwId;
+
+    inline MockLocApi(ContextBase* context) :
+        LocApiBase(0, context), mModemRequests(0), mApiMsgs(0), mResponses(0),
+        mRoundTripUs(0), mNextHwId(1) {}
+
+    inline void reset(useconds_t roundTripUs) {
+        mModemRequests = 0;
+        mApiMsgs = 0;
+        mResponses = 0;
+        mRoundTripUs = roundTripUs;
+    }
+
+    virtual void addToCallQueue(LocApiResponse* adapterResponse) override {
+        mApiMsgs++;
+        sendMsg(new LocApiMsg([this, adapterResponse] () {
+            mResponses++;
+            adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+        }));
+    }
+
+    virtual void addGeofence(uint32_t /*clientId*/, const GeofenceOption& /*options*/,
+            const GeofenceInfo& /*info*/,
+            LocApiResponseData<LocApiGeofenceData>* adapterResponseData) override {
+        mApiMsgs++;
+        sendMsg(new LocApiMsg([this, adapterResponseData] () {
+            mModemRequests++;
+            if (mRoundTripUs > 0) {
+                usleep(mRoundTripUs);
+            }
+            LocApiGeofenceData data = {mNextHwId++};
+            mResponses++;
+            adapterResponseData->returnToSender(LOCATION_ERROR_SUCCESS, data);
+        }));
+    }
+};
+
+// Answered once the caller got all its reports
+struct Command {
+    mutex mLock;
+    condition_variable mCond;
+    uint32_t mPending;
+    uint32_t mReports;
+    inline Command(uint32_t pending) : mPending(pending), mReports(0) {}
+    inline void report(uint32_t geofences) {
+        lock_guard<mutex> guard(mLock);
+        mReports++;
+        mPending -= geofences;
+        if (0 == mPending) {
+            mCond.notify_one();
+        }
+    }
+    inline void wait() {
+        unique_lock<mutex> guard(mLock);
+        mCond.wait(guard, [this] { return 0 == mPending; });
+    }
+};
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void addPerGeofence(ContextBase& context, MockLocApi& api, size_t count,
+        const vector<uint32_t>& ids, const vector<GeofenceOption>& options,
+        const vector<GeofenceInfo>& infos, Command& command) {
+    for (size_t i = 0; i < count; i++) {
+        api.addToCallQueue(new LocApiResponse(context,
+                [&context, &api, &ids, &options, &infos, &command, i] (LocationError /*err*/) {
+            api.addGeofence(ids[i], options[i], infos[i],
+                    new LocApiResponseData<LocApiGeofenceData>(context,
+                    [&command] (LocationError /*err*/, LocApiGeofenceData /*data*/) {
+                command.report(1);
+            }));
+        }));
+    }
+}
+
+static void addBatched(ContextBase& context, MockLocApi& api, size_t count,
+        const vector<uint32_t>& ids, const vector<GeofenceOption>& options,
+        const vector<GeofenceInfo>& infos, Command& command) {
+    api.addToCallQueue(new LocApiResponse(context,
+            [&context, &api, &ids, &options, &infos, &command, count] (LocationError /*err*/) {
+        api.addGeofences(count, ids.data(), options.data(), infos.data(),
+                new LocApiResponseData<LocApiGeofencesData>(context,
+                [&command, count] (LocationError /*err*/, LocApiGeofencesData /*data*/) {
+            command.report(count);
+        }));
+    }));
+}
+
+typedef void (addCommand_t)(ContextBase& context, MockLocApi& api, size_t count,
+        const vector<uint32_t>& ids, const vector<GeofenceOption>& options,
+        const vector<GeofenceInfo>& infos, Command& command);
+
+static void run(const char* name, addCommand_t* addCommand, ContextBase& context,
+        MockLocApi& api, size_t count, useconds_t roundTripUs) {
+    vector<uint32_t> ids(count);
+    vector<GeofenceOption> options(count);
+    vector<GeofenceInfo> infos(count);
+    for (size_t i = 0; i < count; i++) {
+        ids[i] = i + 1;
+        options[i].size = sizeof(GeofenceOption);
+        options[i].breachTypeMask = GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT;
+        options[i].responsiveness = 10000;
+        options[i].dwellTime = 0;
+        infos[i].size = sizeof(GeofenceInfo);
+        infos[i].latitude = 37.0 + i * 1e-4;
+        infos[i].longitude = -122.0;
+        infos[i].radius = 100.0;
+    }
+    api.reset(roundTripUs);
+    Command command(count);
+    double start = nowUs();
+    // the adapter posts its commands from its own thread
+    context.sendMsg(new LocApiMsg([&] () {
+        addCommand(context, api, count, ids, options, infos, command);
+    }));
+    command.wait();
+    double elapsed = nowUs() - start;
+    printf("%-13s %5u us/req %6u modem reqs %6u api msgs %6u responses %5u reports %9.2f ms\n",
+           name, (uint32_t)roundTripUs, api.mModemRequests.load(), api.mApiMsgs.load(),
+           api.mResponses.load(), command.mReports, elapsed / 1000);
+}
+
+int main(int argc, char** argv) {
+    size_t count = 1000;
+    vector<useconds_t> roundTrips;
+    if (argc > 1) {
+        count = strtoul(argv[1], nullptr, 0);
+        if (0 == count) {
+            fprintf(stderr, "usage: %s [<count> [<us> ...]]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (int i = 2; i < argc; i++) {
+        roundTrips.push_back(strtoul(argv[i], nullptr, 0));
+    }
+    if (roundTrips.empty()) {
+        roundTrips = {0, 100};
+    }
+
+    MsgTask* adapterMsgTask = new MsgTask("GeofenceBenchAdapter");
+    ContextBase context(adapterMsgTask, 0, nullptr);
+    MockLocApi* api = new MockLocApi(&context);
+
+    for (useconds_t roundTripUs : roundTrips) {
+        run("per geofence", addPerGeofence, context, *api, count, roundTripUs);
+        run("batched", addBatched, context, *api, count, roundTripUs);
+    }
+    // the threads are left for the process exit to reclaim, as the daemons do
+    fflush(stdout);
+    _exit(0);
+}
@@ -0,0 +1,314 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Checks and times SystemStatus::setNmeaString() on the $PQW debug NMEA
+// sentences of the engine:
+//     system_status_bench [<sentences>]
+// A fixed set of pseudo random M1, P1-P7 and S1 sentences, the same on every
+// build and machine, is parsed, and the fields of the latest reports are
+// hashed into a digest after each one. The digest is compared with the one
+// the parsers of the original tree produced for these sentences. Reported
+// is the cost of one second of M1, P1-P6 and S1 sentences and of one PQWP7.
+// This file also builds against the original SystemStatus.h.
+
+#include "SystemStatus.h"
+#include <loc_nmea.h>
+#include <MsgTask.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace loc_core;
+
+// digest of 200000 sentences, as produced by the original parsers
+#define BASELINE_SENTENCES 200000
+#define BASELINE_DIGEST 0x196c072b297bf11bULL
+#define TIMED_ROUNDS 20000
+
+// xorshift64*, so the sentences do not depend on the C++ library
+static uint64_t sRandom = 7;
+static uint64_t nextRandom() {
+    sRandom ^= sRandom >> 12;
+    sRandom ^= sRandom << 25;
+    sRandom ^= sRandom >> 27;
+    return sRandom * 0x2545F4914F6CDD1DULL;
+}
+
+static double randomDouble() {
+    return (double)(int64_t)nextRandom();
+}
+
+// A field the engine could send, or a malformed one. Integers stay in the
+// range of their target fields, where atoi and strtol did not clamp.
+static string randomField() {
+    static const char* sOddFields[] = {
+        " 12", "-0", "+5", "1e5", "1.5e", "3E-2x", ".5", "5.", "-.", "abc", "1.2.3",
+        "nan", "inf", "0x", "0xG", "1e400", "1e-400", "0.000000000000000000000000001"};
+    char field[64];
+    switch (nextRandom() % 12) {
+    case 0:
+        return "";
+    case 1:
+        snprintf(field, sizeof(field), "%" PRId64, (int64_t)(nextRandom() % 2000000) - 1000000);
+        break;
+    case 2:
+        snprintf(field, sizeof(field), "%.6f", randomDouble() / 1e19);
+        break;
+    case 3:
+        snprintf(field, sizeof(field), "%.2f", (double)(nextRandom() % 100000) / 7.0);
+        break;
+    case 4:
+        snprintf(field, sizeof(field), "%g", randomDouble() / 1e19);
+        break;
+    case 5:
+        snprintf(field, sizeof(field), "%.17g", randomDouble() / 1e19);
+        break;
+    case 6:
+        snprintf(field, sizeof(field), "%" PRIX64, nextRandom() >> (1 + nextRandom() % 63));
+        break;
+    case 7:
+        snprintf(field, sizeof(field), "0x%" PRIx64, nextRandom() >> (1 + nextRandom() % 63));
+        break;
+    case 8:
+        snprintf(field, sizeof(field), "%" PRIu64, nextRandom() >> (33 + nextRandom() % 31));
+        break;
+    case 9:
+        return sOddFields[nextRandom() % (sizeof(sOddFields) / sizeof(sOddFields[0]))];
+    default:
+        snprintf(field, sizeof(field), "%u", (unsigned)(nextRandom() % 5000));
+        break;
+    }
+    return field;
+}
+
+static const char* sTags[] = {
+    "$PQWM1", "$PQWP1", "$PQWP2", "$PQWP3", "$PQWP4", "$PQWP5", "$PQWP6", "$PQWP7", "$PQWS1"};
+static const int sFieldCounts[] = {31, 7, 5, 11, 5, 15, 1, SV_ALL_NUM * 3, 2};
+
+// a sentence with a few fields too many now and then. None has too few
+// fields or lacks the checksum: the parsers leave the report uninitialized
+// then, in the original tree too.
+static string randomSentence() {
+    int tag = nextRandom() % 9;
+    int fields = sFieldCounts[tag];
+    if (0 == nextRandom() % 8) {
+        fields += 2;
+    }
+    if (7 == tag && 0 != nextRandom() % 2) {
+        fields = SV_ALL_NUM_MIN * 3;
+    }
+    string sentence = sTags[tag];
+    if ('M' != sentence[5]) {
+        char utc[32];
+        snprintf(utc, sizeof(utc), ",%06u.00", (unsigned)(nextRandom() % 240000));
+        sentence += utc;
+    }
+    for (int i = 0; i < fields; i++) {
+        sentence += ",";
+        sentence += randomField();
+    }
+    sentence += "*5A\r\n";
+    return sentence;
+}
+
+// FNV-1a over the bytes of each field
+template <typename T>
+static void addToDigest(uint64_t& digest, const T& value) {
+    const unsigned char* bytes = (const unsigned char*)&value;
+    for (size_t i = 0; i < sizeof(value); i++) {
+        digest = (digest ^ bytes[i]) * 0x100000001b3ULL;
+    }
+}
+
+template <typename T, typename... FIELDS>
+static void addToDigest(uint64_t& digest, const T& value, const FIELDS&... fields) {
+    addToDigest(digest, value);
+    addToDigest(digest, fields...);
+}
+
+// the decoded fields of the latest debug NMEA reports, without their times
+static void addReportsToDigest(uint64_t& digest, const SystemStatusReports& reports) {
+    if (!reports.mTimeAndClock.empty()) {
+        const SystemStatusTimeAndClock& r = reports.mTimeAndClock.back();
+        addToDigest(digest, r.mGpsWeek, r.mGpsTowMs, r.mTimeValid, r.mTimeSource, r.mTimeUnc,
+                    r.mClockFreqBias, r.mClockFreqBiasUnc, r.mLeapSeconds, r.mLeapSecUnc,
+                    r.mTimeUncNs);
+    }
+    if (!reports.mXoState.empty()) {
+        addToDigest(digest, reports.mXoState.back().mXoState);
+    }
+    if (!reports.mRfAndParams.empty()) {
+        const SystemStatusRfAndParams& r = reports.mRfAndParams.back();
+        addToDigest(digest, r.mPgaGain, r.mGpsBpAmpI, r.mGpsBpAmpQ, r.mAdcI, r.mAdcQ,
+                    r.mJammerGps, r.mJammerGlo, r.mJammerBds, r.mJammerGal, r.mAgcGps,
+                    r.mAgcGlo, r.mAgcBds, r.mAgcGal, r.mGloBpAmpI, r.mGloBpAmpQ,
+                    r.mBdsBpAmpI, r.mBdsBpAmpQ, r.mGalBpAmpI, r.mGalBpAmpQ);
+    }
+    if (!reports.mErrRecovery.empty()) {
+        addToDigest(digest, reports.mErrRecovery.back().mRecErrorRecovery);
+    }
+    if (!reports.mInjectedPosition.empty()) {
+        const SystemStatusInjectedPosition& r = reports.mInjectedPosition.back();
+        addToDigest(digest, r.mEpiValidity, r.mEpiLat, r.mEpiLon, r.mEpiAlt, r.mEpiHepe,
+                    r.mEpiAltUnc, r.mEpiSrc);
+    }
+    if (!reports.mBestPosition.empty()) {
+        const SystemStatusBestPosition& r = reports.mBestPosition.back();
+        addToDigest(digest, r.mValid, r.mBestLat, r.mBestLon, r.mBestAlt, r.mBestHepe,
+                    r.mBestAltUnc);
+    }
+    if (!reports.mXtra.empty()) {
+        const SystemStatusXtra& r = reports.mXtra.back();
+        addToDigest(digest, r.mXtraValidMask, r.mGpsXtraAge, r.mGloXtraAge, r.mBdsXtraAge,
+                    r.mGalXtraAge, r.mQzssXtraAge, r.mNavicXtraAge, r.mGpsXtraValid,
+                    r.mGloXtraValid, r.mBdsXtraValid, r.mGalXtraValid, r.mQzssXtraValid,
+                    r.mNavicXtraValid);
+    }
+    if (!reports.mEphemeris.empty()) {
+        const SystemStatusEphemeris& r = reports.mEphemeris.back();
+        addToDigest(digest, r.mGpsEpheValid, r.mGloEpheValid, r.mBdsEpheValid,
+                    r.mGalEpheValid, r.mQzssEpheValid);
+    }
+    if (!reports.mSvHealth.empty()) {
+        const SystemStatusSvHealth& r = reports.mSvHealth.back();
+        addToDigest(digest, r.mGpsUnknownMask, r.mGloUnknownMask, r.mBdsUnknownMask,
+                    r.mGalUnknownMask, r.mQzssUnknownMask, r.mNavicUnknownMask,
+                    r.mGpsGoodMask, r.mGloGoodMask, r.mBdsGoodMask, r.mGalGoodMask,
+                    r.mQzssGoodMask, r.mNavicGoodMask, r.mGpsBadMask, r.mGloBadMask,
+                    r.mBdsBadMask, r.mGalBadMask, r.mQzssBadMask, r.mNavicBadMask);
+    }
+    if (!reports.mPdr.empty()) {
+        addToDigest(digest, reports.mPdr.back().mFixInfoMask);
+    }
+    if (!reports.mNavData.empty()) {
+        const SystemStatusNavData& r = reports.mNavData.back();
+        for (uint32_t i = 0; i < SV_ALL_NUM; i++) {
+            addToDigest(digest, r.mNav[i].mType, r.mNav[i].mSource, r.mNav[i].mAgeSec);
+        }
+    }
+    if (!reports.mPositionFailure.empty()) {
+        const SystemStatusPositionFailure& r = reports.mPositionFailure.back();
+        addToDigest(digest, r.mFixInfoMask, r.mHepeLimit);
+    }
+}
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void setNmeaString(SystemStatus* systemStatus, const string& sentence) {
+    systemStatus->setNmeaString(sentence.c_str(), sentence.length());
+}
+
+int main(int argc, char** argv) {
+    int count = BASELINE_SENTENCES;
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+    if (argc > 2 || count <= 0) {
+        fprintf(stderr, "usage: %s [<sentences>]\n", argv[0]);
+        return 1;
+    }
+
+    SystemStatus* systemStatus = SystemStatus::getInstance(new MsgTask("SystemStatusBench"));
+    if (nullptr == systemStatus) {
+        fprintf(stderr, "no SystemStatus\n");
+        return 1;
+    }
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    int parsed = 0;
+    for (int i = 0; i < count; i++) {
+        string sentence = randomSentence();
+        if (sentence.length() > DEBUG_NMEA_MAXSIZE) {
+            continue;
+        }
+        setNmeaString(systemStatus, sentence);
+        SystemStatusReports reports;
+        systemStatus->getReport(reports, true);
+        addReportsToDigest(digest, reports);
+        parsed++;
+    }
+    printf("%d sentences, digest 0x%016" PRIx64, parsed, digest);
+    if (BASELINE_SENTENCES == count) {
+        printf(", %s the original parsers",
+               (BASELINE_DIGEST == digest) ? "same as" : "DIFFERENT from");
+    }
+    printf("\n");
+
+    // two variants of each, so that every sentence is stored as a new report
+    vector<string> second[2];
+    string p7[2];
+    for (int i = 0; i < 2; i++) {
+        string utc = "12351" + to_string(i) + ".00";
+        second[i].push_back("$PQWM1,2100,34567800" + to_string(i) + ",3,1,30,-1234,45,2,-3,"
+                "4511,4490,-12,7,1,2,0,3,0,-7.25,-8.50,-6.75,-5.00,18,1,4201,4188,3999,4002,"
+                "4103,4111,12345*6A\r\n");
+        second[i].push_back("$PQWP1," + utc +
+                ",1F,37.421998,-122.084000,12.5,35,20.0,3*44\r\n");
+        second[i].push_back("$PQWP2," + utc + ",37.422005,-122.083987,11.8,4.2,6.1*1D\r\n");
+        second[i].push_back("$PQWP3," + utc +
+                ",1F,12,14,10,11,3,FFFFFFFF,FFFFFF,1FFFFFFFFF,FFFFFFFFF,1F*52\r\n");
+        second[i].push_back("$PQWP4," + utc +
+                ",FFFFFFFF,FFFFFF,1FFFFFFFFF,FFFFFFFFF,1F*52\r\n");
+        second[i].push_back("$PQWP5," + utc +
+                ",0,0,0,0,0,FFFFFFF0,FFFFF0,1FFFFFFFF0,FFFFFFFF0,1E,0,0,0,0,0*52\r\n");
+        second[i].push_back("$PQWP6," + utc + "," + to_string(i) + "*52\r\n");
+        second[i].push_back("$PQWS1," + utc + "," + to_string(i) + ",0*52\r\n");
+        p7[i] = "$PQWP7," + utc;
+        for (uint32_t sv = 0; sv < SV_ALL_NUM; sv++) {
+            p7[i] += "," + to_string(sv % 3) + "," + to_string(sv % 4) + "," +
+                    to_string((sv * 7 + i) % 3600);
+        }
+        p7[i] += "*52\r\n";
+    }
+    double begin = nowUs();
+    for (int round = 0; round < TIMED_ROUNDS; round++) {
+        for (const string& sentence : second[round & 1]) {
+            setNmeaString(systemStatus, sentence);
+        }
+    }
+    double secondUs = (nowUs() - begin) / TIMED_ROUNDS;
+    begin = nowUs();
+    for (int round = 0; round < TIMED_ROUNDS; round++) {
+        setNmeaString(systemStatus, p7[round & 1]);
+    }
+    double p7Us = (nowUs() - begin) / TIMED_ROUNDS;
+    printf("M1, P1-P6, S1 %8.2f us/second\n", secondUs);
+    printf("P7 (%zu bytes) %7.2f us/sentence\n", p7[0].length(), p7Us);
+    fflush(stdout);
+    _exit(0);
+}
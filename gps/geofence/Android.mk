@@ -14,6 +14,7 @@ LOCAL_MODULE_TAGS := optional
 
 LOCAL_SRC_FILES:= \
     GeofenceAdapter.cpp \
+    GeofenceIndex.cpp \
     location_geofence.cpp
 
 LOCAL_SHARED_LIBRARIES := \
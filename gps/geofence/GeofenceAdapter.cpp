@@ -31,10 +31,24 @@
 #include <GeofenceAdapter.h>
 #include "loc_log.h"
 #include <log_util.h>
+#include <SystemStatus.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
 #include <string>
 
 using namespace loc_core;
 
+// status of the i-th geofence of a batched LocApi geofence request
+static inline LocationError
+getBatchError(LocationError err, const LocApiGeofencesData& data, size_t i)
+{
+    if (LOCATION_ERROR_SUCCESS != err) {
+        return err;
+    }
+    return (i < data.errs.size()) ? data.errs[i] : LOCATION_ERROR_GENERAL_FAILURE;
+}
+
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                     LocContext::getLocContext(
@@ -42,7 +56,16 @@ GeofenceAdapter::GeofenceAdapter() :
                         NULL,
                         LocContext::mLocationHalName,
                         false),
-                    true /*isMaster*/)
+                    true /*isMaster*/),
+    mParkedCount(0),
+    mNextParkedId(0),
+    mModemCapacity(0),
+    mSwapping(false),
+    mRebalanced(false),
+    mRebalanceLatitude(0),
+    mRebalanceLongitude(0),
+    mOverflowTimer(*this),
+    mOverflowTimerActive(false)
 {
     LOC_LOGD("%s]: Constructor", __func__);
 }
@@ -52,29 +75,38 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
 {
     LOC_LOGD("%s]: client %p", __func__, client);
 
-
-    for (auto it = mGeofenceIds.begin(); it != mGeofenceIds.end();) {
-        uint32_t hwId = it->second;
-        GeofenceKey key(it->first);
-        if (client == key.client) {
-            it = mGeofenceIds.erase(it);
-            mLocApi->removeGeofence(hwId, key.id,
-                    new LocApiResponse(*getContext(),
-                    [this, hwId] (LocationError err) {
-                if (LOCATION_ERROR_SUCCESS == err) {
-                    auto it2 = mGeofences.find(hwId);
-                    if (it2 != mGeofences.end()) {
-                        mGeofences.erase(it2);
-                    } else {
-                        LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
-                    }
-                }
-            }));
-            continue;
+    auto clientIt = mGeofenceIds.find(client);
+    if (clientIt == mGeofenceIds.end()) {
+        return;
+    }
+    std::vector<uint32_t> hwIds;
+    std::vector<uint32_t> clientIds;
+    hwIds.reserve(clientIt->second.size());
+    clientIds.reserve(clientIt->second.size());
+    for (auto it = clientIt->second.begin(); it != clientIt->second.end(); ++it) {
+        if (IS_GEOFENCE_PARKED(it->second)) {
+            eraseGeofenceItem(it->second);
+        } else {
+            clientIds.push_back(it->first);
+            hwIds.push_back(it->second);
         }
-        ++it; // increment only when not erasing an iterator
+    }
+    mGeofenceIds.erase(clientIt);
+    updateOverflowTimer();
+    if (hwIds.empty()) {
+        return;
     }
 
+    mLocApi->removeGeofences(hwIds.size(), hwIds.data(), clientIds.data(),
+            new LocApiResponseData<LocApiGeofencesData>(*getContext(),
+            [this, hwIds] (LocationError err, LocApiGeofencesData data) {
+        for (size_t i=0; i < hwIds.size(); ++i) {
+            if (LOCATION_ERROR_SUCCESS == getBatchError(err, data, i)) {
+                eraseGeofenceItem(hwIds[i]);
+            }
+        }
+        checkGeofenceOverflow(true);
+    }));
 }
 
 void
@@ -96,26 +128,85 @@ GeofenceAdapter::updateClientsEventMask()
 LocationError
 GeofenceAdapter::getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId)
 {
-    GeofenceKey key(client, clientId);
-    auto it = mGeofenceIds.find(key);
-    if (it != mGeofenceIds.end()) {
-        hwId = it->second;
-        return LOCATION_ERROR_SUCCESS;
+    auto clientIt = mGeofenceIds.find(client);
+    if (clientIt != mGeofenceIds.end()) {
+        auto it = clientIt->second.find(clientId);
+        if (it != clientIt->second.end()) {
+            hwId = it->second;
+            return LOCATION_ERROR_SUCCESS;
+        }
     }
     return LOCATION_ERROR_ID_UNKNOWN;
 }
 
+void
+GeofenceAdapter::getHwIdsFromClient(LocationAPI* client, size_t count, const uint32_t* clientIds,
+        LocationError* errs, GeofenceHwRequest& request)
+{
+    request.indexes.reserve(count);
+    request.clientIds.reserve(count);
+    request.hwIds.reserve(count);
+    for (size_t i=0; i < count; ++i) {
+        uint32_t hwId = 0;
+        errs[i] = getHwIdFromClient(client, clientIds[i], hwId);
+        if (LOCATION_ERROR_SUCCESS == errs[i] && IS_GEOFENCE_PARKED(hwId)) {
+            request.parkedIndexes.push_back(i);
+            request.parkedHwIds.push_back(hwId);
+        } else if (LOCATION_ERROR_SUCCESS == errs[i]) {
+            request.indexes.push_back(i);
+            request.clientIds.push_back(clientIds[i]);
+            request.hwIds.push_back(hwId);
+        }
+    }
+}
+
 LocationError
 GeofenceAdapter::getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key)
 {
-    auto it = mGeofences.find(hwId);
-    if (it != mGeofences.end()) {
-        key = it->second.key;
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr != object) {
+        key = object->key;
         return LOCATION_ERROR_SUCCESS;
     }
     return LOCATION_ERROR_ID_UNKNOWN;
 }
 
+GeofenceObject*
+GeofenceAdapter::getGeofenceItem(uint32_t hwId)
+{
+    auto it = mGeofenceSlots.find(hwId);
+    if (it != mGeofenceSlots.end()) {
+        return &mGeofences[it->second];
+    }
+    return nullptr;
+}
+
+void
+GeofenceAdapter::getGeofencesNear(double latitude, double longitude, double distance,
+        std::vector<uint32_t>& hwIds)
+{
+    size_t first = hwIds.size();
+    if (mGeofenceIndex.getCandidates(latitude, longitude, distance, hwIds)) {
+        size_t count = first;
+        for (size_t i = first; i < hwIds.size(); ++i) {
+            GeofenceObject* object = getGeofenceItem(hwIds[i]);
+            if (nullptr != object &&
+                    GeofenceIndex::getDistanceMeters(latitude, longitude,
+                            object->latitude, object->longitude) <= distance + object->radius) {
+                hwIds[count++] = hwIds[i];
+            }
+        }
+        hwIds.resize(count);
+    } else {
+        for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+            if (GeofenceIndex::getDistanceMeters(latitude, longitude,
+                    it->latitude, it->longitude) <= distance + it->radius) {
+                hwIds.push_back(it->hwId);
+            }
+        }
+    }
+}
+
 void
 GeofenceAdapter::handleEngineUpEvent()
 {
@@ -145,34 +236,77 @@ GeofenceAdapter::restartGeofences()
         return;
     }
 
-    GeofencesMap oldGeofences(mGeofences);
-    mGeofences.clear();
-    mGeofenceIds.clear();
+    std::vector<GeofenceObject> objects;
+    std::vector<uint32_t> clientIds;
+    std::vector<GeofenceOption> options;
+    std::vector<GeofenceInfo> infos;
+    objects.reserve(mGeofences.size());
+    clientIds.reserve(mGeofences.size());
+    options.reserve(mGeofences.size());
+    infos.reserve(mGeofences.size());
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); it++) {
+        const GeofenceObject& object = *it;
+        if (IS_GEOFENCE_PARKED(object.hwId)) {
+            continue;
+        }
+        objects.push_back(object);
+        clientIds.push_back(object.key.id);
+        options.push_back({sizeof(GeofenceOption),
+                           object.breachMask,
+                           object.responsiveness,
+                           object.dwellTime});
+        infos.push_back({sizeof(GeofenceInfo),
+                         object.latitude,
+                         object.longitude,
+                         object.radius});
+    }
+    if (objects.empty()) {
+        return;
+    }
+    // parked geofences stay as they are; a swap in flight is lost with the engine
+    mSwapping = false;
+    for (auto& object : objects) {
+        eraseGeofenceItem(object.hwId);
+        auto clientIt = mGeofenceIds.find(object.key.client);
+        if (clientIt != mGeofenceIds.end()) {
+            clientIt->second.erase(object.key.id);
+            if (clientIt->second.empty()) {
+                mGeofenceIds.erase(clientIt);
+            }
+        }
+    }
 
-    for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
-        GeofenceObject object = it->second;
-        GeofenceOption options = {sizeof(GeofenceOption),
-                                   object.breachMask,
-                                   object.responsiveness,
-                                   object.dwellTime};
-        GeofenceInfo info = {sizeof(GeofenceInfo),
-                             object.latitude,
-                             object.longitude,
-                             object.radius};
-        mLocApi->addGeofence(object.key.id,
-                              options,
-                              info,
-                              new LocApiResponseData<LocApiGeofenceData>(*getContext(),
-                [this, object, options, info] (LocationError err, LocApiGeofenceData data) {
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (true == object.paused) {
-                    mLocApi->pauseGeofence(data.hwId, object.key.id,
-                            new LocApiResponse(*getContext(), [] (LocationError err ) {}));
+    mLocApi->addGeofences(objects.size(), clientIds.data(), options.data(), infos.data(),
+            new LocApiResponseData<LocApiGeofencesData>(*getContext(),
+            [this, objects, options, infos] (LocationError err, LocApiGeofencesData data) {
+        std::vector<uint32_t> pausedHwIds;
+        std::vector<uint32_t> pausedClientIds;
+        for (size_t i=0; i < objects.size(); ++i) {
+            if (LOCATION_ERROR_SUCCESS == getBatchError(err, data, i) &&
+                    i < data.hwIds.size()) {
+                saveGeofenceItem(objects[i].key.client, objects[i].key.id, data.hwIds[i],
+                                 options[i], infos[i]);
+                if (true == objects[i].paused) {
+                    pausedHwIds.push_back(data.hwIds[i]);
+                    pausedClientIds.push_back(objects[i].key.id);
+                    pauseGeofenceItem(data.hwIds[i]);
+                }
+            } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == getBatchError(err, data, i)) {
+                uint32_t parkedHwId = parkGeofenceItem(objects[i].key.client, objects[i].key.id,
+                                                       options[i], infos[i]);
+                if (0 != parkedHwId && true == objects[i].paused) {
+                    pauseGeofenceItem(parkedHwId);
                 }
-                saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
             }
-        }));
-    }
+        }
+        if (!pausedHwIds.empty()) {
+            mLocApi->pauseGeofences(pausedHwIds.size(), pausedHwIds.data(),
+                    pausedClientIds.data(),
+                    new LocApiResponseData<LocApiGeofencesData>(*getContext(),
+                    [] (LocationError /*err*/, LocApiGeofencesData /*data*/) {}));
+        }
+        checkGeofenceOverflow(true);
+    }));
 }
 
 void
@@ -233,45 +367,51 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
             mOptions(options),
             mInfos(infos) {}
         inline virtual void proc() const {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
+            if (NULL == mOptions || NULL == mInfos) {
+                LocationError* errs = new LocationError[mCount];
+                for (size_t i=0; i < mCount; ++i) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                            mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
-                            errs, i] (LocationError err ) {
-                        mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
-                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
-                        (LocationError err, LocApiGeofenceData data) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.saveGeofenceItem(mClient,
-                                mIds[i],
-                                data.hwId,
-                                mOptions[i],
-                                mInfos[i]);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
-                                delete[] mInfos;
-                            }
-                        }));
-                    }));
                 }
+                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                delete[] errs;
+                delete[] mIds;
+                delete[] mOptions;
+                delete[] mInfos;
+                return;
             }
+            mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    [&mAdapter = mAdapter, &mApi = mApi, mClient = mClient, mCount = mCount,
+                    mIds = mIds, mOptions = mOptions, mInfos = mInfos] (LocationError /*err*/) {
+                mApi.addGeofences(mCount, mIds, mOptions, mInfos,
+                        new LocApiResponseData<LocApiGeofencesData>(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mCount = mCount,
+                        mIds = mIds, mOptions = mOptions, mInfos = mInfos]
+                        (LocationError err, LocApiGeofencesData data) {
+                    LocationError* errs = new LocationError[mCount];
+                    bool parked = false;
+                    for (size_t i=0; i < mCount; ++i) {
+                        errs[i] = getBatchError(err, data, i);
+                        if (LOCATION_ERROR_SUCCESS == errs[i] && i < data.hwIds.size()) {
+                            mAdapter.saveGeofenceItem(mClient, mIds[i], data.hwIds[i],
+                                                      mOptions[i], mInfos[i]);
+                        } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == errs[i] &&
+                                0 != mAdapter.parkGeofenceItem(mClient, mIds[i],
+                                                               mOptions[i], mInfos[i])) {
+                            errs[i] = LOCATION_ERROR_SUCCESS;
+                            parked = true;
+                        }
+                    }
+                    if (parked) {
+                        // the new geofences may be nearer than loaded ones
+                        mAdapter.checkGeofenceOverflow(true);
+                    }
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                    delete[] mOptions;
+                    delete[] mInfos;
+                }));
+            }));
         }
     };
 
@@ -338,44 +478,34 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.removeGeofence(hwId, mIds[i],
-                        new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.removeGeofenceItem(hwId);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
+            mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    [&mAdapter = mAdapter, &mApi = mApi, mClient = mClient, mCount = mCount,
+                    mIds = mIds] (LocationError /*err*/) {
+                LocationError* errs = new LocationError[mCount];
+                GeofenceHwRequest request;
+                mAdapter.getHwIdsFromClient(mClient, mCount, mIds, errs, request);
+                for (uint32_t hwId : request.parkedHwIds) {
+                    mAdapter.removeGeofenceItem(hwId);
+                }
+                mApi.removeGeofences(request.hwIds.size(), request.hwIds.data(),
+                        request.clientIds.data(),
+                        new LocApiResponseData<LocApiGeofencesData>(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mCount = mCount, mIds = mIds,
+                        errs, request]
+                        (LocationError err, LocApiGeofencesData data) {
+                    for (size_t k=0; k < request.hwIds.size(); ++k) {
+                        size_t i = request.indexes[k];
+                        errs[i] = getBatchError(err, data, k);
+                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                            mAdapter.removeGeofenceItem(request.hwIds[k]);
                         }
                     }
+                    mAdapter.checkGeofenceOverflow(true);
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
                 }));
-            }
+            }));
         }
     };
 
@@ -414,43 +544,33 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.pauseGeofenceItem(hwId);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
+            mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    [&mAdapter = mAdapter, &mApi = mApi, mClient = mClient, mCount = mCount,
+                    mIds = mIds] (LocationError /*err*/) {
+                LocationError* errs = new LocationError[mCount];
+                GeofenceHwRequest request;
+                mAdapter.getHwIdsFromClient(mClient, mCount, mIds, errs, request);
+                for (uint32_t hwId : request.parkedHwIds) {
+                    mAdapter.pauseGeofenceItem(hwId);
+                }
+                mApi.pauseGeofences(request.hwIds.size(), request.hwIds.data(),
+                        request.clientIds.data(),
+                        new LocApiResponseData<LocApiGeofencesData>(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mCount = mCount, mIds = mIds,
+                        errs, request]
+                        (LocationError err, LocApiGeofencesData data) {
+                    for (size_t k=0; k < request.hwIds.size(); ++k) {
+                        size_t i = request.indexes[k];
+                        errs[i] = getBatchError(err, data, k);
+                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                            mAdapter.pauseGeofenceItem(request.hwIds[k]);
                         }
                     }
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
                 }));
-            }
+            }));
         }
     };
 
@@ -489,44 +609,35 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
             mCount(count),
             mIds(ids) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
-                                [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
-                                errs, mIds = mIds, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                errs[i] = err;
-
-                                mAdapter.resumeGeofenceItem(hwId);
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                }
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
+            mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    [&mAdapter = mAdapter, &mApi = mApi, mClient = mClient, mCount = mCount,
+                    mIds = mIds] (LocationError /*err*/) {
+                LocationError* errs = new LocationError[mCount];
+                GeofenceHwRequest request;
+                mAdapter.getHwIdsFromClient(mClient, mCount, mIds, errs, request);
+                for (uint32_t hwId : request.parkedHwIds) {
+                    mAdapter.resumeGeofenceItem(hwId);
+                }
+                mApi.resumeGeofences(request.hwIds.size(), request.hwIds.data(),
+                        request.clientIds.data(),
+                        new LocApiResponseData<LocApiGeofencesData>(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mCount = mCount, mIds = mIds,
+                        errs, request]
+                        (LocationError err, LocApiGeofencesData data) {
+                    for (size_t k=0; k < request.hwIds.size(); ++k) {
+                        size_t i = request.indexes[k];
+                        errs[i] = getBatchError(err, data, k);
+                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
+                            mAdapter.resumeGeofenceItem(request.hwIds[k]);
                         }
                     }
+                    // a resumed parked geofence may be near enough to load now
+                    mAdapter.checkGeofenceOverflow(true);
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
                 }));
-            }
+            }));
         }
     };
 
@@ -569,51 +680,50 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
             mIds(ids),
             mOptions(options) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
+            if (NULL == mOptions) {
+                LocationError* errs = new LocationError[mCount];
+                for (size_t i=0; i < mCount; ++i) {
+                    errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
+                }
+                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                delete[] errs;
+                delete[] mIds;
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions) {
-                    errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                            &mApi = mApi, mOptions = mOptions, errs, i] (LocationError err ) {
-                        uint32_t hwId = 0;
-                        errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
+            mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    [&mAdapter = mAdapter, &mApi = mApi, mClient = mClient, mCount = mCount,
+                    mIds = mIds, mOptions = mOptions] (LocationError /*err*/) {
+                LocationError* errs = new LocationError[mCount];
+                GeofenceHwRequest request;
+                mAdapter.getHwIdsFromClient(mClient, mCount, mIds, errs, request);
+                for (size_t k=0; k < request.parkedHwIds.size(); ++k) {
+                    mAdapter.modifyGeofenceItem(request.parkedHwIds[k],
+                                                mOptions[request.parkedIndexes[k]]);
+                }
+                std::vector<GeofenceOption> options;
+                options.reserve(request.indexes.size());
+                for (size_t i : request.indexes) {
+                    options.push_back(mOptions[i]);
+                }
+                mApi.modifyGeofences(request.hwIds.size(), request.hwIds.data(),
+                        request.clientIds.data(), options.data(),
+                        new LocApiResponseData<LocApiGeofencesData>(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mCount = mCount, mIds = mIds,
+                        mOptions = mOptions, errs, request]
+                        (LocationError err, LocApiGeofencesData data) {
+                    for (size_t k=0; k < request.hwIds.size(); ++k) {
+                        size_t i = request.indexes[k];
+                        errs[i] = getBatchError(err, data, k);
                         if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                            mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
-                                    [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                                    mIds = mIds, mOptions = mOptions, hwId, errs, i]
-                                    (LocationError err ) {
-                                if (LOCATION_ERROR_SUCCESS == err) {
-                                    errs[i] = err;
-
-                                    mAdapter.modifyGeofenceItem(hwId, mOptions[i]);
-                                }
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                    delete[] mOptions;
-                                }
-                            }));
-                        } else {
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
-                            }
+                            mAdapter.modifyGeofenceItem(request.hwIds[k], mOptions[i]);
                         }
-                    }));
-                }
-            }
+                    }
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                    delete[] mOptions;
+                }));
+            }));
         }
     };
 
@@ -647,7 +757,8 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
 {
     LOC_LOGD("%s]: hwId %u client %p clientId %u", __func__, hwId, client, clientId);
     GeofenceKey key(client, clientId);
-    GeofenceObject object = {key,
+    GeofenceObject object = {hwId,
+                             key,
                              options.breachTypeMask,
                              options.responsiveness,
                              options.dwellTime,
@@ -655,11 +766,47 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              info.longitude,
                              info.radius,
                              false};
-    mGeofences[hwId] = object;
-    mGeofenceIds[key] = hwId;
+    auto it = mGeofenceSlots.find(hwId);
+    if (it != mGeofenceSlots.end()) {
+        GeofenceObject& old = mGeofences[it->second];
+        mGeofenceIndex.remove(hwId, old.latitude, old.longitude, old.radius);
+        old = object;
+    } else {
+        mGeofenceSlots[hwId] = mGeofences.size();
+        mGeofences.push_back(object);
+        if (IS_GEOFENCE_PARKED(hwId)) {
+            mParkedCount++;
+        }
+    }
+    mGeofenceIndex.insert(hwId, info.latitude, info.longitude, info.radius);
+    mGeofenceIds[client][clientId] = hwId;
     dump();
 }
 
+// erases the GeofenceObject of hwId, but not its client id
+void
+GeofenceAdapter::eraseGeofenceItem(uint32_t hwId)
+{
+    auto it = mGeofenceSlots.find(hwId);
+    if (it == mGeofenceSlots.end()) {
+        LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
+        return;
+    }
+    size_t slot = it->second;
+    GeofenceObject& object = mGeofences[slot];
+    mGeofenceIndex.remove(hwId, object.latitude, object.longitude, object.radius);
+    mGeofenceSlots.erase(it);
+    if (IS_GEOFENCE_PARKED(hwId)) {
+        mParkedCount--;
+    }
+    // fill the hole with the last GeofenceObject to keep mGeofences dense
+    if (slot != mGeofences.size() - 1) {
+        object = mGeofences.back();
+        mGeofenceSlots[object.hwId] = slot;
+    }
+    mGeofences.pop_back();
+}
+
 void
 GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
 {
@@ -668,17 +815,13 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
     if (LOCATION_ERROR_SUCCESS != err) {
         LOC_LOGE("%s]: can not find the key for hwId %u", __func__, hwId);
     } else {
-        auto it1 = mGeofenceIds.find(key);
-        if (it1 != mGeofenceIds.end()) {
-            mGeofenceIds.erase(it1);
-
-            auto it2 = mGeofences.find(hwId);
-            if (it2 != mGeofences.end()) {
-                mGeofences.erase(it2);
-                dump();
-            } else {
-                LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
+        auto clientIt = mGeofenceIds.find(key.client);
+        if (clientIt != mGeofenceIds.end() && clientIt->second.erase(key.id) > 0) {
+            if (clientIt->second.empty()) {
+                mGeofenceIds.erase(clientIt);
             }
+            eraseGeofenceItem(hwId);
+            dump();
         } else {
             LOC_LOGE("%s]: geofence item to erase not found. hwId %u", __func__, hwId);
         }
@@ -688,9 +831,9 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
 void
 GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
 {
-    auto it = mGeofences.find(hwId);
-    if (it != mGeofences.end()) {
-        it->second.paused = true;
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr != object) {
+        object->paused = true;
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
@@ -700,9 +843,9 @@ GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
 void
 GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
 {
-    auto it = mGeofences.find(hwId);
-    if (it != mGeofences.end()) {
-        it->second.paused = false;
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr != object) {
+        object->paused = false;
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
@@ -712,11 +855,11 @@ GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
 void
 GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options)
 {
-    auto it = mGeofences.find(hwId);
-    if (it != mGeofences.end()) {
-        it->second.breachMask = options.breachTypeMask;
-        it->second.responsiveness = options.responsiveness;
-        it->second.dwellTime = options.dwellTime;
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr != object) {
+        object->breachMask = options.breachTypeMask;
+        object->responsiveness = options.responsiveness;
+        object->dwellTime = options.dwellTime;
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to modify not found. hwId %u", __func__, hwId);
@@ -724,6 +867,304 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
 }
 
 
+uint32_t
+GeofenceAdapter::generateParkedHwId()
+{
+    uint32_t hwId;
+    do {
+        hwId = GEOFENCE_PARKED_HWID_BIT | (mNextParkedId++ & ~GEOFENCE_PARKED_HWID_BIT);
+    } while (mGeofenceSlots.find(hwId) != mGeofenceSlots.end());
+    return hwId;
+}
+
+// moves a GeofenceObject to a new hwId, e.g. when it is parked or loaded
+void
+GeofenceAdapter::rekeyGeofenceItem(uint32_t hwId, uint32_t newHwId)
+{
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr == object) {
+        LOC_LOGE("%s]: geofence item to rekey not found. hwId %u", __func__, hwId);
+        return;
+    }
+    GeofenceObject copy = *object;
+    eraseGeofenceItem(hwId);
+    copy.hwId = newHwId;
+    mGeofenceSlots[newHwId] = mGeofences.size();
+    mGeofences.push_back(copy);
+    if (IS_GEOFENCE_PARKED(newHwId)) {
+        mParkedCount++;
+    }
+    mGeofenceIndex.insert(newHwId, copy.latitude, copy.longitude, copy.radius);
+    mGeofenceIds[copy.key.client][copy.key.id] = newHwId;
+}
+
+uint32_t
+GeofenceAdapter::parkGeofenceItem(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options, const GeofenceInfo& info)
+{
+    if (0 == ContextBase::mGps_conf.GEOFENCE_OVERFLOW_ENABLED) {
+        return 0;
+    }
+    // geofences of this adapter the modem took before it ran out of room
+    mModemCapacity = mGeofences.size() - mParkedCount;
+    uint32_t hwId = generateParkedHwId();
+    LOC_LOGD("%s]: modem capacity %zu, parked %zu", __func__, mModemCapacity, mParkedCount + 1);
+    saveGeofenceItem(client, clientId, hwId, options, info);
+    updateOverflowTimer();
+    return hwId;
+}
+
+void
+GeofenceAdapter::updateOverflowTimer()
+{
+    if (mParkedCount > 0 && !mOverflowTimerActive) {
+        mOverflowTimerActive = mOverflowTimer.start(GEOFENCE_OVERFLOW_CHECK_MS, false,
+                                                    GEOFENCE_OVERFLOW_CHECK_SLACK_MS);
+    } else if (0 == mParkedCount && mOverflowTimerActive) {
+        mOverflowTimer.stop();
+        mOverflowTimerActive = false;
+        mRebalanced = false;
+    }
+}
+
+void
+GeofenceOverflowTimer::timeOutCallback()
+{
+    mAdapter.overflowTimerExpireEvent();
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceAdapter::overflowTimerExpireEvent()
+{
+    struct MsgOverflowTimerExpire : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgOverflowTimerExpire(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.mOverflowTimerActive = false;
+            mAdapter.checkGeofenceOverflow(false);
+        }
+    };
+
+    sendMsg(new MsgOverflowTimerExpire(*this));
+}
+
+void
+GeofenceAdapter::checkGeofenceOverflow(bool force)
+{
+    if (mParkedCount > 0) {
+        // whatever fix any session, or a passive client, got last; no session is
+        // started for the geofences
+        SystemStatus* systemStatus = SystemStatus::getInstance(mMsgTask);
+        SystemStatusReports reports = {};
+        if (nullptr != systemStatus) {
+            systemStatus->getReport(reports, SYSTEM_STATUS_REPORT_LOCATION_BIT, 1);
+        }
+        if (!reports.mLocation.empty() && reports.mLocation.back().mValid) {
+            const LocGpsLocation& location = reports.mLocation.back().mLocation.gpsLocation;
+            rebalanceGeofences(location.latitude, location.longitude, force);
+        } else {
+            LOC_LOGD("%s]: no location yet, %zu geofences stay parked", __func__, mParkedCount);
+        }
+    }
+    updateOverflowTimer();
+}
+
+// distance from a point to the boundary of a geofence, 0 if inside
+static inline double
+getGeofenceDistance(double latitude, double longitude, const GeofenceObject& object)
+{
+    double distance = GeofenceIndex::getDistanceMeters(latitude, longitude,
+                                                       object.latitude, object.longitude);
+    return std::max(distance - object.radius, 0.0);
+}
+
+void
+GeofenceAdapter::rebalanceGeofences(double latitude, double longitude, bool force)
+{
+    if (0 == mParkedCount || mSwapping) {
+        return;
+    }
+    if (!force && mRebalanced &&
+            GeofenceIndex::getDistanceMeters(latitude, longitude, mRebalanceLatitude,
+                                             mRebalanceLongitude) <
+            GEOFENCE_OVERFLOW_MIN_MOVE_METERS) {
+        return;
+    }
+    mRebalanced = true;
+    mRebalanceLatitude = latitude;
+    mRebalanceLongitude = longitude;
+
+    // loaded geofences, farthest first; paused ones need no room in the modem
+    std::vector<std::pair<double, uint32_t>> loaded;
+    loaded.reserve(mGeofences.size() - mParkedCount);
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+        if (!IS_GEOFENCE_PARKED(it->hwId)) {
+            loaded.push_back(std::make_pair(it->paused ? HUGE_VAL :
+                    getGeofenceDistance(latitude, longitude, *it), it->hwId));
+        }
+    }
+    std::sort(loaded.begin(), loaded.end(), std::greater<std::pair<double, uint32_t>>());
+    size_t room = (mModemCapacity > loaded.size()) ? mModemCapacity - loaded.size() : 0;
+
+    // parked geofences that are near enough to take a free room or replace a
+    // loaded one, nearest first
+    std::vector<uint32_t> hwIds;
+    if (room > 0) {
+        for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+            if (IS_GEOFENCE_PARKED(it->hwId)) {
+                hwIds.push_back(it->hwId);
+            }
+        }
+    } else if (!loaded.empty() && loaded[0].first > GEOFENCE_OVERFLOW_HYSTERESIS_METERS) {
+        getGeofencesNear(latitude, longitude,
+                         loaded[0].first - GEOFENCE_OVERFLOW_HYSTERESIS_METERS, hwIds);
+    }
+    std::vector<std::pair<double, uint32_t>> parked;
+    for (uint32_t hwId : hwIds) {
+        GeofenceObject* object = getGeofenceItem(hwId);
+        if (IS_GEOFENCE_PARKED(hwId) && nullptr != object && !object->paused) {
+            parked.push_back(std::make_pair(
+                    getGeofenceDistance(latitude, longitude, *object), hwId));
+        }
+    }
+    std::sort(parked.begin(), parked.end());
+
+    std::vector<uint32_t> inHwIds;
+    std::vector<uint32_t> outHwIds;
+    size_t i = 0;
+    for (; i < parked.size() && i < room; ++i) {
+        inHwIds.push_back(parked[i].second);
+    }
+    for (size_t j = 0; i < parked.size() && j < loaded.size() &&
+            loaded[j].first > parked[i].first + GEOFENCE_OVERFLOW_HYSTERESIS_METERS; ++i, ++j) {
+        inHwIds.push_back(parked[i].second);
+        outHwIds.push_back(loaded[j].second);
+    }
+
+    LOC_LOGD("%s]: loaded %zu room %zu parked %zu, swapping in %zu out %zu", __func__,
+             loaded.size(), room, mParkedCount, inHwIds.size(), outHwIds.size());
+    if (!inHwIds.empty()) {
+        swapGeofences(outHwIds, inHwIds);
+    }
+}
+
+void
+GeofenceAdapter::swapGeofences(const std::vector<uint32_t>& outHwIds,
+        const std::vector<uint32_t>& inHwIds)
+{
+    mSwapping = true;
+
+    // park the outgoing geofences right away, so that client commands from now
+    // on find them parked; the remove goes ahead of the add in the LocApi queue
+    std::vector<uint32_t> outClientIds;
+    std::vector<GeofenceObject> outObjects;
+    for (uint32_t hwId : outHwIds) {
+        GeofenceObject* object = getGeofenceItem(hwId);
+        outClientIds.push_back(nullptr != object ? object->key.id : 0);
+        outObjects.push_back(nullptr != object ? *object : GeofenceObject());
+        outObjects.back().hwId = generateParkedHwId();
+        rekeyGeofenceItem(hwId, outObjects.back().hwId);
+    }
+    if (!outHwIds.empty()) {
+        mLocApi->removeGeofences(outHwIds.size(), outHwIds.data(), outClientIds.data(),
+                new LocApiResponseData<LocApiGeofencesData>(*getContext(),
+                [this, outHwIds, outObjects] (LocationError err, LocApiGeofencesData data) {
+            for (size_t i=0; i < outHwIds.size(); ++i) {
+                if (LOCATION_ERROR_SUCCESS == getBatchError(err, data, i)) {
+                    continue;
+                }
+                LOC_LOGE("swapGeofences]: failed to unload hwId %u", outHwIds[i]);
+                GeofenceObject* object = getGeofenceItem(outObjects[i].hwId);
+                if (nullptr == object || object->key != outObjects[i].key) {
+                    // removed by its client meanwhile, it must not stay in the modem
+                    mLocApi->removeGeofence(outHwIds[i], outObjects[i].key.id,
+                            new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+                    continue;
+                }
+                // still in the modem, so it is loaded under its modem hwId again
+                rekeyGeofenceItem(outObjects[i].hwId, outHwIds[i]);
+                syncGeofenceItem(outHwIds[i], outObjects[i]);
+            }
+        }));
+    }
+
+    std::vector<GeofenceObject> objects;
+    std::vector<uint32_t> clientIds;
+    std::vector<GeofenceOption> options;
+    std::vector<GeofenceInfo> infos;
+    for (uint32_t hwId : inHwIds) {
+        const GeofenceObject& object = *getGeofenceItem(hwId);
+        objects.push_back(object);
+        clientIds.push_back(object.key.id);
+        options.push_back({sizeof(GeofenceOption),
+                           object.breachMask,
+                           object.responsiveness,
+                           object.dwellTime});
+        infos.push_back({sizeof(GeofenceInfo),
+                         object.latitude,
+                         object.longitude,
+                         object.radius});
+    }
+    mLocApi->addGeofences(objects.size(), clientIds.data(), options.data(), infos.data(),
+            new LocApiResponseData<LocApiGeofencesData>(*getContext(),
+            [this, objects] (LocationError err, LocApiGeofencesData data) {
+        for (size_t i=0; i < objects.size(); ++i) {
+            LocationError error = getBatchError(err, data, i);
+            if (LOCATION_ERROR_SUCCESS != error || i >= data.hwIds.size()) {
+                if (LOCATION_ERROR_GEOFENCES_AT_MAX == error) {
+                    mModemCapacity = mGeofences.size() - mParkedCount;
+                }
+                continue;
+            }
+            uint32_t hwId = data.hwIds[i];
+            GeofenceObject* object = getGeofenceItem(objects[i].hwId);
+            if (nullptr == object || object->key != objects[i].key) {
+                // removed by its client meanwhile
+                mLocApi->removeGeofence(hwId, objects[i].key.id,
+                        new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+                continue;
+            }
+            rekeyGeofenceItem(objects[i].hwId, hwId);
+            // the modem added it unpaused
+            GeofenceObject added = objects[i];
+            added.paused = false;
+            syncGeofenceItem(hwId, added);
+        }
+        mSwapping = false;
+        dump();
+        updateOverflowTimer();
+    }));
+}
+
+void
+GeofenceAdapter::syncGeofenceItem(uint32_t hwId, const GeofenceObject& loaded)
+{
+    GeofenceObject* object = getGeofenceItem(hwId);
+    if (nullptr == object) {
+        return;
+    }
+    if (object->breachMask != loaded.breachMask ||
+            object->responsiveness != loaded.responsiveness ||
+            object->dwellTime != loaded.dwellTime) {
+        GeofenceOption options = {sizeof(GeofenceOption),
+                                  object->breachMask,
+                                  object->responsiveness,
+                                  object->dwellTime};
+        mLocApi->modifyGeofence(hwId, object->key.id, options,
+                new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+    }
+    if (object->paused && !loaded.paused) {
+        mLocApi->pauseGeofence(hwId, object->key.id,
+                new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+    } else if (!object->paused && loaded.paused) {
+        mLocApi->resumeGeofence(hwId, object->key.id,
+                new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+    }
+}
+
 void
 GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
         GeofenceBreachType breachType, uint64_t timestamp)
@@ -787,33 +1228,40 @@ void
 GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
         GeofenceBreachType breachType, uint64_t timestamp)
 {
+    // look every hwId up once, then hand each client its own ids, in report order
+    mBreachKeys.clear();
+    for (size_t i=0; i < count; ++i) {
+        GeofenceObject* object = getGeofenceItem(hwIds[i]);
+        if (nullptr != object) {
+            mBreachKeys.push_back(object->key);
+        }
+    }
 
     for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        uint32_t* clientIds = new uint32_t[count];
-        if (nullptr == clientIds) {
-            return;
+        if (it->second.geofenceBreachCb == nullptr) {
+            continue;
         }
-        uint32_t index = 0;
-        for (size_t i=0; i < count; ++i) {
-            GeofenceKey key;
-            LocationError err = getGeofenceKeyFromHwId(hwIds[i], key);
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (key.client == it->first) {
-                    clientIds[index++] = key.id;
-                }
+        mBreachIds.clear();
+        for (auto& key : mBreachKeys) {
+            if (key.client == it->first) {
+                mBreachIds.push_back(key.id);
             }
         }
-        if (index > 0 && it->second.geofenceBreachCb != nullptr) {
+        if (!mBreachIds.empty()) {
             GeofenceBreachNotification notify = {sizeof(GeofenceBreachNotification),
-                                                 index,
-                                                 clientIds,
+                                                 (uint32_t)mBreachIds.size(),
+                                                 mBreachIds.data(),
                                                  location,
                                                  breachType,
                                                  timestamp};
 
             it->second.geofenceBreachCb(notify);
         }
-        delete[] clientIds;
+    }
+
+    // after the fan-out, as a swap parks the geofences it unloads
+    if (mParkedCount > 0) {
+        rebalanceGeofences(location.latitude, location.longitude, false);
     }
 }
 
@@ -858,8 +1306,8 @@ GeofenceAdapter::dump()
         LOC_LOGV(
             "HAL | hwId  | mask | respon | latitude | longitude | radius | paused |  Id  | client");
         for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
-            uint32_t hwId = it->first;
-            GeofenceObject object = it->second;
+            uint32_t hwId = it->hwId;
+            const GeofenceObject& object = *it;
             LOC_LOGV("    | %5u | %4u | %6u | %8.2f | %9.2f | %6.2f | %6u | %04x | %p ",
                     hwId, object.breachMask, object.responsiveness,
                     object.latitude, object.longitude, object.radius,
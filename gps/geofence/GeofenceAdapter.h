@@ -32,10 +32,25 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
-#include <map>
+#include <LocTimer.h>
+#include <GeofenceIndex.h>
+#include <vector>
+#include <unordered_map>
 
 using namespace loc_core;
 
+// geofences the modem has no room for are parked on the AP, under a hwId with
+// this bit set; modem hwIds are assumed to never have it
+#define GEOFENCE_PARKED_HWID_BIT (0x80000000)
+#define IS_GEOFENCE_PARKED(hwId) (0 != ((hwId) & GEOFENCE_PARKED_HWID_BIT))
+// while geofences are parked, how often to look at the last known location
+#define GEOFENCE_OVERFLOW_CHECK_MS (60000)
+#define GEOFENCE_OVERFLOW_CHECK_SLACK_MS (30000)
+// how far the device has to move before the loaded geofences are reconsidered
+#define GEOFENCE_OVERFLOW_MIN_MOVE_METERS (500.0)
+// how much nearer a parked geofence has to be than the loaded one it replaces
+#define GEOFENCE_OVERFLOW_HYSTERESIS_METERS (1000.0)
+
 #define COPY_IF_NOT_NULL(dest, src, len) do { \
     if (NULL!=dest && NULL!=src) { \
         for (size_t i=0; i<len; ++i) { \
@@ -62,6 +77,7 @@ inline bool operator !=(GeofenceKey const& left, GeofenceKey const& right) {
     return left.id != right.id || left.client != right.client;
 }
 typedef struct {
+    uint32_t hwId;
     GeofenceKey key;
     GeofenceBreachTypeMask breachMask;
     uint32_t responsiveness;
@@ -71,14 +87,60 @@ typedef struct {
     double radius;
     bool paused;
 } GeofenceObject;
-typedef std::map<uint32_t, GeofenceObject> GeofencesMap; //map of hwId to GeofenceObject
-typedef std::map<GeofenceKey, uint32_t> GeofenceIdMap; //map of GeofenceKey to hwId
+typedef std::vector<GeofenceObject> GeofencesVector; //dense GeofenceObjects, in no order
+typedef std::unordered_map<uint32_t, size_t> GeofenceSlotMap; //map of hwId to GeofencesVector index
+typedef std::unordered_map<uint32_t, uint32_t> GeofenceIdMap; //map of client id to hwId
+typedef std::unordered_map<LocationAPI*, GeofenceIdMap> ClientGeofenceIdMap; //per client
+typedef struct {
+    std::vector<size_t> indexes; // position of each geofence in the client request
+    std::vector<uint32_t> clientIds;
+    std::vector<uint32_t> hwIds;
+    std::vector<size_t> parkedIndexes; // parked geofences, not sent to LocApi
+    std::vector<uint32_t> parkedHwIds;
+} GeofenceHwRequest; //known geofences of a client request, as sent to LocApi
+
+class GeofenceAdapter;
+class GeofenceOverflowTimer : public LocTimer {
+public:
+    inline GeofenceOverflowTimer(GeofenceAdapter& adapter) :
+            LocTimer(), mAdapter(adapter) {}
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GeofenceAdapter& mAdapter;
+};
 
 class GeofenceAdapter : public LocAdapterBase {
 
     /* ==== GEOFENCES ====================================================================== */
-    GeofencesMap mGeofences; //map hwId to GeofenceObject
-    GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    GeofencesVector mGeofences;
+    GeofenceSlotMap mGeofenceSlots; //map hwId to index in mGeofences
+    ClientGeofenceIdMap mGeofenceIds; //map of client to its client ids to hwIds
+    GeofenceIndex mGeofenceIndex; //hwIds by location
+    std::vector<GeofenceKey> mBreachKeys; //scratch of geofenceBreach, kept to reuse its storage
+    std::vector<uint32_t> mBreachIds; //ditto
+    GeofenceObject* getGeofenceItem(uint32_t hwId);
+    void eraseGeofenceItem(uint32_t hwId);
+
+    /* ==== OVERFLOW ======================================================================= */
+    size_t mParkedCount; //parked GeofenceObjects in mGeofences
+    uint32_t mNextParkedId;
+    size_t mModemCapacity; //geofences loaded when the modem last ran out of room
+    bool mSwapping; //a swap of parked and loaded geofences is in flight
+    bool mRebalanced; //mRebalanceLatitude/Longitude are valid
+    double mRebalanceLatitude;
+    double mRebalanceLongitude;
+    GeofenceOverflowTimer mOverflowTimer;
+    bool mOverflowTimerActive;
+    uint32_t generateParkedHwId();
+    void rekeyGeofenceItem(uint32_t hwId, uint32_t newHwId);
+    // sends the modem the client commands a geofence missed while parked; loaded
+    // is the geofence as the modem has it
+    void syncGeofenceItem(uint32_t hwId, const GeofenceObject& loaded);
+    void swapGeofences(const std::vector<uint32_t>& outHwIds,
+                       const std::vector<uint32_t>& inHwIds);
+    void updateOverflowTimer();
 
 protected:
 
@@ -97,6 +159,20 @@ public:
     /* ======== UTILITIES ================================================================== */
     void restartGeofences();
 
+    /* ==== OVERFLOW ======================================================================= */
+    /* ======== EVENTS ====(Called from Timer Thread)======================================= */
+    void overflowTimerExpireEvent();
+    /* ======== UTILITIES ================================================================== */
+    // parks a geofence the modem has no room for, returns its parked hwId,
+    // or 0 if overflow is disabled
+    uint32_t parkGeofenceItem(LocationAPI* client, uint32_t clientId,
+                          const GeofenceOption& options, const GeofenceInfo& info);
+    // rebalances on the last known location, if there is one; force skips
+    // the GEOFENCE_OVERFLOW_MIN_MOVE_METERS check, e.g. after modem room was freed
+    void checkGeofenceOverflow(bool force);
+    // loads the parked geofences nearest to the location in place of farther loaded ones
+    void rebalanceGeofences(double latitude, double longitude, bool force);
+
     /* ==== GEOFENCES ====================================================================== */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
     uint32_t* addGeofencesCommand(LocationAPI* client, size_t count,
@@ -119,7 +195,12 @@ public:
     void resumeGeofenceItem(uint32_t hwId);
     void modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options);
     LocationError getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId);
+    void getHwIdsFromClient(LocationAPI* client, size_t count, const uint32_t* clientIds,
+                            LocationError* errs, GeofenceHwRequest& request);
     LocationError getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key);
+    // hwIds of the geofences whose circle comes within distance meters of the point
+    void getGeofencesNear(double latitude, double longitude, double distance,
+                          std::vector<uint32_t>& hwIds);
     void dump();
 
     /* ==== REPORTS ======================================================================== */
@@ -0,0 +1,184 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceIndex.h>
+#include <math.h>
+#include <algorithm>
+
+#define RAD2DEG    (180.0 / M_PI)
+#define EARTH_RADIUS_METERS (6371009.0)
+#define LON_BITS   ((GEOFENCE_INDEX_CELL_BITS + 1) / 2)
+#define LAT_BITS   (GEOFENCE_INDEX_CELL_BITS / 2)
+#define LON_CELLS  (1 << LON_BITS)
+#define LAT_CELLS  (1 << LAT_BITS)
+
+static inline int64_t getLatCell(double latitude)
+{
+    int64_t cell = (int64_t)floor((latitude + 90.0) / 180.0 * LAT_CELLS);
+    return std::min(std::max(cell, (int64_t)0), (int64_t)LAT_CELLS - 1);
+}
+
+// not wrapped around, so that the cells of a range stay ordered
+static inline int64_t getLonCell(double longitude)
+{
+    return (int64_t)floor((longitude + 180.0) / 360.0 * LON_CELLS);
+}
+
+double
+GeofenceIndex::getDistanceMeters(double lat1, double lon1, double lat2, double lon2)
+{
+    double dLat = (lat2 - lat1) / RAD2DEG;
+    double dLon = (lon2 - lon1) / RAD2DEG;
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+            cos(lat1 / RAD2DEG) * cos(lat2 / RAD2DEG) * sin(dLon / 2) * sin(dLon / 2);
+    return 2 * EARTH_RADIUS_METERS * asin(sqrt(std::min(a, 1.0)));
+}
+
+uint32_t
+GeofenceIndex::getCellKey(uint32_t latCell, uint32_t lonCell)
+{
+    // interleave the bits, longitude first, as a geohash does
+    uint32_t key = 0;
+    for (int i = LON_BITS - 1; i >= 0; i--) {
+        key = (key << 1) | ((lonCell >> i) & 1);
+        int j = i - (LON_BITS - LAT_BITS);
+        if (j >= 0) {
+            key = (key << 1) | ((latCell >> j) & 1);
+        }
+    }
+    return key;
+}
+
+bool
+GeofenceIndex::getCellRange(double latitude, double longitude, double radius,
+                            CellRange& range)
+{
+    // no more than pole to pole, also for a HUGE_VAL radius
+    double dLat = std::min(std::max(radius, 0.0) / EARTH_RADIUS_METERS * RAD2DEG, 180.0);
+    double latLow = latitude - dLat;
+    double latHigh = latitude + dLat;
+    range.latMin = getLatCell(latLow);
+    range.latMax = getLatCell(latHigh);
+
+    int64_t lonCount = LON_CELLS;
+    int64_t lonMin = 0;
+    if (latLow > -90.0 && latHigh < 90.0) {
+        double cosLat = cos(std::max(fabs(latLow), fabs(latHigh)) / RAD2DEG);
+        double dLon = dLat / cosLat;
+        if (dLon < 180.0) {
+            lonMin = getLonCell(longitude - dLon);
+            lonCount = std::min(getLonCell(longitude + dLon) - lonMin + 1, lonCount);
+        }
+    }
+    range.lonMin = (uint32_t)(((lonMin % LON_CELLS) + LON_CELLS) % LON_CELLS);
+    range.lonCount = (uint32_t)lonCount;
+
+    return (uint64_t)(range.latMax - range.latMin + 1) * range.lonCount <=
+            GEOFENCE_INDEX_MAX_CELLS;
+}
+
+void
+GeofenceIndex::insert(uint32_t hwId, double latitude, double longitude, double radius)
+{
+    CellRange range;
+    if (!getCellRange(latitude, longitude, radius, range)) {
+        mLargeHwIds.push_back(hwId);
+        return;
+    }
+    for (uint32_t lat = range.latMin; lat <= range.latMax; lat++) {
+        for (uint32_t i = 0; i < range.lonCount; i++) {
+            uint32_t lon = (range.lonMin + i) % LON_CELLS;
+            mCells[getCellKey(lat, lon)].push_back(hwId);
+        }
+    }
+}
+
+// removes one hwId from an unordered list
+static inline bool eraseHwId(std::vector<uint32_t>& hwIds, uint32_t hwId)
+{
+    auto it = std::find(hwIds.begin(), hwIds.end(), hwId);
+    if (it == hwIds.end()) {
+        return false;
+    }
+    *it = hwIds.back();
+    hwIds.pop_back();
+    return true;
+}
+
+void
+GeofenceIndex::remove(uint32_t hwId, double latitude, double longitude, double radius)
+{
+    CellRange range;
+    if (!getCellRange(latitude, longitude, radius, range)) {
+        eraseHwId(mLargeHwIds, hwId);
+        return;
+    }
+    for (uint32_t lat = range.latMin; lat <= range.latMax; lat++) {
+        for (uint32_t i = 0; i < range.lonCount; i++) {
+            uint32_t lon = (range.lonMin + i) % LON_CELLS;
+            auto it = mCells.find(getCellKey(lat, lon));
+            if (it != mCells.end() && eraseHwId(it->second, hwId) && it->second.empty()) {
+                mCells.erase(it);
+            }
+        }
+    }
+}
+
+void
+GeofenceIndex::clear()
+{
+    mCells.clear();
+    mLargeHwIds.clear();
+}
+
+bool
+GeofenceIndex::getCandidates(double latitude, double longitude, double distance,
+                             std::vector<uint32_t>& hwIds) const
+{
+    CellRange range;
+    if (!getCellRange(latitude, longitude, distance, range)) {
+        return false;
+    }
+
+    size_t first = hwIds.size();
+    hwIds.insert(hwIds.end(), mLargeHwIds.begin(), mLargeHwIds.end());
+    for (uint32_t lat = range.latMin; lat <= range.latMax; lat++) {
+        for (uint32_t i = 0; i < range.lonCount; i++) {
+            uint32_t lon = (range.lonMin + i) % LON_CELLS;
+            auto it = mCells.find(getCellKey(lat, lon));
+            if (it != mCells.end()) {
+                hwIds.insert(hwIds.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+
+    // a geofence is listed in every cell it overlaps
+    std::sort(hwIds.begin() + first, hwIds.end());
+    hwIds.erase(std::unique(hwIds.begin() + first, hwIds.end()), hwIds.end());
+    return true;
+}
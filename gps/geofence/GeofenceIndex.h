@@ -0,0 +1,80 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_INDEX_H
+#define GEOFENCE_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <unordered_map>
+
+// bits of a cell key, interleaved longitude first as in a geohash;
+// 25 bits is a 5 character geohash, cells of about 4.9 x 4.9 km at the equator
+#define GEOFENCE_INDEX_CELL_BITS (25)
+// geofences covering more cells than this are not put in the grid,
+// but kept in a list that every query returns
+#define GEOFENCE_INDEX_MAX_CELLS (64)
+
+typedef std::unordered_map<uint32_t, std::vector<uint32_t>> GeofenceCellMap; //cell key to hwIds
+
+/* Grid of geohash cells over the circular geofences, to find the geofences near
+   a point without going through all of them. A geofence is listed in each cell
+   its bounding box overlaps. Not thread safe, owned by the adapter thread. */
+class GeofenceIndex {
+    GeofenceCellMap mCells;
+    std::vector<uint32_t> mLargeHwIds;
+
+    typedef struct {
+        uint32_t latMin;
+        uint32_t latMax;
+        uint32_t lonMin;
+        uint32_t lonCount;
+    } CellRange;
+    // cells of the bounding box of a circle, false if there are too many of them
+    static bool getCellRange(double latitude, double longitude, double radius,
+                             CellRange& range);
+    static uint32_t getCellKey(uint32_t latCell, uint32_t lonCell);
+
+public:
+    void insert(uint32_t hwId, double latitude, double longitude, double radius);
+    // latitude, longitude and radius must be those hwId was inserted with
+    void remove(uint32_t hwId, double latitude, double longitude, double radius);
+    void clear();
+    // appends the hwIds of the geofences that may lie within distance meters of the
+    // point; these are candidates from the grid, callers do the exact test.
+    // false if distance spans too many cells to beat going through all geofences
+    bool getCandidates(double latitude, double longitude, double distance,
+                       std::vector<uint32_t>& hwIds) const;
+    inline size_t getCellCount() const { return mCells.size(); }
+
+    // great circle distance in meters between two points given in degrees
+    static double getDistanceMeters(double lat1, double lon1, double lat2, double lon2);
+};
+
+#endif /* GEOFENCE_INDEX_H */
@@ -45,5 +45,23 @@ LOCAL_PRELINK_MODULE := false
 
 include $(BUILD_SHARED_LIBRARY)
 
+# Counts and times what reporting a fix to 1, 4 and 16 clients costs, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := gnss_report_bench
+LOCAL_SRC_FILES := gnss_report_bench.cpp
+LOCAL_SHARED_LIBRARIES := \
+    libgnss \
+    libloc_core \
+    libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libgps.utils_headers \
+    libloc_core_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
 endif # not BUILD_TINY_ANDROID
 endif # BOARD_VENDOR_QCOM_GPS_LOC_API_HARDWARE
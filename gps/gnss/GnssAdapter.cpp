@@ -40,11 +40,11 @@
 #include <netdb.h>
 #include <GnssAdapter.h>
 #include <string>
-#include <sstream>
 #include <loc_log.h>
 #include <loc_nmea.h>
 #include <Agps.h>
 #include <SystemStatus.h>
+#include <LocConfWatcher.h>
 #include <vector>
 
 #define RAD2DEG    (180.0 / M_PI)
@@ -61,6 +61,19 @@ static void agpsOpenResultCb (bool isSuccess, AGpsExtType agpsType, const char*
         AGpsBearerType bearerType, void* userDataPtr);
 static void agpsCloseResultCb (bool isSuccess, AGpsExtType agpsType, void* userDataPtr);
 
+// NMEA sentence types the modem is to generate for a NMEA_PROVIDER
+static uint32_t getConfigNmeaMask(uint32_t nmeaProvider)
+{
+    uint32_t mask = 0;
+    if (NMEA_PROVIDER_MP == nmeaProvider) {
+        mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
+    }
+    if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
+        mask |= LOC_NMEA_MASK_DEBUG_V02;
+    }
+    return mask;
+}
+
 GnssAdapter::GnssAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(NULL,
@@ -69,6 +82,7 @@ GnssAdapter::GnssAdapter() :
                                              false),
                    true, nullptr, true),
     mEngHubProxy(new EngineHubProxyBase()),
+    mTrackingReportStats(),
     mLocPositionMode(),
     mNHzNeeded(false),
     mSPEAlreadyRunningAtHighestInterval(false),
@@ -681,15 +695,8 @@ GnssAdapter::readConfigCommand()
                 confReadDone = true;
                 // reads config into mContext->mGps_conf
                 mContext.readConfig();
-
-                uint32_t allowFlpNetworkFixes = 0;
-                static const loc_param_s_type flp_conf_param_table[] =
-                {
-                    {"ALLOW_NETWORK_FIXES", &allowFlpNetworkFixes, NULL, 'n'},
-                };
-                UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
-                LOC_LOGd("allowFlpNetworkFixes %u", allowFlpNetworkFixes);
-                mAdapter->setAllowFlpNetworkFixes(allowFlpNetworkFixes);
+                mAdapter->readFlpConfig();
+                mAdapter->watchConfig();
             }
         }
     };
@@ -699,6 +706,71 @@ GnssAdapter::readConfigCommand()
     }
 }
 
+void
+GnssAdapter::readFlpConfig()
+{
+    uint32_t allowFlpNetworkFixes = 0;
+    const loc_param_s_type flp_conf_param_table[] =
+    {
+        {"ALLOW_NETWORK_FIXES", &allowFlpNetworkFixes, NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
+    LOC_LOGd("allowFlpNetworkFixes %u", allowFlpNetworkFixes);
+    setAllowFlpNetworkFixes(allowFlpNetworkFixes);
+}
+
+void
+GnssAdapter::watchConfig()
+{
+    // the watcher only posts to our MsgTask, the reload itself runs here
+    LocConfWatcher& watcher = LocConfWatcher::getInstance();
+    for (const char* confPath : {LOC_PATH_GPS_CONF, LOC_PATH_FLP_CONF}) {
+        if (0 == watcher.addWatch(confPath, [this] (const char* path) {
+                reloadConfigCommand(path);
+            })) {
+            LOC_LOGw("%s edits will need a restart to take effect", confPath);
+        }
+    }
+}
+
+void
+GnssAdapter::reloadConfigCommand(const char* confPath)
+{
+    struct MsgReloadConfig : public LocMsg {
+        GnssAdapter& mAdapter;
+        const std::string mConfPath;
+        inline MsgReloadConfig(GnssAdapter& adapter, const char* confPath) :
+            LocMsg(),
+            mAdapter(adapter),
+            mConfPath(confPath) {}
+        inline virtual void proc() const {
+            mAdapter.reloadConfig(mConfPath);
+        }
+    };
+
+    sendMsg(new MsgReloadConfig(*this, confPath));
+}
+
+void
+GnssAdapter::reloadConfig(const std::string& confPath)
+{
+    if (confPath == LOC_PATH_GPS_CONF) {
+        LocConfChangeMask changed = mContext->reloadConfig();
+        // LOC_CONF_CHANGE_FIX_FILTER and LOC_CONF_CHANGE_LOGGING are in
+        // effect already, NMEA needs the modem and the event mask updated
+        if (changed & LOC_CONF_CHANGE_NMEA) {
+            uint32_t mask = getConfigNmeaMask(ContextBase::mGps_conf.NMEA_PROVIDER);
+            if (mNmeaMask != mask) {
+                mNmeaMask = mask;
+                updateNmeaMask(mNmeaMask);
+                updateClientsEventMask();
+            }
+        }
+    } else if (confPath == LOC_PATH_FLP_CONF) {
+        readFlpConfig();
+    }
+}
+
 void
 GnssAdapter::setSuplHostServer(const char* server, int port, LocServerType type)
 {
@@ -736,18 +808,13 @@ GnssAdapter::setConfig()
     LOC_LOGD("%s]: ", __func__);
 
     // set nmea mask type
-    uint32_t mask = 0;
-    if (NMEA_PROVIDER_MP == ContextBase::mGps_conf.NMEA_PROVIDER) {
-        mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
-    }
-    if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
-        mask |= LOC_NMEA_MASK_DEBUG_V02;
-    }
+    uint32_t mask = getConfigNmeaMask(ContextBase::mGps_conf.NMEA_PROVIDER);
     if (mNmeaMask != mask) {
         mNmeaMask = mask;
         if (mNmeaMask) {
             for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-                if ((it->second.gnssNmeaCb != nullptr)) {
+                if ((it->second.gnssNmeaCb != nullptr) ||
+                    (it->second.gnssNmeaSentencesCb != nullptr)) {
                     updateEvtMask(LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT,
                                   LOC_REGISTRATION_MASK_ENABLED);
                     break;
@@ -818,13 +885,7 @@ GnssAdapter::setConfig()
         gnssUpdateConfig(oldMoServerUrl, gnssConfigRequested, gnssConfigRequested);
 
         // set nmea mask type
-        uint32_t mask = 0;
-        if (NMEA_PROVIDER_MP == gpsConf.NMEA_PROVIDER) {
-            mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
-        }
-        if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
-            mask |= LOC_NMEA_MASK_DEBUG_V02;
-        }
+        uint32_t mask = getConfigNmeaMask(gpsConf.NMEA_PROVIDER);
 
         if (mask != 0) {
             mLocApi->setNMEATypesSync(mask);
@@ -2231,16 +2292,19 @@ GnssAdapter::updateClientsEventMask()
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (it->second.trackingCb != nullptr ||
             it->second.gnssLocationInfoCb != nullptr ||
+            it->second.gnssLocationInfoRefCb != nullptr ||
             it->second.engineLocationsInfoCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_PARSED_POSITION_REPORT;
         }
-        if (it->second.gnssSvCb != nullptr) {
+        if (it->second.gnssSvCb != nullptr || it->second.gnssSvRefCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_SATELLITE_REPORT;
         }
-        if ((it->second.gnssNmeaCb != nullptr) && (mNmeaMask)) {
+        if ((it->second.gnssNmeaCb != nullptr || it->second.gnssNmeaSentencesCb != nullptr) &&
+            (mNmeaMask)) {
             mask |= LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT;
         }
-        if (it->second.gnssMeasurementsCb != nullptr) {
+        if (it->second.gnssMeasurementsCb != nullptr ||
+            it->second.gnssMeasurementsRefCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_GNSS_MEASUREMENT;
         }
         if (it->second.gnssDataCb != nullptr) {
@@ -2443,7 +2507,8 @@ GnssAdapter::hasCallbacksToStartTracking(LocationAPI* client)
     auto it = mClientData.find(client);
     if (it != mClientData.end()) {
         if (it->second.trackingCb || it->second.gnssLocationInfoCb ||
-            it->second.engineLocationsInfoCb || it->second.gnssMeasurementsCb) {
+            it->second.gnssLocationInfoRefCb || it->second.engineLocationsInfoCb ||
+            it->second.gnssMeasurementsCb || it->second.gnssMeasurementsRefCb) {
             allowed = true;
         } else {
             LOC_LOGi("missing right callback to start tracking")
@@ -2501,6 +2566,8 @@ GnssAdapter::saveTrackingSession(LocationAPI* client, uint32_t sessionId,
                                 const TrackingOptions& options)
 {
     LocationSessionKey key(client, sessionId);
+    // the client gets the next fix, whatever its new rate
+    mTrackingReportStates.erase(client);
     if ((options.minDistance > 0) &&
             ContextBase::isMessageSupported(LOC_API_ADAPTER_MESSAGE_DISTANCE_BASE_TRACKING)) {
         mDistanceBasedTrackingSessions[key] = options;
@@ -2523,6 +2590,14 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
             mDistanceBasedTrackingSessions.erase(itr);
         }
     }
+    mTrackingReportStates.erase(client);
+    if (mTimeBasedTrackingSessions.empty() && mTrackingReportStats.epochs > 0) {
+        LOC_LOGi("fixes %u, converted %u, copied %u, callbacks %u, decimated %u",
+                 mTrackingReportStats.epochs, mTrackingReportStats.conversions,
+                 mTrackingReportStats.copies, mTrackingReportStats.callbacks,
+                 mTrackingReportStats.decimated);
+        mTrackingReportStats = {};
+    }
     reportPowerStateIfChanged();
 }
 
@@ -2613,6 +2688,16 @@ GnssAdapter::startTrackingCommand(LocationAPI* client, TrackingOptions& options)
             mSessionId(sessionId),
             mOptions(options) {}
         inline virtual void proc() const {
+            // cost of the configuration files read from HAL load to first tracking
+            static bool confStatsLogged = false;
+            if (!confStatsLogged) {
+                confStatsLogged = true;
+                loc_conf_stats_s_type confStats;
+                loc_get_conf_stats(&confStats);
+                LOC_LOGi("conf files opened %u, cache hits %u, parse time %" PRIu64 " us",
+                         confStats.file_opens, confStats.cache_hits,
+                         confStats.parse_time_ns / 1000);
+            }
             // distance based tracking will need to know engine capabilities before it can start
             if (!mAdapter.isEngineCapabilitiesKnown() && mOptions.minDistance > 0) {
                 mAdapter.mPendingMsgs.push_back(new MsgStartTracking(*this));
@@ -3332,7 +3417,7 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
     // Fix is from QMI, and it is not an unpropagated position and engine hub
     // is not loaded, queue the message when message is processed, the position
     // can be dispatched to requesting client that registers for SPE report
-    struct MsgReportPosition : public LocMsg {
+    struct MsgReportPosition : public LocMsg, public LocPooledMsg {
         GnssAdapter& mAdapter;
         const UlpLocation mUlpLocation;
         const GpsLocationExtended mLocationExtended;
@@ -3383,14 +3468,14 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
 
     sendMsg(new MsgReportPosition(*this, ulpLocation, locationExtended,
                                   status, techMask,
-                                  pDataNotify, msInWeek));
+                                  pDataNotify, msInWeek), LOC_MSG_PRIORITY_HIGH);
 }
 
 void
 GnssAdapter::reportEnginePositionsEvent(unsigned int count,
                                         EngineLocationInfo* locationArr)
 {
-    struct MsgReportEnginePositions : public LocMsg {
+    struct MsgReportEnginePositions : public LocMsg, public LocPooledMsg {
         GnssAdapter& mAdapter;
         unsigned int mCount;
         EngineLocationInfo mEngLocInfo[LOC_OUTPUT_ENGINE_COUNT];
@@ -3412,7 +3497,7 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
         }
     };
 
-    sendMsg(new MsgReportEnginePositions(*this, count, locationArr));
+    sendMsg(new MsgReportEnginePositions(*this, count, locationArr), LOC_MSG_PRIORITY_HIGH);
 }
 
 bool
@@ -3447,12 +3532,118 @@ bool
 GnssAdapter::isFlpClient(LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssLocationInfoCb == nullptr &&
+            locationCallbacks.gnssLocationInfoRefCb == nullptr &&
             locationCallbacks.gnssSvCb == nullptr &&
+            locationCallbacks.gnssSvRefCb == nullptr &&
             locationCallbacks.gnssNmeaCb == nullptr &&
+            locationCallbacks.gnssNmeaSentencesCb == nullptr &&
             locationCallbacks.gnssDataCb == nullptr &&
-            locationCallbacks.gnssMeasurementsCb == nullptr);
+            locationCallbacks.gnssMeasurementsCb == nullptr &&
+            locationCallbacks.gnssMeasurementsRefCb == nullptr);
 }
 
+bool
+GnssAdapter::isTrackingReportDue(LocationAPI* client, const UlpLocation& ulpLocation,
+                                 enum loc_sess_status status)
+{
+    // the engine runs at the smallest interval of all the time based
+    // sessions, a client gets fixes at the smallest interval of its own
+    bool hasTimeBasedSession = false;
+    uint32_t minInterval = 0;
+    for (auto it = mTimeBasedTrackingSessions.begin();
+            it != mTimeBasedTrackingSessions.end(); ++it) {
+        if (client == it->first.client) {
+            if (!hasTimeBasedSession || it->second.minInterval < minInterval) {
+                minInterval = it->second.minInterval;
+            }
+            hasTimeBasedSession = true;
+        }
+    }
+    // clients not tracking, tracking at the engine's interval, or tracking
+    // by distance too, which the modem paces, get every fix as before.
+    // A time based session keeps its minDistance only when the modem has
+    // no distance based tracking, and then the engine does not apply it
+    // either, so neither is it applied here.
+    if (!hasTimeBasedSession || minInterval <= mLocPositionMode.min_interval) {
+        return true;
+    }
+    for (auto it = mDistanceBasedTrackingSessions.begin();
+            it != mDistanceBasedTrackingSessions.end(); ++it) {
+        if (client == it->first.client) {
+            return true;
+        }
+    }
+
+    const LocGpsLocation& fix = ulpLocation.gpsLocation;
+    if (0 == fix.timestamp) {
+        return true;
+    }
+    auto state = mTrackingReportStates.find(client);
+    if (state != mTrackingReportStates.end()) {
+        // half an engine interval of slack, so that a fix a little early
+        // on its epoch is not held back for a whole epoch
+        int64_t elapsed = fix.timestamp - state->second.timestamp +
+                mLocPositionMode.min_interval / 2;
+        if (elapsed >= 0 && elapsed < (int64_t)minInterval) {
+            return false;
+        }
+    }
+    // only the final fix of an epoch takes the client's slot, intermediate
+    // fixes ahead of it go out without holding it back
+    if (LOC_SESS_SUCCESS == status) {
+        mTrackingReportStates[client] = {fix.timestamp};
+    }
+    return true;
+}
+
+// A fix as reported to the clients of one epoch. It is converted on first
+// use only, then lent to every client by reference, unchanged.
+class GnssLocationInfoEpoch {
+    const UlpLocation& mUlpLocation;
+    const GpsLocationExtended& mLocationExtended;
+    const LocPosTechMask mTechMask;
+    TrackingReportStats& mStats;
+    bool mConverted;
+    bool mEngineConverted;
+    GnssLocationInfoNotification mLocationInfo;
+    // mLocationInfo marked as the fused fix, then as is for the SPE fix
+    GnssLocationInfoNotification mEngineLocationsInfo[2];
+public:
+    inline GnssLocationInfoEpoch(const UlpLocation& ulpLocation,
+                                 const GpsLocationExtended& locationExtended,
+                                 LocPosTechMask techMask, TrackingReportStats& stats) :
+        mUlpLocation(ulpLocation), mLocationExtended(locationExtended),
+        mTechMask(techMask), mStats(stats), mConverted(false), mEngineConverted(false) {}
+
+    const GnssLocationInfoNotification& getLocationInfo() {
+        if (!mConverted) {
+            mConverted = true;
+            mStats.conversions++;
+            mLocationInfo = {};
+            GnssAdapter::convertLocationInfo(mLocationInfo, mLocationExtended);
+            GnssAdapter::convertLocation(mLocationInfo.location, mUlpLocation,
+                                         mLocationExtended, mTechMask);
+        }
+        return mLocationInfo;
+    }
+
+    // for engineLocationsInfoCb while the engine hub is disabled, i.e. the
+    // fix is the SPE fix from the modem, reported both as fused and as SPE.
+    // engineLocationsInfoCb takes no const, but like in
+    // reportEnginePositions() the clients share the array, read only.
+    GnssLocationInfoNotification* getEngineLocationsInfo() {
+        if (!mEngineConverted) {
+            mEngineConverted = true;
+            mStats.copies += 2;
+            mEngineLocationsInfo[0] = getLocationInfo();
+            mEngineLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
+            mEngineLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
+            mEngineLocationsInfo[1] = getLocationInfo();
+        }
+        return mEngineLocationsInfo;
+    }
+};
+
 void
 GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                             const GpsLocationExtended& locationExtended,
@@ -3463,28 +3654,37 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
     bool reportToFlpClient = needReportForFlpClient(status, techMask);
 
     if (reportToGnssClient || reportToFlpClient) {
-        GnssLocationInfoNotification locationInfo = {};
-        convertLocationInfo(locationInfo, locationExtended);
-        convertLocation(locationInfo.location, ulpLocation, locationExtended, techMask);
+        GnssLocationInfoEpoch epoch(ulpLocation, locationExtended, techMask,
+                                    mTrackingReportStats);
+        mTrackingReportStats.epochs++;
+        // loaded once, so the same for all the clients of the fix
+        bool engHubEnabled = initEngHubProxy();
 
         for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
             if ((reportToFlpClient && isFlpClient(it->second)) ||
                     (reportToGnssClient && !isFlpClient(it->second))) {
-                if (nullptr != it->second.gnssLocationInfoCb) {
-                    it->second.gnssLocationInfoCb(locationInfo);
+                if (nullptr == it->second.gnssLocationInfoRefCb &&
+                        nullptr == it->second.gnssLocationInfoCb &&
+                        (nullptr == it->second.engineLocationsInfoCb || engHubEnabled) &&
+                        nullptr == it->second.trackingCb) {
+                    continue;
+                }
+                if (!isTrackingReportDue(it->first, ulpLocation, status)) {
+                    mTrackingReportStats.decimated++;
+                    continue;
+                }
+                mTrackingReportStats.callbacks++;
+                if (nullptr != it->second.gnssLocationInfoRefCb) {
+                    it->second.gnssLocationInfoRefCb(epoch.getLocationInfo());
+                } else if (nullptr != it->second.gnssLocationInfoCb) {
+                    // the by-value callback takes at least one copy, its parameter
+                    mTrackingReportStats.copies++;
+                    it->second.gnssLocationInfoCb(epoch.getLocationInfo());
                 } else if ((nullptr != it->second.engineLocationsInfoCb) &&
-                        (false == initEngHubProxy())) {
-                    // if engine hub is disabled, this is SPE fix from modem
-                    // we need to mark one copy marked as fused and one copy marked as PPE
-                    // and dispatch it to the engineLocationsInfoCb
-                    GnssLocationInfoNotification engLocationsInfo[2];
-                    engLocationsInfo[0] = locationInfo;
-                    engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
-                    engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
-                    engLocationsInfo[1] = locationInfo;
-                    it->second.engineLocationsInfoCb(2, engLocationsInfo);
+                        (false == engHubEnabled)) {
+                    it->second.engineLocationsInfoCb(2, epoch.getEngineLocationsInfo());
                 } else if (nullptr != it->second.trackingCb) {
-                    it->second.trackingCb(locationInfo.location);
+                    it->second.trackingCb(epoch.getLocationInfo().location);
                 }
             }
         }
@@ -3503,11 +3703,12 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
 
             // if PACE is enabled
             if ((true == mLocConfigInfo.paceConfigInfo.isValid) &&
-                    (true == mLocConfigInfo.paceConfigInfo.enable)) {
+                    (true == mLocConfigInfo.paceConfigInfo.enable) &&
+                    (LOC_POS_TECH_MASK_SENSORS & techMask)) {
+                const GnssLocationInfoNotification& locationInfo = epoch.getLocationInfo();
                 // If fix has sensor contribution, and it is fused fix with DRE engine
                 // contributing to the fix, inject to modem
-                if ((LOC_POS_TECH_MASK_SENSORS & techMask) &&
-                        (locationInfo.flags & GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT) &&
+                if ((locationInfo.flags & GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT) &&
                         (locationInfo.locOutputEngType == LOC_OUTPUT_ENGINE_FUSED) &&
                         (locationInfo.flags & GNSS_LOCATION_INFO_OUTPUT_ENG_MASK_BIT) &&
                         (locationInfo.locOutputEngMask & DEAD_RECKONING_ENGINE)) {
@@ -3526,15 +3727,12 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                           (LOC_RELIABILITY_NOT_SET == locationExtended.horizontal_reliability));
         uint8_t generate_nmea = (reportToGnssClient && status != LOC_SESS_FAILURE && !blank_fix);
         bool custom_nmea_gga = (1 == ContextBase::mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED);
-        std::vector<std::string> nmeaArraystr;
+        LocNmeaBuffer nmeaBuffer;
+        loc_nmea_buffer_init(nmeaBuffer, mNmeaGenText, sizeof(mNmeaGenText),
+                             mNmeaGenSentences, LOC_NMEA_MAX_SENTENCES);
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo,
-                              generate_nmea, custom_nmea_gga, nmeaArraystr);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+                              generate_nmea, custom_nmea_gga, nmeaBuffer);
+        reportNmea(nmeaBuffer);
     }
 }
 
@@ -3591,7 +3789,7 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     }
 
-    struct MsgReportSv : public LocMsg {
+    struct MsgReportSv : public LocMsg, public LocPooledMsg {
         GnssAdapter& mAdapter;
         const GnssSvNotification mSvNotify;
         inline MsgReportSv(GnssAdapter& adapter,
@@ -3604,7 +3802,7 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     };
 
-    sendMsg(new MsgReportSv(*this, svNotify));
+    sendMsg(new MsgReportSv(*this, svNotify), LOC_MSG_PRIORITY_HIGH);
 }
 
 void
@@ -3746,22 +3944,23 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
         }
     }
 
+    // svNotify is the copy held by MsgReportSv, lend it to by-reference
+    // clients and only copy it for clients still using the by-value callback
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssSvCb) {
+        if (nullptr != it->second.gnssSvRefCb) {
+            it->second.gnssSvRefCb(svNotify);
+        } else if (nullptr != it->second.gnssSvCb) {
             it->second.gnssSvCb(svNotify);
         }
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
         !mTimeBasedTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+        LocNmeaBuffer nmeaBuffer;
+        loc_nmea_buffer_init(nmeaBuffer, mNmeaGenText, sizeof(mNmeaGenText),
+                             mNmeaGenSentences, LOC_NMEA_MAX_SENTENCES);
+        loc_nmea_generate_sv(svNotify, nmeaBuffer);
+        reportNmea(nmeaBuffer);
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -3776,7 +3975,7 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         return;
     }
 
-    struct MsgReportNmea : public LocMsg {
+    struct MsgReportNmea : public LocMsg, public LocPooledMsg {
         GnssAdapter& mAdapter;
         const char* mNmea;
         size_t mLength;
@@ -3785,17 +3984,13 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
                              size_t length) :
             LocMsg(),
             mAdapter(adapter),
-            mNmea(new char[length+1]),
+            mNmea((const char*)LocMsg::poolAlloc(length+1)),
             mLength(length) {
-                if (mNmea == nullptr) {
-                    LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
-                    return;
-                }
                 strlcpy((char*)mNmea, nmea, length+1);
             }
         inline virtual ~MsgReportNmea()
         {
-            delete[] mNmea;
+            LocMsg::poolFree((void*)mNmea);
         }
         inline virtual void proc() const {
             // extract bug report info - this returns true if consumed by systemstatus
@@ -3814,21 +4009,61 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
     sendMsg(new MsgReportNmea(*this, nmea, length));
 }
 
+void
+GnssAdapter::reportNmea(const LocNmeaBuffer& nmeaBuffer)
+{
+    // the generated sentences are already split and NULL terminated,
+    // hand them out in place
+    mNmeaSentences.assign(nmeaBuffer.sentences, nmeaBuffer.sentences + nmeaBuffer.count);
+    notifyNmea(nullptr, 0);
+}
+
 void
 GnssAdapter::reportNmea(const char* nmea, size_t length)
 {
-    GnssNmeaNotification nmeaNotification = {};
-    nmeaNotification.size = sizeof(GnssNmeaNotification);
+    mNmeaSentences.clear();
+    notifyNmea(nmea, length);
+}
+
+void
+GnssAdapter::notifyNmea(const char* nmea, size_t length)
+{
+    // only one of the nmea text and mNmeaSentences is given, the other one
+    // is built in mNmeaBuffer the first time a client needs it
+    bool hasText = (nullptr != nmea);
+    bool hasSentences = !hasText;
 
     struct timeval tv;
     gettimeofday(&tv, (struct timezone *) NULL);
     int64_t now = tv.tv_sec * 1000LL + tv.tv_usec / 1000;
-    nmeaNotification.timestamp = now;
-    nmeaNotification.nmea = nmea;
-    nmeaNotification.length = length;
 
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssNmeaCb) {
+        if (nullptr != it->second.gnssNmeaSentencesCb) {
+            if (!hasSentences) {
+                loc_nmea_split(nmea, length, mNmeaBuffer, mNmeaSentences);
+                hasSentences = true;
+            }
+            GnssNmeaSentencesNotification sentencesNotification = {};
+            sentencesNotification.size = sizeof(GnssNmeaSentencesNotification);
+            sentencesNotification.timestamp = now;
+            sentencesNotification.count = mNmeaSentences.size();
+            sentencesNotification.sentences = mNmeaSentences.data();
+            it->second.gnssNmeaSentencesCb(sentencesNotification);
+        } else if (nullptr != it->second.gnssNmeaCb) {
+            if (!hasText) {
+                mNmeaBuffer.clear();
+                for (auto itor = mNmeaSentences.begin(); itor != mNmeaSentences.end(); ++itor) {
+                    mNmeaBuffer.append(itor->sentence, itor->length);
+                }
+                nmea = mNmeaBuffer.c_str();
+                length = mNmeaBuffer.length();
+                hasText = true;
+            }
+            GnssNmeaNotification nmeaNotification = {};
+            nmeaNotification.size = sizeof(GnssNmeaNotification);
+            nmeaNotification.timestamp = now;
+            nmeaNotification.nmea = nmea;
+            nmeaNotification.length = length;
             it->second.gnssNmeaCb(nmeaNotification);
         }
     }
@@ -3838,7 +4073,7 @@ void
 GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
                              int msInWeek)
 {
-    struct MsgReportData : public LocMsg {
+    struct MsgReportData : public LocMsg, public LocPooledMsg {
         GnssAdapter& mAdapter;
         GnssDataNotification mDataNotify;
         int mMsInWeek;
@@ -3952,7 +4187,8 @@ GnssAdapter::requestNiNotifyEvent(const GnssNiNotification &notify, const void*
         }
     };
 
-    sendMsg(new MsgReportNiNotify(*this, *mLocApi, notify, data, emergencyState));
+    sendMsg(new MsgReportNiNotify(*this, *mLocApi, notify, data, emergencyState),
+            LOC_MSG_PRIORITY_HIGH);
 
     return true;
 }
@@ -4168,9 +4404,8 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     LOC_LOGD("%s]: msInWeek=%d", __func__, msInWeek);
 
     if (0 != gnssMeasurements.gnssMeasNotification.count) {
-        struct MsgReportGnssMeasurementData : public LocMsg {
+        struct MsgReportGnssMeasurementData : public LocMsg, public LocPooledMsg {
             GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
             GnssMeasurementsNotification mMeasurementsNotify;
             inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
                                                 const GnssMeasurements& gnssMeasurements,
@@ -4195,8 +4430,12 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
 void
 GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
 {
+    // measurements is the copy held by MsgReportGnssMeasurementData, lend it to
+    // by-reference clients and only copy it for by-value clients
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssMeasurementsCb) {
+        if (nullptr != it->second.gnssMeasurementsRefCb) {
+            it->second.gnssMeasurementsRefCb(measurements);
+        } else if (nullptr != it->second.gnssMeasurementsCb) {
             it->second.gnssMeasurementsCb(measurements);
         }
     }
@@ -4875,8 +5114,15 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         return false;
     }
 
+    // copy only the latest of the reports the debug report is built from
     SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    systemstatus->getReport(reports,
+                            SYSTEM_STATUS_REPORT_LOCATION_BIT |
+                            SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT |
+                            SYSTEM_STATUS_REPORT_BEST_POSITION_BIT |
+                            SYSTEM_STATUS_REPORT_XTRA_BIT |
+                            SYSTEM_STATUS_REPORT_SV_HEALTH_BIT |
+                            SYSTEM_STATUS_REPORT_NAV_DATA_BIT, 1);
 
     r.size = sizeof(r);
 
@@ -4983,7 +5229,9 @@ GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int m
 
     if (nullptr != systemstatus) {
         SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        systemstatus->getReport(reports,
+                                SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT |
+                                SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT, 1);
 
         if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
             (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
@@ -5038,7 +5286,9 @@ GnssAdapter::getDataInformation(GnssDataNotification& data, int msInWeek)
     LOC_LOGV("%s]: msInWeek=%d", __func__, msInWeek);
     if (nullptr != systemstatus) {
         SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        systemstatus->getReport(reports,
+                                SYSTEM_STATUS_REPORT_TIME_AND_CLOCK_BIT |
+                                SYSTEM_STATUS_REPORT_RF_AND_PARAMS_BIT, 1);
 
         if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
             (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
@@ -37,6 +37,7 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
+#include <loc_nmea.h>
 #include <map>
 
 #define MAX_URL_LEN 256
@@ -48,6 +49,7 @@
 #define ODCPI_EXPECTED_INJECTION_TIME_MS 10000
 
 class GnssAdapter;
+class GnssLocationInfoEpoch;
 
 typedef std::map<LocationSessionKey, LocationOptions> LocationSessionMap;
 typedef std::map<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
@@ -66,8 +68,8 @@ public:
         LocTimer::stop();
     }
     inline void restart() {
-        stop();
-        start();
+        mActive = true;
+        LocTimer::restart(ODCPI_EXPECTED_INJECTION_TIME_MS, false);
     }
     inline bool isActive() {
         return mActive;
@@ -140,6 +142,22 @@ typedef struct {
     bool enableFor911;
 } RobustLocationConfigInfo;
 
+/* the last fix delivered to a client of time based tracking sessions,
+   which gets fixes at its own rate rather than the engine's */
+typedef struct {
+    LocGpsUtcTime timestamp;
+} TrackingReportState;
+typedef std::map<LocationAPI*, TrackingReportState> TrackingReportStateMap;
+
+/* counters of reportPosition(), logged when time based tracking stops */
+typedef struct {
+    uint32_t epochs;      // fixes reported to the adapter
+    uint32_t conversions; // ... converted for clients
+    uint32_t copies;      // ... copied again for clients
+    uint32_t callbacks;   // client callbacks made
+    uint32_t decimated;   // client callbacks held back, as not due yet
+} TrackingReportStats;
+
 typedef struct {
     TuncConfigInfo tuncConfigInfo;
     PaceConfigInfo paceConfigInfo;
@@ -168,6 +186,9 @@ class GnssAdapter : public LocAdapterBase {
     /* ==== TRACKING ======================================================================= */
     TrackingOptionsMap mTimeBasedTrackingSessions;
     LocationSessionMap mDistanceBasedTrackingSessions;
+    TrackingReportStateMap mTrackingReportStates;
+    TrackingReportStats mTrackingReportStats;
+    friend class GnssLocationInfoEpoch;
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
     bool mGnssSvIdUsedInPosAvail;
@@ -178,6 +199,10 @@ class GnssAdapter : public LocAdapterBase {
     LocationControlCallbacks mControlCallbacks;
     uint32_t mAfwControlId;
     uint32_t mNmeaMask;
+    std::string mNmeaBuffer;
+    std::vector<GnssNmeaSentence> mNmeaSentences;
+    char mNmeaGenText[LOC_NMEA_BUFFER_SIZE];
+    GnssNmeaSentence mNmeaGenSentences[LOC_NMEA_MAX_SENTENCES];
     GnssSvIdConfig mGnssSvIdConfig;
     GnssSvTypeConfig mGnssSvTypeConfig;
     GnssSvTypeConfigCallback mGnssSvTypeConfigCb;
@@ -321,6 +346,9 @@ public:
     void disableCommand(uint32_t id);
     void setControlCallbacksCommand(LocationControlCallbacks& controlCallbacks);
     void readConfigCommand();
+    /* re-reads confPath, one of the conf files watched since readConfigCommand(),
+       once it has been edited */
+    void reloadConfigCommand(const char* confPath);
     void requestUlpCommand();
     void initEngHubProxyCommand();
     uint32_t* gnssUpdateConfigCommand(GnssConfig config);
@@ -353,6 +381,9 @@ public:
     inline GnssSvTypeConfigCallback gnssGetSvTypeConfigCallback()
     { return mGnssSvTypeConfigCb; }
     void setConfig();
+    void readFlpConfig();
+    void watchConfig();
+    void reloadConfig(const std::string& confPath);
 
     /* ========= AGPS ====================================================================== */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
@@ -432,6 +463,10 @@ public:
     bool needReportForGnssClient(const UlpLocation& ulpLocation,
             enum loc_sess_status status, LocPosTechMask techMask);
     bool needReportForFlpClient(enum loc_sess_status status, LocPosTechMask techMask);
+    bool isTrackingReportDue(LocationAPI* client, const UlpLocation& ulpLocation,
+                             enum loc_sess_status status);
+    /* to be called on the adapter's thread, or from a client callback */
+    inline TrackingReportStats getTrackingReportStats() { return mTrackingReportStats; }
     void reportPosition(const UlpLocation &ulpLocation,
                         const GpsLocationExtended &locationExtended,
                         enum loc_sess_status status,
@@ -440,6 +475,8 @@ public:
                                const EngineLocationInfo* locationArr);
     void reportSv(GnssSvNotification& svNotify);
     void reportNmea(const char* nmea, size_t length);
+    void reportNmea(const LocNmeaBuffer& nmeaBuffer);
+    void notifyNmea(const char* nmea, size_t length);
     void reportData(GnssDataNotification& dataNotify);
     bool requestNiNotify(const GnssNiNotification& notify, const void* data,
                          const bool bInformNiAccept);
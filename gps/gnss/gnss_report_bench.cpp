@@ -0,0 +1,239 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Reports <fixes> SPE fixes through GnssAdapter::reportPositionEvent() to 1,
+// 4 and 16 clients of each location callback, with the engine hub disabled:
+//     gnss_report_bench [<fixes>]
+// Reported per fix are the adapter's own TrackingReportStats, i.e. the
+// notifications converted, and copied again, for the clients, the callbacks
+// made, and the time from the report until the last client got it.
+
+#include <GnssAdapter.h>
+#include <LocApiBase.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+
+#define MAX_CLIENTS 16
+
+// the adapter uses the clients only as keys
+static char sClientKeys[MAX_CLIENTS];
+
+// Done once the last client got the last fix
+struct Delivery {
+    mutex mLock;
+    condition_variable mCond;
+    GnssAdapter* mAdapter;
+    uint32_t mPending;
+    TrackingReportStats mStats;
+    inline Delivery() : mAdapter(nullptr), mPending(0), mStats() {}
+    // called on the adapter's thread, from the client callbacks
+    inline void report() {
+        lock_guard<mutex> guard(mLock);
+        if (0 == --mPending) {
+            mStats = mAdapter->getTrackingReportStats();
+            mCond.notify_one();
+        }
+    }
+    inline void expect(uint32_t reports) {
+        lock_guard<mutex> guard(mLock);
+        mPending = reports;
+    }
+    inline void wait() {
+        unique_lock<mutex> guard(mLock);
+        mCond.wait(guard, [this] { return 0 == mPending; });
+    }
+};
+
+static Delivery sDelivery;
+
+enum CallbackType {
+    GNSS_LOCATION_INFO_CB,
+    GNSS_LOCATION_INFO_REF_CB,
+    ENGINE_LOCATIONS_INFO_CB,
+    TRACKING_CB,
+};
+
+static const char* callbackName(CallbackType type) {
+    switch (type) {
+    case GNSS_LOCATION_INFO_CB:     return "gnssLocationInfoCb";
+    case GNSS_LOCATION_INFO_REF_CB: return "gnssLocationInfoRefCb";
+    case ENGINE_LOCATIONS_INFO_CB:  return "engineLocationsInfoCb";
+    default:                        return "trackingCb";
+    }
+}
+
+static LocationCallbacks clientCallbacks(CallbackType type) {
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(LocationCallbacks);
+    callbacks.capabilitiesCb = [] (LocationCapabilitiesMask /*mask*/) {};
+    callbacks.responseCb = [] (LocationError /*err*/, uint32_t /*id*/) {};
+    callbacks.collectiveResponseCb =
+            [] (size_t /*count*/, LocationError* /*errs*/, uint32_t* /*ids*/) {};
+    switch (type) {
+    case GNSS_LOCATION_INFO_CB:
+        callbacks.gnssLocationInfoCb = [] (GnssLocationInfoNotification /*info*/) {
+            sDelivery.report();
+        };
+        break;
+    case GNSS_LOCATION_INFO_REF_CB:
+        callbacks.gnssLocationInfoRefCb = [] (const GnssLocationInfoNotification& /*info*/) {
+            sDelivery.report();
+        };
+        break;
+    case ENGINE_LOCATIONS_INFO_CB:
+        callbacks.engineLocationsInfoCb =
+                [] (uint32_t /*count*/, GnssLocationInfoNotification* /*infos*/) {
+            sDelivery.report();
+        };
+        break;
+    default:
+        callbacks.trackingCb = [] (Location /*location*/) {
+            sDelivery.report();
+        };
+        break;
+    }
+    return callbacks;
+}
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// an SPE fix with the extended fields a modem fix carries
+static void makeFix(UlpLocation& ulpLocation, GpsLocationExtended& locationExtended,
+        uint32_t n) {
+    memset(&ulpLocation, 0, sizeof(ulpLocation));
+    ulpLocation.size = sizeof(ulpLocation);
+    ulpLocation.gpsLocation.size = sizeof(ulpLocation.gpsLocation);
+    ulpLocation.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG |
+            LOC_GPS_LOCATION_HAS_ALTITUDE | LOC_GPS_LOCATION_HAS_SPEED |
+            LOC_GPS_LOCATION_HAS_BEARING | LOC_GPS_LOCATION_HAS_ACCURACY;
+    ulpLocation.gpsLocation.latitude = 37.0 + n * 1e-5;
+    ulpLocation.gpsLocation.longitude = -122.0;
+    ulpLocation.gpsLocation.altitude = 10.0;
+    ulpLocation.gpsLocation.speed = 1.0;
+    ulpLocation.gpsLocation.accuracy = 5.0;
+    ulpLocation.gpsLocation.timestamp = 1600000000000LL + n * 1000LL;
+    ulpLocation.position_source = ULP_LOCATION_IS_FROM_GNSS;
+
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    locationExtended.size = sizeof(locationExtended);
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP |
+            GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_VERT_UNC | GPS_LOCATION_EXTENDED_HAS_SPEED_UNC |
+            GPS_LOCATION_EXTENDED_HAS_BEARING_UNC | GPS_LOCATION_EXTENDED_HAS_HOR_RELIABILITY |
+            GPS_LOCATION_EXTENDED_HAS_VERT_RELIABILITY |
+            GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_MAJOR |
+            GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_MINOR |
+            GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_AZIMUTH |
+            GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+            GPS_LOCATION_EXTENDED_HAS_NAV_SOLUTION_MASK |
+            GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK |
+            GPS_LOCATION_EXTENDED_HAS_POS_DYNAMICS_DATA |
+            GPS_LOCATION_EXTENDED_HAS_GPS_TIME | GPS_LOCATION_EXTENDED_HAS_EXT_DOP;
+    locationExtended.pdop = 1.5;
+    locationExtended.hdop = 0.9;
+    locationExtended.vdop = 1.2;
+    locationExtended.altitudeMeanSeaLevel = 40.0;
+    locationExtended.vert_unc = 8.0;
+    locationExtended.speed_unc = 0.5;
+    locationExtended.bearing_unc = 10.0;
+    locationExtended.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0xff;
+}
+
+static void run(GnssAdapter& adapter, CallbackType type, uint32_t clients, uint32_t fixes) {
+    LocationCallbacks callbacks = clientCallbacks(type);
+    for (uint32_t i = 0; i < clients; i++) {
+        adapter.addClientCommand((LocationAPI*)&sClientKeys[i], callbacks);
+    }
+    // the fixes are posted at high priority, ahead of the clients
+    sDelivery.expect(1);
+    adapter.sendMsg(new LocApiMsg([] () {
+        sDelivery.report();
+    }));
+    sDelivery.wait();
+
+    UlpLocation ulpLocation;
+    GpsLocationExtended locationExtended;
+    TrackingReportStats before = sDelivery.mStats;
+    sDelivery.expect(clients * fixes);
+    double start = nowUs();
+    for (uint32_t n = 0; n < fixes; n++) {
+        makeFix(ulpLocation, locationExtended, n);
+        adapter.reportPositionEvent(ulpLocation, locationExtended, LOC_SESS_SUCCESS,
+                                    LOC_POS_TECH_MASK_SATELLITE);
+    }
+    sDelivery.wait();
+    double elapsed = nowUs() - start;
+    const TrackingReportStats& after = sDelivery.mStats;
+    printf("%-22s %2u clients  per fix: %5.2f converted %5.2f copied "
+           "%5.2f callbacks %7.2f us\n",
+           callbackName(type), clients,
+           (double)(after.conversions - before.conversions) / fixes,
+           (double)(after.copies - before.copies) / fixes,
+           (double)(after.callbacks - before.callbacks) / fixes, elapsed / fixes);
+
+    for (uint32_t i = 0; i < clients; i++) {
+        adapter.removeClientCommand((LocationAPI*)&sClientKeys[i], nullptr);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t fixes = 10000;
+    if (argc > 1) {
+        fixes = strtoul(argv[1], nullptr, 0);
+        if (0 == fixes) {
+            fprintf(stderr, "usage: %s [<fixes>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    GnssAdapter* adapter = new GnssAdapter();
+    sDelivery.mAdapter = adapter;
+    const CallbackType types[] = {GNSS_LOCATION_INFO_CB, GNSS_LOCATION_INFO_REF_CB,
+                                  ENGINE_LOCATIONS_INFO_CB, TRACKING_CB};
+    const uint32_t clients[] = {1, 4, MAX_CLIENTS};
+    for (CallbackType type : types) {
+        for (uint32_t count : clients) {
+            run(*adapter, type, count, fixes);
+        }
+    }
+    fflush(stdout);
+    // the adapter and its threads are not torn down
+    _exit(0);
+}
@@ -80,13 +80,59 @@ static const T1* loadLocationInterface(const char* library, const char* name) {
     }
 }
 
+// true if the caller's LocationCallbacks, sized by its own header version,
+// holds field; the address arithmetic reads nothing past the caller's struct
+#define LOCATION_CALLBACKS_HAS(callbacks, field) \
+    ((callbacks).size >= (size_t)((const char*)&(callbacks).field - \
+                                  (const char*)&(callbacks)) + sizeof((callbacks).field))
+
+/* Copies the callbacks of a client, which may have been built against an
+   older LocationCallbacks. The callbacks appended since are only taken if
+   they are within the size the client set, and are left unset otherwise. */
+static LocationCallbacks getSizedCallbacks(const LocationCallbacks& callbacks)
+{
+    LocationCallbacks sized = {};
+    sized.size = sizeof(LocationCallbacks);
+    sized.capabilitiesCb = callbacks.capabilitiesCb;
+    sized.responseCb = callbacks.responseCb;
+    sized.collectiveResponseCb = callbacks.collectiveResponseCb;
+    sized.trackingCb = callbacks.trackingCb;
+    sized.batchingCb = callbacks.batchingCb;
+    sized.geofenceBreachCb = callbacks.geofenceBreachCb;
+    sized.geofenceStatusCb = callbacks.geofenceStatusCb;
+    sized.gnssLocationInfoCb = callbacks.gnssLocationInfoCb;
+    sized.gnssNiCb = callbacks.gnssNiCb;
+    sized.gnssSvCb = callbacks.gnssSvCb;
+    sized.gnssNmeaCb = callbacks.gnssNmeaCb;
+    sized.gnssDataCb = callbacks.gnssDataCb;
+    sized.gnssMeasurementsCb = callbacks.gnssMeasurementsCb;
+    sized.batchingStatusCb = callbacks.batchingStatusCb;
+    sized.locationSystemInfoCb = callbacks.locationSystemInfoCb;
+    sized.engineLocationsInfoCb = callbacks.engineLocationsInfoCb;
+    if (LOCATION_CALLBACKS_HAS(callbacks, gnssSvRefCb)) {
+        sized.gnssSvRefCb = callbacks.gnssSvRefCb;
+    }
+    if (LOCATION_CALLBACKS_HAS(callbacks, gnssMeasurementsRefCb)) {
+        sized.gnssMeasurementsRefCb = callbacks.gnssMeasurementsRefCb;
+    }
+    if (LOCATION_CALLBACKS_HAS(callbacks, gnssNmeaSentencesCb)) {
+        sized.gnssNmeaSentencesCb = callbacks.gnssNmeaSentencesCb;
+    }
+    if (LOCATION_CALLBACKS_HAS(callbacks, gnssLocationInfoRefCb)) {
+        sized.gnssLocationInfoRefCb = callbacks.gnssLocationInfoRefCb;
+    }
+    return sized;
+}
+
 static bool isGnssClient(LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssNiCb != nullptr ||
             locationCallbacks.trackingCb != nullptr ||
             locationCallbacks.gnssLocationInfoCb != nullptr ||
+            locationCallbacks.gnssLocationInfoRefCb != nullptr ||
             locationCallbacks.engineLocationsInfoCb != nullptr ||
             locationCallbacks.gnssMeasurementsCb != nullptr ||
+            locationCallbacks.gnssMeasurementsRefCb != nullptr ||
             locationCallbacks.locationSystemInfoCb != nullptr);
 }
 
@@ -145,8 +191,9 @@ void onGeofenceRemoveClientCompleteCb (LocationAPI* client)
 }
 
 LocationAPI*
-LocationAPI::createInstance (LocationCallbacks& locationCallbacks)
+LocationAPI::createInstance (LocationCallbacks& callbacks)
 {
+    LocationCallbacks locationCallbacks = getSizedCallbacks(callbacks);
     if (nullptr == locationCallbacks.capabilitiesCb ||
         nullptr == locationCallbacks.responseCb ||
         nullptr == locationCallbacks.collectiveResponseCb) {
@@ -304,8 +351,9 @@ LocationAPI::~LocationAPI()
 }
 
 void
-LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
+LocationAPI::updateCallbacks(LocationCallbacks& callbacks)
 {
+    LocationCallbacks locationCallbacks = getSizedCallbacks(callbacks);
     if (nullptr == locationCallbacks.capabilitiesCb ||
         nullptr == locationCallbacks.responseCb ||
         nullptr == locationCallbacks.collectiveResponseCb) {
@@ -1186,6 +1186,18 @@ typedef struct {
     uint32_t length;       // length of the nmea text
 } GnssNmeaNotification;
 
+typedef struct {
+    const char* sentence;  // nmea sentence, NULL terminated
+    uint32_t length;       // length of the sentence, including its line terminator if any
+} GnssNmeaSentence;
+
+typedef struct {
+    uint32_t size;         // set to sizeof(GnssNmeaSentencesNotification)
+    uint64_t timestamp;    // timestamp
+    uint32_t count;        // number of sentences
+    const GnssNmeaSentence* sentences; // sentences of the nmea report, in order
+} GnssNmeaSentencesNotification;
+
 typedef struct {
     uint32_t size;                 // set to sizeof(GnssDataNotification)
     GnssDataMask  gnssDataMask[GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES];  // bitwise OR of GnssDataBits
@@ -1556,6 +1568,13 @@ typedef std::function<void(
     GnssNmeaNotification gnssNmeaNotification
 )> gnssNmeaCallback;
 
+/* Same as gnssNmeaCallback, but the NMEA text of one report comes already split into
+    sentences. The notification and the text it points to are only valid for the duration
+    of the callback. When both are set, only this one is called */
+typedef std::function<void(
+    const GnssNmeaSentencesNotification& gnssNmeaSentencesNotification
+)> gnssNmeaSentencesCallback;
+
 /* Gives GNSS data, optional can be NULL
     gnssDataCallback is called only during a tracking session
     broadcasted to all clients, no matter if a session has started by client */
@@ -1570,6 +1589,27 @@ typedef std::function<void(
     GnssMeasurementsNotification gnssMeasurementsNotification
 )> gnssMeasurementsCallback;
 
+/* Same as gnssSvCallback, but the notification is passed by reference.
+    The reference is only valid for the duration of the callback, clients that
+    need the data afterwards must copy it. When both are set, only this one is called */
+typedef std::function<void(
+    const GnssSvNotification& gnssSvNotification
+)> gnssSvRefCallback;
+
+/* Same as gnssMeasurementsCallback, but the notification is passed by reference.
+    The reference is only valid for the duration of the callback, clients that
+    need the data afterwards must copy it. When both are set, only this one is called */
+typedef std::function<void(
+    const GnssMeasurementsNotification& gnssMeasurementsNotification
+)> gnssMeasurementsRefCallback;
+
+/* Same as gnssLocationInfoCallback, but the notification is passed by reference.
+    The reference is only valid for the duration of the callback, clients that
+    need the data afterwards must copy it. When both are set, only this one is called */
+typedef std::function<void(
+    const GnssLocationInfoNotification& gnssLocationInfoNotification
+)> gnssLocationInfoRefCallback;
+
 /* Provides the current GNSS configuration to the client */
 typedef std::function<void(
     uint32_t session_id,
@@ -1611,6 +1651,10 @@ typedef struct {
     batchingStatusCallback batchingStatusCb;         // optional
     locationSystemInfoCallback locationSystemInfoCb; // optional
     engineLocationsInfoCallback engineLocationsInfoCb;     // optional
+    gnssSvRefCallback gnssSvRefCb;                   // optional
+    gnssMeasurementsRefCallback gnssMeasurementsRefCb; // optional
+    gnssNmeaSentencesCallback gnssNmeaSentencesCb;   // optional
+    gnssLocationInfoRefCallback gnssLocationInfoRefCb; // optional
 } LocationCallbacks;
 
 #endif /* LOCATIONDATATYPES_H */
@@ -28,7 +28,9 @@ LOCAL_SRC_FILES += \
     loc_misc_utils.cpp \
     loc_nmea.cpp \
     LocIpc.cpp \
-    LogBuffer.cpp
+    LocConfWatcher.cpp \
+    LogBuffer.cpp \
+    LogBinary.cpp
 
 # Flag -std=c++11 is not accepted by compiler when LOCAL_CLANG is set to true
 LOCAL_CFLAGS += \
@@ -65,5 +67,79 @@ LOCAL_MODULE := libgps.utils_headers
 LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)
 include $(BUILD_HEADER_LIBRARY)
 
+# Renders the binary log buffer dumps pulled from a device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_log_decode
+LOCAL_SRC_FILES := \
+    loc_log_decode.cpp \
+    LogBinary.cpp
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
+# Measures LocIpc throughput over AF_UNIX datagram sockets, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_ipc_bench
+LOCAL_SRC_FILES := loc_ipc_bench.cpp
+LOCAL_SHARED_LIBRARIES := libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+# Measures msg_q and MsgTask throughput with several producers, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := msg_q_bench
+LOCAL_SRC_FILES := msg_q_bench.cpp
+LOCAL_SHARED_LIBRARIES := libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+# Checks the NMEA output against the original generator and times it, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_nmea_bench
+LOCAL_SRC_FILES := loc_nmea_bench.cpp
+LOCAL_SHARED_LIBRARIES := libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+# Measures arming, re-arming and disarming many LocTimers, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_timer_bench
+LOCAL_SRC_FILES := loc_timer_bench.cpp
+LOCAL_SHARED_LIBRARIES := libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+# Times the conf file reads of the HAL startup, cached and uncached, run on the device
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_cfg_bench
+LOCAL_SRC_FILES := loc_cfg_bench.cpp
+LOCAL_SHARED_LIBRARIES := libgps.utils
+LOCAL_HEADER_LIBRARIES := \
+    libloc_pla_headers \
+    liblocation_api_headers
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
 endif # not BUILD_TINY_ANDROID
 endif # BOARD_VENDOR_QCOM_GPS_LOC_API_HARDWARE
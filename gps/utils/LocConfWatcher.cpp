@@ -0,0 +1,202 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_TAG "LocSvc_ConfWatcher"
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <log_util.h>
+#include <LocConfWatcher.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace loc_util {
+
+// a save is often a few writes, or a write plus a rename; a change is
+// reported only after its file has been quiet for this long
+#define LOC_CONF_WATCH_SETTLE_MS 200
+#define LOC_CONF_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+class LocConfWatchRunnable : public LocRunnable {
+    LocConfWatcher& mWatcher;
+public:
+    inline LocConfWatchRunnable(LocConfWatcher& watcher) : mWatcher(watcher) {}
+    inline virtual bool run() override { return mWatcher.waitForChanges(); }
+};
+
+LocConfWatcher& LocConfWatcher::getInstance() {
+    static mutex sInstanceLock;
+    static LocConfWatcher* sInstance = nullptr;
+    lock_guard<mutex> guard(sInstanceLock);
+    if (nullptr == sInstance) {
+        sInstance = new LocConfWatcher();
+    }
+    return *sInstance;
+}
+
+LocConfWatcher::LocConfWatcher() :
+        mInotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), mNextId(1), mCallingId(0) {
+    if (mInotifyFd < 0) {
+        LOC_LOGe("inotify_init1 failed, reason: %s", strerror(errno));
+    }
+}
+
+uint32_t LocConfWatcher::addWatch(const char* confPath, LocConfChangedCb cb) {
+    if (nullptr == confPath || nullptr == cb || mInotifyFd < 0) {
+        return 0;
+    }
+    string path(confPath);
+    size_t slash = path.rfind('/');
+    string dir = (string::npos == slash) ? "." : path.substr(0, slash + 1);
+    string name = (string::npos == slash) ? path : path.substr(slash + 1);
+
+    lock_guard<mutex> guard(mLock);
+    // watching a directory a second time gives back the same wd
+    int wd = inotify_add_watch(mInotifyFd, dir.c_str(), LOC_CONF_WATCH_EVENTS);
+    if (wd < 0) {
+        LOC_LOGe("inotify_add_watch %s failed, reason: %s", dir.c_str(), strerror(errno));
+        return 0;
+    }
+    if (!mThread.isRunning() &&
+            !mThread.start("LocConfWatcher", new LocConfWatchRunnable(*this))) {
+        LOC_LOGe("failed to start the watcher thread");
+        if (mWatches.end() == find_if(mWatches.begin(), mWatches.end(),
+                [wd] (const Watch& w) { return w.wd == wd; })) {
+            inotify_rm_watch(mInotifyFd, wd);
+        }
+        return 0;
+    }
+    uint32_t id = mNextId++;
+    mWatches.push_back({id, wd, path, name, cb, false});
+    LOC_LOGd("watching %s, id %u", confPath, id);
+    return id;
+}
+
+void LocConfWatcher::removeWatch(uint32_t id) {
+    unique_lock<mutex> guard(mLock);
+    auto it = find_if(mWatches.begin(), mWatches.end(),
+            [id] (const Watch& w) { return w.id == id; });
+    if (mWatches.end() != it) {
+        int wd = it->wd;
+        mWatches.erase(it);
+        if (mWatches.end() == find_if(mWatches.begin(), mWatches.end(),
+                [wd] (const Watch& w) { return w.wd == wd; })) {
+            inotify_rm_watch(mInotifyFd, wd);
+        }
+    }
+    // a cb of this watch that is running must be done before returning,
+    // unless it is the one removing the watch
+    if (this_thread::get_id() != mThreadId) {
+        mCallDone.wait(guard, [this, id] { return mCallingId != id; });
+    }
+}
+
+void LocConfWatcher::reportChanges() {
+    unique_lock<mutex> guard(mLock);
+    list<uint32_t> ids;
+    for (auto& w : mWatches) {
+        if (w.pending) {
+            w.pending = false;
+            ids.push_back(w.id);
+        }
+    }
+    for (uint32_t id : ids) {
+        // an earlier cb may have removed this watch
+        auto it = find_if(mWatches.begin(), mWatches.end(),
+                [id] (const Watch& w) { return w.id == id; });
+        if (mWatches.end() == it) {
+            continue;
+        }
+        LocConfChangedCb cb = it->cb;
+        string path = it->path;
+        mCallingId = id;
+        guard.unlock();
+        cb(path.c_str());
+        guard.lock();
+        mCallingId = 0;
+        mCallDone.notify_all();
+    }
+}
+
+bool LocConfWatcher::waitForChanges() {
+    bool pending = false;
+    {
+        lock_guard<mutex> guard(mLock);
+        mThreadId = this_thread::get_id();
+        for (auto& w : mWatches) {
+            pending = pending || w.pending;
+        }
+    }
+
+    struct pollfd pfd = {mInotifyFd, POLLIN, 0};
+    int ret = poll(&pfd, 1, pending ? LOC_CONF_WATCH_SETTLE_MS : -1);
+    if (ret < 0) {
+        return (EINTR == errno);
+    }
+
+    if (0 == ret) {
+        // quiet for LOC_CONF_WATCH_SETTLE_MS, the pending changes are done
+        reportChanges();
+        return true;
+    }
+
+    lock_guard<mutex> guard(mLock);
+
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(mInotifyFd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + len;
+                p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, any of the files may have changed
+                for (auto& w : mWatches) {
+                    w.pending = true;
+                }
+            } else if (event->len > 0) {
+                for (auto& w : mWatches) {
+                    if (w.wd == event->wd && w.name == event->name) {
+                        w.pending = true;
+                    }
+                }
+            }
+        }
+    }
+    if (len < 0 && EAGAIN != errno && EINTR != errno) {
+        LOC_LOGe("inotify read failed, reason: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+} // namespace loc_util
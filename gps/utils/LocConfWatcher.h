@@ -0,0 +1,101 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __LOC_CONF_WATCHER_H__
+#define __LOC_CONF_WATCHER_H__
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <LocThread.h>
+
+namespace loc_util {
+
+// called on the watcher thread with the path of a watched conf file
+// once it has been rewritten or replaced, and stayed so for
+// LOC_CONF_WATCH_SETTLE_MS
+typedef std::function<void(const char* confPath)> LocConfChangedCb;
+
+class LocConfWatchRunnable;
+
+// Watches configuration files with inotify so that their changes can be
+// taken in without restarting the process. There is one watcher, and one
+// watcher thread, per process, shared by all the watches. It is created
+// on the first getInstance() and lives as long as the process.
+class LocConfWatcher {
+    struct Watch {
+        uint32_t id;
+        int wd;
+        std::string path;
+        // file name within the directory watched with wd
+        std::string name;
+        LocConfChangedCb cb;
+        bool pending;
+    };
+
+    int mInotifyFd;
+    LocThread mThread;
+    std::mutex mLock;
+    std::list<Watch> mWatches;
+    uint32_t mNextId;
+    // watch whose cb the watcher thread is calling, 0 if none
+    uint32_t mCallingId;
+    std::condition_variable mCallDone;
+    std::thread::id mThreadId;
+    friend class LocConfWatchRunnable;
+
+    LocConfWatcher();
+    // returns false if inotify failed and the watcher thread is to quit
+    bool waitForChanges();
+    // call cb of the pending watches that are still there, unlocked
+    void reportChanges();
+public:
+    static LocConfWatcher& getInstance();
+
+    // confPath: conf file to watch. Its directory is what inotify watches,
+    //           so that a file replaced by rename() is followed as well.
+    // cb:       see LocConfChangedCb. It is called with the watcher unlocked,
+    //           and may add or remove watches, but it holds up the other
+    //           watches while it runs, so it should be short, e.g. it posts
+    //           a message to its own MsgTask.
+    // return:   id of the watch for removeWatch(); 0 on failure.
+    uint32_t addWatch(const char* confPath, LocConfChangedCb cb);
+
+    // cb of the watch is not called any more once this returns, unless
+    // this is called from that cb
+    void removeWatch(uint32_t id);
+};
+
+} // namespace loc_util
+
+#endif //__LOC_CONF_WATCHER_H__
@@ -29,13 +29,24 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
 #include <errno.h>
+#include <ctype.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <loc_misc_utils.h>
 #include <log_util.h>
 #include <LocIpc.h>
+#include <MsgTask.h>
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 
@@ -58,14 +69,49 @@ namespace loc_util {
         } \
     }
 
+// max number of datagrams taken by one recvmmsg()
+#define LOC_IPC_RECV_BATCH 4
+// max number of pieces of a long message gathered w/o a heap allocation
+#define LOC_IPC_SEND_IOV_ON_STACK 8
+
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
+const char Sock::LOC_IPC_BIN_HEAD[] = "$MSGBIN$";
+
+// binary length header of a long message, see LocIpc::setBinaryLengthHead()
+struct LocIpcBinaryHead {
+    char magic[8];    // LOC_IPC_BIN_HEAD w/o the NUL
+    uint32_t length;
+};
+
+// Receive buffers of one recver, used by the one thread that receives on
+// it at a time. mBufs holds mBatch slots of mMaxTxSize + 1 bytes, one per
+// datagram of a recvmmsg() burst; mBatch of 0 is picked by the sock type.
+struct SockRecvBufs {
+    unique_ptr<char[]> mBufs;
+    uint32_t mBatch;
+    vector<char> mLongMsg;
+    inline SockRecvBufs(uint32_t batch = 0) : mBatch(batch) {}
+};
+
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                           socklen_t addrlen) const {
     ssize_t rtv = -1;
     SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
     return rtv;
 }
+ssize_t Sock::sendv(const struct iovec iov[], int iovcnt, int flags,
+                    const struct sockaddr *destAddr, socklen_t addrlen,
+                    bool binaryLengthHead) const {
+    size_t len = 0;
+    for (int i = 0; nullptr != iov && i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    ssize_t rtv = -1;
+    SOCK_OP_AND_LOG(iov, (uint32_t)len, isValid(), rtv,
+                    sendmsgv(iov, iovcnt, len, flags, destAddr, addrlen, binaryLengthHead));
+    return rtv;
+}
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                    struct sockaddr *srcAddr, socklen_t *addrlen, int sid) const {
     ssize_t rtv = -1;
@@ -76,71 +122,311 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
                     recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
     return rtv;
 }
+ssize_t Sock::recv(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                   const shared_ptr<ILocIpcListener>& dataCb, int flags,
+                   struct sockaddr *srcAddr, socklen_t *addrlen, int sid) const {
+    ssize_t rtv = -1;
+    if (-1 == sid) {
+        sid = mSid;
+    } // else it sid would be connection based socket id for recv
+    SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
+                    recvfrom(bufs, recver, dataCb, sid, flags, srcAddr, addrlen));
+    return rtv;
+}
 ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
                      socklen_t addrlen) const {
+    struct iovec iov = { const_cast<void*>(buf), len };
+    return sendmsgv(&iov, 1, len, flags, destAddr, addrlen, false);
+}
+ssize_t Sock::sendmsgv(const struct iovec iov[], int iovcnt, size_t len, int flags,
+                       const struct sockaddr *destAddr, socklen_t addrlen,
+                       bool binaryLengthHead) const {
+    struct msghdr msg = {};
+    msg.msg_name = const_cast<struct sockaddr*>(destAddr);
+    msg.msg_namelen = addrlen;
     ssize_t rtv = -1;
-    if (len <= mMaxTxSize) {
-        rtv = ::sendto(mSid, buf, len, flags, destAddr, addrlen);
+    if (len <= mMaxTxSize && 1 == iovcnt) {
+        rtv = ::sendto(mSid, iov[0].iov_base, len, flags, destAddr, addrlen);
+    } else if (len <= mMaxTxSize) {
+        msg.msg_iov = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen = iovcnt;
+        rtv = ::sendmsg(mSid, &msg, flags);
     } else {
-        std::string head(LOC_IPC_HEAD + to_string(len));
-        rtv = ::sendto(mSid, head.c_str(), head.length(), flags, destAddr, addrlen);
-        if (rtv > 0) {
-            for (size_t offset = 0; offset < len && rtv > 0; offset += rtv) {
-                rtv = ::sendto(mSid, (char*)buf + offset, min(len - offset, (size_t)mMaxTxSize),
-                               flags, destAddr, addrlen);
+        char head[sizeof(LOC_IPC_HEAD) + 20];
+        size_t headLen = 0;
+        if (binaryLengthHead) {
+            LocIpcBinaryHead binHead;
+            memcpy(binHead.magic, LOC_IPC_BIN_HEAD, sizeof(binHead.magic));
+            binHead.length = len;
+            memcpy(head, &binHead, sizeof(binHead));
+            headLen = sizeof(binHead);
+        } else {
+            headLen = snprintf(head, sizeof(head), "%s%zu", LOC_IPC_HEAD, len);
+        }
+        rtv = ::sendto(mSid, head, headLen, flags, destAddr, addrlen);
+        // gather each chunk of at most mMaxTxSize straight from iov[]
+        struct iovec chunkOnStack[LOC_IPC_SEND_IOV_ON_STACK];
+        vector<struct iovec> chunkOnHeap;
+        struct iovec* chunk = chunkOnStack;
+        if (iovcnt > LOC_IPC_SEND_IOV_ON_STACK) {
+            chunkOnHeap.resize(iovcnt);
+            chunk = chunkOnHeap.data();
+        }
+        int index = 0;
+        size_t offset = 0;
+        for (size_t sent = 0; sent < len && rtv > 0; sent += rtv) {
+            size_t chunkLen = 0;
+            int chunkCnt = 0;
+            for (int i = index; i < iovcnt && chunkLen < mMaxTxSize; i++) {
+                size_t pieceOffset = (i == index) ? offset : 0;
+                size_t pieceLen = min(iov[i].iov_len - pieceOffset,
+                                      (size_t)mMaxTxSize - chunkLen);
+                chunk[chunkCnt].iov_base = (char*)iov[i].iov_base + pieceOffset;
+                chunk[chunkCnt].iov_len = pieceLen;
+                chunkCnt++;
+                chunkLen += pieceLen;
+            }
+            msg.msg_iov = chunk;
+            msg.msg_iovlen = chunkCnt;
+            rtv = ::sendmsg(mSid, &msg, flags);
+            // advance the iov[] cursor by what went out
+            for (size_t adv = (rtv > 0) ? rtv : 0; adv > 0 && index < iovcnt;) {
+                size_t step = min(adv, iov[index].iov_len - offset);
+                adv -= step;
+                offset += step;
+                if (offset == iov[index].iov_len) {
+                    index++;
+                    offset = 0;
+                }
             }
-            rtv = (rtv > 0) ? (head.length() + len) : -1;
         }
+        rtv = (rtv > 0) ? (headLen + len) : -1;
     }
     return rtv;
 }
+// parses a long message header, returns the message length, 0 if not a header
+size_t Sock::parseLengthHead(const char* data, size_t len) {
+    size_t msgLen = 0;
+    if (sizeof(LocIpcBinaryHead) == len &&
+            0 == memcmp(data, LOC_IPC_BIN_HEAD, sizeof(LocIpcBinaryHead::magic))) {
+        LocIpcBinaryHead binHead;
+        memcpy(&binHead, data, sizeof(binHead));
+        msgLen = binHead.length;
+    } else if (len >= sizeof(LOC_IPC_HEAD) - 1 &&
+            0 == strncmp(data, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+        for (size_t i = sizeof(LOC_IPC_HEAD) - 1; i < len && isdigit(data[i]); i++) {
+            msgLen = msgLen * 10 + (data[i] - '0');
+        }
+    }
+    return msgLen;
+}
+static inline void copySrcAddr(const struct msghdr& hdr, struct sockaddr *srcAddr,
+                               socklen_t *addrlen) {
+    if (nullptr != srcAddr && nullptr != addrlen) {
+        memcpy(srcAddr, hdr.msg_name, min(*addrlen, hdr.msg_namelen));
+        *addrlen = hdr.msg_namelen;
+    }
+}
+// recvers that keep no SockRecvBufs, e.g. those of prebuilt libs, take one
+// datagram at a time, into buffers of their own
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
-    std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
-    if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
-            nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+    SockRecvBufs bufs(1);
+    return recvfrom(bufs, recver, dataCb, sid, flags, srcAddr, addrlen);
+}
+ssize_t Sock::recvfrom(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                       const shared_ptr<ILocIpcListener>& dataCb,
+                       int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
+    const size_t slotSize = mMaxTxSize + 1;
+    if (nullptr == bufs.mBufs) {
+        if (0 == bufs.mBatch) {
+            // a stream has no datagram boundaries to take a burst by
+            int type = SOCK_DGRAM;
+            socklen_t typeLen = sizeof(type);
+            getsockopt(sid, SOL_SOCKET, SO_TYPE, &type, &typeLen);
+            bufs.mBatch = (SOCK_STREAM == type) ? 1 : LOC_IPC_RECV_BATCH;
+        }
+        bufs.mBufs.reset(new char[bufs.mBatch * slotSize]);
+    }
+
+    struct mmsghdr msgs[LOC_IPC_RECV_BATCH];
+    struct iovec iovs[LOC_IPC_RECV_BATCH];
+    struct sockaddr_storage addrs[LOC_IPC_RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (uint32_t i = 0; i < bufs.mBatch; i++) {
+        iovs[i].iov_base = &bufs.mBufs[i * slotSize];
+        iovs[i].iov_len = mMaxTxSize;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (nullptr != srcAddr) {
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        }
+    }
+    // block for the first datagram only, then take what else is already there
+    int count = ::recvmmsg(sid, msgs, bufs.mBatch, flags | MSG_WAITFORONE, nullptr);
+    if (count <= 0) {
+        return count;
+    }
+
+    ssize_t nBytes = 0;
+    for (int i = 0; i < count && nBytes >= 0; ) {
+        char* data = (char*)iovs[i].iov_base;
+        size_t len = msgs[i].msg_len;
+        size_t msgLen = 0;
+        copySrcAddr(msgs[i].msg_hdr, srcAddr, addrlen);
+        i++;
+        if (0 == len) {
+            return 0;
+        }
+        // NUL terminated, as listeners may treat data as a string
+        data[len] = 0;
+        if (strncmp(data, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+            LOC_LOGi("recvd abort msg.data %s", data);
+            return 0;
+        } else if (0 == (msgLen = parseLengthHead(data, len))) {
             // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+            dataCb->onReceive(data, len, &recver);
+            nBytes += len;
         } else {
             // long message
-            size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
-            for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
-                 msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
-                                    flags, srcAddr, addrlen);
-            }
-            if (nBytes > 0) {
-                nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
-            }
+            ssize_t rtv = recvLongMsg(bufs, recver, dataCb, sid, flags, srcAddr, addrlen,
+                                      msgLen, msgs, i, count);
+            nBytes = (rtv > 0) ? (nBytes + rtv) : rtv;
         }
     }
 
     return nBytes;
 }
+// the chunks of a long message are taken from the rest of the current burst
+// first, msgs[next] to msgs[count - 1], and then received straight into place
+ssize_t Sock::recvLongMsg(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                          const shared_ptr<ILocIpcListener>& dataCb,
+                          int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen,
+                          size_t msgLen, struct mmsghdr msgs[], int& next, int count) const {
+    vector<char>& longMsg = bufs.mLongMsg;
+    longMsg.resize(msgLen + 1);
+    size_t msgLenReceived = 0;
+    ssize_t nBytes = 1;
+    for (; msgLenReceived < msgLen && next < count; next++) {
+        size_t chunkLen = min((size_t)msgs[next].msg_len, msgLen - msgLenReceived);
+        memcpy(&longMsg[msgLenReceived], msgs[next].msg_hdr.msg_iov->iov_base, chunkLen);
+        copySrcAddr(msgs[next].msg_hdr, srcAddr, addrlen);
+        msgLenReceived += chunkLen;
+    }
+    for (; (msgLenReceived < msgLen) && (nBytes > 0); msgLenReceived += nBytes) {
+        nBytes = ::recvfrom(sid, &longMsg[msgLenReceived], msgLen - msgLenReceived,
+                            flags, srcAddr, addrlen);
+    }
+    if (nBytes > 0) {
+        longMsg[msgLen] = 0;
+        nBytes = msgLen;
+        dataCb->onReceive(longMsg.data(), nBytes, &recver);
+    }
+    return nBytes;
+}
 ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen) {
     return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
 }
 
-class LocIpcLocalSender : public LocIpcSender {
+// Senders of this lib, which gather a message from pieces, and may take a
+// binary length head. Prebuilt libs were built against the vtable of
+// LocIpcSender, which has neither, so LocIpc makes these calls only on
+// senders it finds registered here.
+class LocIpcGatherSender : public LocIpcSender {
+    struct Registry {
+        mutex mLock;
+        unordered_set<const LocIpcSender*> mSenders;
+    };
+    static Registry& getRegistry() {
+        static Registry* sRegistry = new Registry();
+        return *sRegistry;
+    }
+    inline void add() {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        registry.mSenders.insert(this);
+    }
+protected:
+    inline LocIpcGatherSender() : LocIpcSender() { add(); }
+    inline LocIpcGatherSender(const LocIpcGatherSender&) : LocIpcSender() { add(); }
+public:
+    inline virtual ~LocIpcGatherSender() {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        registry.mSenders.erase(this);
+    }
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt, int32_t msgId) const = 0;
+    virtual void setBinaryLengthHead(bool /*enable*/) {}
+    // sender as a LocIpcGatherSender, nullptr if it isn't one
+    static LocIpcGatherSender* find(LocIpcSender& sender) {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        return (0 == registry.mSenders.count(&sender)) ?
+                nullptr : static_cast<LocIpcGatherSender*>(&sender);
+    }
+};
+
+// Recvers of this lib that LocIpcReactor can poll. Prebuilt libs were built
+// against the vtable of LocIpcRecver, which has no pollable fd, so the
+// reactor asks only recvers it finds registered here.
+class LocIpcPollRecver {
+    struct Registry {
+        mutex mLock;
+        unordered_map<const LocIpcRecver*, const LocIpcPollRecver*> mRecvers;
+    };
+    static Registry& getRegistry() {
+        static Registry* sRegistry = new Registry();
+        return *sRegistry;
+    }
+    const LocIpcRecver& mRecver;
+protected:
+    inline LocIpcPollRecver(const LocIpcRecver& recver) : mRecver(recver) {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        registry.mRecvers[&mRecver] = this;
+    }
+    LocIpcPollRecver(const LocIpcPollRecver&) = delete;
+    LocIpcPollRecver& operator=(const LocIpcPollRecver&) = delete;
+public:
+    inline virtual ~LocIpcPollRecver() {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        registry.mRecvers.erase(&mRecver);
+    }
+    // fd that polls readable when recvData() has a message to take
+    virtual int getPollFd() const = 0;
+    // pollable fd of recver, -1 if it isn't a LocIpcPollRecver
+    static int getPollFd(const LocIpcRecver& recver) {
+        Registry& registry = getRegistry();
+        lock_guard<mutex> lock(registry.mLock);
+        auto it = registry.mRecvers.find(&recver);
+        return (registry.mRecvers.end() == it) ? -1 : it->second->getPollFd();
+    }
+};
+
+class LocIpcLocalSender : public LocIpcGatherSender {
 protected:
     shared_ptr<Sock> mSock;
     struct sockaddr_un mAddr;
+    bool mBinaryLengthHead;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
     inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
 public:
-    inline LocIpcLocalSender(const char* name) : LocIpcSender(),
+    inline virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                                 int32_t /* msgId */) const override {
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr),
+                            mBinaryLengthHead);
+    }
+    inline virtual void setBinaryLengthHead(bool enable) override {
+        mBinaryLengthHead = enable;
+    }
+    inline LocIpcLocalSender(const char* name) : LocIpcGatherSender(),
             mSock(nullptr),
-            mAddr({.sun_family = AF_UNIX, {}}) {
+            mAddr({.sun_family = AF_UNIX, {}}),
+            mBinaryLengthHead(false) {
 
         int fd = -1;
         if (nullptr != name) {
@@ -159,15 +445,18 @@ public:
     }
 };
 
-class LocIpcLocalRecver : public LocIpcLocalSender, public LocIpcRecver {
+class LocIpcLocalRecver : public LocIpcLocalSender, public LocIpcRecver,
+        public LocIpcPollRecver {
+    mutable SockRecvBufs mRecvBufs;
 protected:
     inline virtual ssize_t recv() const override {
         socklen_t size = sizeof(mAddr);
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
+        return mSock->recv(mRecvBufs, *this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
     }
 public:
     inline LocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
-            LocIpcLocalSender(name), LocIpcRecver(listener, *this) {
+            LocIpcLocalSender(name), LocIpcRecver(listener, *this),
+            LocIpcPollRecver(static_cast<const LocIpcRecver&>(*this)) {
 
         if ((unlink(mAddr.sun_path) < 0) && (errno != ENOENT)) {
             LOC_LOGw("unlink socket error. reason:%s", strerror(errno));
@@ -182,6 +471,7 @@ public:
     }
     inline virtual ~LocIpcLocalRecver() { unlink(mAddr.sun_path); }
     inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual int getPollFd() const override { return mSock->mSid; }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));
@@ -189,27 +479,38 @@ public:
     }
 };
 
-class LocIpcInetSender : public LocIpcSender {
+class LocIpcInetSender : public LocIpcGatherSender {
 protected:
     int mSockType;
     shared_ptr<Sock> mSock;
     const string mName;
     sockaddr_in mAddr;
+    bool mBinaryLengthHead;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
 public:
-    inline LocIpcInetSender(const LocIpcInetSender& sender) :
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                          int32_t /* msgId */) const override {
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr),
+                            mBinaryLengthHead);
+    }
+    inline virtual void setBinaryLengthHead(bool enable) override {
+        mBinaryLengthHead = enable;
+    }
+    inline LocIpcInetSender(const LocIpcInetSender& sender) : LocIpcGatherSender(sender),
             mSockType(sender.mSockType), mSock(sender.mSock),
-            mName(sender.mName), mAddr(sender.mAddr) {
+            mName(sender.mName), mAddr(sender.mAddr),
+            mBinaryLengthHead(sender.mBinaryLengthHead) {
     }
-    inline LocIpcInetSender(const char* name, int32_t port, int sockType) : LocIpcSender(),
+    inline LocIpcInetSender(const char* name, int32_t port, int sockType) : LocIpcGatherSender(),
             mSockType(sockType),
             mSock(make_shared<Sock>((nullptr == name) ? -1 : (::socket(AF_INET, mSockType, 0)))),
             mName((nullptr == name) ? "" : name),
             mAddr({.sin_family = AF_INET, .sin_port = htons(port),
-                    .sin_addr = {htonl(INADDR_ANY)}}) {
+                    .sin_addr = {htonl(INADDR_ANY)}}),
+            mBinaryLengthHead(false) {
         if (mSock != nullptr && mSock->isValid() && nullptr != name) {
             struct hostent* hp = gethostbyname(name);
             if (nullptr != hp) {
@@ -227,15 +528,24 @@ class LocIpcInetTcpSender : public LocIpcInetSender {
 protected:
     mutable bool mFirstTime;
 
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+    inline void connectFirstTime() const {
         if (mFirstTime) {
             mFirstTime = false;
             ::connect(mSock->mSid, (const struct sockaddr*)&mAddr, sizeof(mAddr));
         }
+    }
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+        connectFirstTime();
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
 
 public:
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                          int32_t /* msgId */) const override {
+        connectFirstTime();
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr),
+                            mBinaryLengthHead);
+    }
     inline LocIpcInetTcpSender(const char* name, int32_t port) :
             LocIpcInetSender(name, port, SOCK_STREAM),
             mFirstTime(true) {}
@@ -244,6 +554,7 @@ public:
 class LocIpcInetRecver : public LocIpcInetSender, public LocIpcRecver {
      int32_t mPort;
 protected:
+     mutable SockRecvBufs mRecvBufs;
      virtual ssize_t recv() const = 0;
 public:
     inline LocIpcInetRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
@@ -281,7 +592,8 @@ protected:
                 mConnFd = -1;
             }
         }
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size, mConnFd);
+        return mSock->recv(mRecvBufs, *this, mDataCb, 0, (struct sockaddr*)&mAddr, &size,
+                           mConnFd);
     }
 public:
     inline LocIpcInetTcpRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
@@ -290,18 +602,529 @@ public:
     inline virtual ~LocIpcInetTcpRecver() { if (-1 != mConnFd) ::close(mConnFd);}
 };
 
-class LocIpcInetUdpRecver : public LocIpcInetRecver {
+class LocIpcInetUdpRecver : public LocIpcInetRecver, public LocIpcPollRecver {
 protected:
     inline virtual ssize_t recv() const override {
         socklen_t size = sizeof(mAddr);
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
+        return mSock->recv(mRecvBufs, *this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
     }
 public:
     inline LocIpcInetUdpRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
                                 int32_t port) :
-            LocIpcInetRecver(listener, name, port, SOCK_DGRAM) {}
+            LocIpcInetRecver(listener, name, port, SOCK_DGRAM),
+            LocIpcPollRecver(static_cast<const LocIpcRecver&>(*this)) {}
 
     inline virtual ~LocIpcInetUdpRecver() {}
+    inline virtual int getPollFd() const override { return mSock->mSid; }
+};
+
+// memfd shared single producer / single consumer ring, for high rate streams
+// to another process without socket copies. The recver owns a ring and hands
+// its memfd and eventfd to the one sender that connects to its
+// SOCK_SEQPACKET socket; a ring is created for every sender that connects,
+// once the previous one has gone away. Records are a LocIpcShmRecord followed
+// by the message and a NUL, padded to 8 bytes, and never wrap; a record of
+// LOC_IPC_SHM_PAD fills the end of the ring when the next one doesn't fit.
+// Until the sender has the ring, it sends its messages over the socket.
+#define LOC_IPC_SHM_MIN_RING_SIZE 4096
+#define LOC_IPC_SHM_PAD 0xFFFFFFFF
+#define LOC_IPC_SHM_MAGIC 0x4C4F4352 // "LOCR"
+// how long a sender waits on a recver to connect or hand over the ring
+#define LOC_IPC_SHM_TIMEOUT_SEC 2
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+struct LocIpcShmRingHead {
+    uint32_t magic;
+    uint32_t size;                          // of the data area, power of 2
+    alignas(64) atomic<uint64_t> head;      // written by the sender only
+    alignas(64) atomic<uint64_t> tail;      // written by the recver only
+    alignas(64) atomic<uint32_t> recverWaiting;
+    atomic<uint32_t> recverGone;            // the recver abandoned the ring
+};
+
+struct LocIpcShmRecord {
+    uint32_t length;
+    uint32_t reserved;
+};
+
+static inline uint64_t shmRecordSize(uint32_t length) {
+    return (sizeof(LocIpcShmRecord) + length + 1 + 7) & ~(uint64_t)7;
+}
+
+static int shmMemfdCreate(const char* name) {
+#ifdef __NR_memfd_create
+    return syscall(__NR_memfd_create, name, MFD_CLOEXEC);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// a mapped ring, either end
+class LocIpcShmRing {
+public:
+    LocIpcShmRingHead* mHead;
+    char* mData;
+    size_t mMapSize;
+    int mMemFd;
+    int mEventFd;
+    inline LocIpcShmRing() :
+            mHead(nullptr), mData(nullptr), mMapSize(0), mMemFd(-1), mEventFd(-1) {}
+    inline ~LocIpcShmRing() { unmap(); }
+    inline bool isMapped() const { return nullptr != mHead; }
+    bool map(int memFd, int eventFd, size_t mapSize) {
+        void* addr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("mmap failed, reason: %s", strerror(errno));
+            ::close(memFd);
+            ::close(eventFd);
+            return false;
+        }
+        mHead = (LocIpcShmRingHead*)addr;
+        mData = (char*)addr + sizeof(LocIpcShmRingHead);
+        mMapSize = mapSize;
+        mMemFd = memFd;
+        mEventFd = eventFd;
+        return true;
+    }
+    void unmap() {
+        if (nullptr != mHead) {
+            munmap(mHead, mMapSize);
+            mHead = nullptr;
+            mData = nullptr;
+        }
+        if (-1 != mMemFd) {
+            ::close(mMemFd);
+            mMemFd = -1;
+        }
+        if (-1 != mEventFd) {
+            ::close(mEventFd);
+            mEventFd = -1;
+        }
+    }
+};
+
+class LocIpcShmSender : public LocIpcGatherSender {
+    const string mName;
+    mutable mutex mLock;
+    mutable int mSid;
+    mutable LocIpcShmRing mRing;
+    // connect to the recver and map the ring it hands over. A recver that is
+    // too busy to hand it over in time leaves the sender connected without a
+    // ring, sending over the socket until the ring shows up.
+    bool connectLocked() const {
+        disconnectLocked();
+        mSid = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (mSid >= 0) {
+            timeval timeout;
+            timeout.tv_sec = LOC_IPC_SHM_TIMEOUT_SEC;
+            timeout.tv_usec = 0;
+            setsockopt(mSid, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            setsockopt(mSid, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+        struct sockaddr_un addr = {.sun_family = AF_UNIX, {}};
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", mName.c_str());
+        if (mSid < 0 || ::connect(mSid, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            LOC_LOGe("connect to %s failed, reason: %s", mName.c_str(), strerror(errno));
+            disconnectLocked();
+            return false;
+        }
+        if (!takeRingLocked(0) && -1 != mSid) {
+            LOC_LOGw("%s hasn't handed over the ring, sending over the socket", mName.c_str());
+        }
+        return -1 != mSid;
+    }
+    // map the ring the recver handed over. Returns false if it hasn't done so
+    // yet, and disconnects if it refused the connection.
+    bool takeRingLocked(int flags) const {
+        uint32_t mapSize = 0;
+        struct iovec iov = { &mapSize, sizeof(mapSize) };
+        char control[CMSG_SPACE(2 * sizeof(int))] = {};
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = nullptr;
+        ssize_t rtv = ::recvmsg(mSid, &msg, MSG_CMSG_CLOEXEC | flags);
+        if (rtv < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+            return false;
+        } else if (rtv != sizeof(mapSize) ||
+                nullptr == (cmsg = CMSG_FIRSTHDR(&msg)) || SCM_RIGHTS != cmsg->cmsg_type ||
+                cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+            LOC_LOGe("%s refused the connection", mName.c_str());
+            disconnectLocked();
+            return false;
+        }
+        int fds[2];
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+        if (!mRing.map(fds[0], fds[1], mapSize)) {
+            disconnectLocked();
+            return false;
+        }
+        uint32_t size = mRing.mHead->size;
+        if (LOC_IPC_SHM_MAGIC != mRing.mHead->magic || 0 == size || 0 != (size & (size - 1)) ||
+                size + sizeof(LocIpcShmRingHead) > mapSize) {
+            LOC_LOGe("%s handed over a bad ring", mName.c_str());
+            disconnectLocked();
+            return false;
+        }
+        return true;
+    }
+    // send over the socket while there is no ring yet
+    ssize_t sendSocketLocked(const struct iovec iov[], int iovcnt, size_t length) const {
+        if (0 == length) {
+            // an empty message would read as the end of the connection
+            return 0;
+        }
+        struct msghdr msg = {};
+        msg.msg_iov = (struct iovec*)iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t rtv = ::sendmsg(mSid, &msg, MSG_NOSIGNAL);
+        if (rtv < 0 && EAGAIN != errno && EWOULDBLOCK != errno) {
+            LOC_LOGe("send to %s failed, reason: %s", mName.c_str(), strerror(errno));
+            disconnectLocked();
+        }
+        return rtv;
+    }
+    // write to the ring, or to the socket until there is a ring
+    ssize_t writeOrSendLocked(const struct iovec iov[], int iovcnt, size_t length) const {
+        if (!mRing.isMapped() && !takeRingLocked(MSG_DONTWAIT)) {
+            return (-1 == mSid) ? -1 : sendSocketLocked(iov, iovcnt, length);
+        }
+        return writeLocked(iov, iovcnt, length);
+    }
+    void disconnectLocked() const {
+        mRing.unmap();
+        if (mSid >= 0) {
+            ::close(mSid);
+            mSid = -1;
+        }
+    }
+    // true if the recver has closed the connection, i.e. abandoned the ring
+    bool isRecverGoneLocked() const {
+        struct pollfd pfd = { mSid, POLLIN, 0 };
+        return -1 == mSid || (::poll(&pfd, 1, 0) > 0 && 0 != (pfd.revents & (POLLIN | POLLHUP)));
+    }
+    ssize_t writeLocked(const struct iovec iov[], int iovcnt, uint32_t length) const {
+        LocIpcShmRingHead* ring = mRing.mHead;
+        const uint64_t size = ring->size;
+        const uint64_t recordSize = shmRecordSize(length);
+        if (recordSize > size / 2) {
+            LOC_LOGe("message of %u bytes is too long for the ring", length);
+            return -1;
+        }
+        uint64_t head = ring->head.load(memory_order_relaxed);
+        uint64_t offset = head & (size - 1);
+        uint64_t padSize = (offset + recordSize > size) ? (size - offset) : 0;
+        if (head + padSize + recordSize - ring->tail.load(memory_order_acquire) > size) {
+            // full
+            return -1;
+        }
+        if (padSize > 0) {
+            ((LocIpcShmRecord*)(mRing.mData + offset))->length = LOC_IPC_SHM_PAD;
+            head += padSize;
+            offset = 0;
+        }
+        LocIpcShmRecord* record = (LocIpcShmRecord*)(mRing.mData + offset);
+        record->length = length;
+        char* data = (char*)(record + 1);
+        for (int i = 0; i < iovcnt; i++) {
+            memcpy(data, iov[i].iov_base, iov[i].iov_len);
+            data += iov[i].iov_len;
+        }
+        *data = 0;
+        ring->head.store(head + recordSize, memory_order_seq_cst);
+        // wake the recver only if it's about to sleep
+        if (ring->recverWaiting.load(memory_order_seq_cst) &&
+                ring->recverWaiting.exchange(0, memory_order_seq_cst)) {
+            uint64_t one = 1;
+            if (::write(mRing.mEventFd, &one, sizeof(one)) < 0) {
+                LOC_LOGw("eventfd write failed, reason: %s", strerror(errno));
+            }
+        }
+        return length;
+    }
+protected:
+    inline virtual bool isOperable() const override { return !mName.empty(); }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t msgId) const override {
+        struct iovec iov = { (void*)data, length };
+        return sendv(&iov, 1, msgId);
+    }
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                          int32_t /* msgId */) const override {
+        size_t length = 0;
+        for (int i = 0; i < iovcnt; i++) {
+            length += iov[i].iov_len;
+        }
+        lock_guard<mutex> lock(mLock);
+        if ((-1 == mSid ||
+                (mRing.isMapped() && mRing.mHead->recverGone.load(memory_order_acquire))) &&
+                !connectLocked()) {
+            return -1;
+        }
+        ssize_t rtv = writeOrSendLocked(iov, iovcnt, length);
+        // a full ring may have been abandoned by a recver that died
+        if (rtv < 0 && mRing.isMapped() && isRecverGoneLocked() && connectLocked()) {
+            rtv = writeOrSendLocked(iov, iovcnt, length);
+        }
+        return rtv;
+    }
+public:
+    inline LocIpcShmSender(const char* name) :
+            LocIpcGatherSender(), mName((nullptr == name) ? "" : name), mSid(-1) {}
+    inline virtual ~LocIpcShmSender() { disconnectLocked(); }
+    inline virtual void informRecverRestarted() override {
+        lock_guard<mutex> lock(mLock);
+        disconnectLocked();
+    }
+};
+
+class LocIpcShmRecver : public LocIpcSender, public LocIpcRecver, public LocIpcPollRecver {
+    struct sockaddr_un mAddr;
+    uint32_t mRingSize;
+    int mListenFd;
+    int mAbortFd;
+    int mEpollFd;
+    mutable int mConnFd;
+    mutable bool mSenderOnSocket;
+    mutable LocIpcShmRing mRing;
+    bool addPoll(int fd) const {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        return 0 == epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    // create a ring for a newly connected sender and hand it over
+    void acceptSender() const {
+        int connFd = accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connFd < 0) {
+            return;
+        } else if (-1 != mConnFd) {
+            LOC_LOGw("%s already has a sender", mAddr.sun_path);
+            ::close(connFd);
+            return;
+        }
+        size_t mapSize = sizeof(LocIpcShmRingHead) + mRingSize;
+        int fds[2] = { shmMemfdCreate(mAddr.sun_path), eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) };
+        if (fds[0] < 0 || fds[1] < 0 || ftruncate(fds[0], mapSize) < 0) {
+            LOC_LOGe("failed to create ring, reason: %s", strerror(errno));
+            for (int fd : fds) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+            ::close(connFd);
+            return;
+        } else if (!mRing.map(fds[0], fds[1], mapSize)) {
+            ::close(connFd);
+            return;
+        }
+        mRing.mHead->magic = LOC_IPC_SHM_MAGIC;
+        mRing.mHead->size = mRingSize;
+        mRing.mHead->recverWaiting.store(1);
+
+        uint32_t size = mapSize;
+        struct iovec iov = { &size, sizeof(size) };
+        char control[CMSG_SPACE(sizeof(fds))] = {};
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        if (::sendmsg(connFd, &msg, MSG_NOSIGNAL) < 0 || !addPoll(connFd) ||
+                !addPoll(mRing.mEventFd)) {
+            LOC_LOGe("failed to hand over ring, reason: %s", strerror(errno));
+            epoll_ctl(mEpollFd, EPOLL_CTL_DEL, connFd, nullptr);
+            ::close(connFd);
+            mRing.unmap();
+            return;
+        }
+        mConnFd = connFd;
+        mSenderOnSocket = true;
+    }
+    // the sender went away, its ring goes with it
+    void dropSender() const {
+        mRing.mHead->recverGone.store(1, memory_order_release);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, mConnFd, nullptr);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, mRing.mEventFd, nullptr);
+        ::close(mConnFd);
+        mConnFd = -1;
+        mRing.unmap();
+    }
+    // hand what the sender sent over the socket to the listener, returns
+    // bytes taken, or -1 once the sender has closed the connection
+    ssize_t recvSocket() const {
+        ssize_t nBytes = 0;
+        while (true) {
+            ssize_t length = ::recv(mConnFd, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+            if (length <= 0) {
+                // the sender never sends empty messages, 0 is the end of the connection
+                return (length < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) ? nBytes : -1;
+            }
+            string data(length, 0);
+            if (::recv(mConnFd, &data[0], length, MSG_DONTWAIT) != length) {
+                return -1;
+            }
+            mDataCb->onReceive(data.data(), length, this);
+            nBytes += length;
+        }
+    }
+    // hand every record in the ring to the listener, returns bytes taken
+    ssize_t drain() const {
+        LocIpcShmRingHead* ring = mRing.mHead;
+        const uint64_t size = mRingSize;
+        uint64_t tail = ring->tail.load(memory_order_relaxed);
+        ssize_t nBytes = 0;
+        while (true) {
+            uint64_t head = ring->head.load(memory_order_acquire);
+            if (head == tail) {
+                // tell the sender to wake us up, then check once more
+                ring->recverWaiting.store(1, memory_order_seq_cst);
+                if (ring->head.load(memory_order_seq_cst) == tail) {
+                    break;
+                }
+                continue;
+            }
+            uint64_t offset = tail & (size - 1);
+            LocIpcShmRecord* record = (LocIpcShmRecord*)(mRing.mData + offset);
+            uint32_t length = record->length;
+            if (LOC_IPC_SHM_PAD == length) {
+                tail += size - offset;
+            } else if (offset + shmRecordSize(length) > size || head - tail > size) {
+                LOC_LOGe("corrupted ring, dropping sender");
+                tail = head;
+                nBytes = -1;
+                break;
+            } else {
+                const char* data = (const char*)(record + 1);
+                mDataCb->onReceive(data, length, this);
+                tail += shmRecordSize(length);
+                nBytes += length;
+            }
+            ring->tail.store(tail, memory_order_release);
+        }
+        return nBytes;
+    }
+protected:
+    inline virtual bool isOperable() const override { return mEpollFd >= 0; }
+    inline virtual ssize_t send(const uint8_t[], uint32_t, int32_t) const override {
+        return -1;
+    }
+    virtual ssize_t recv() const override {
+        struct epoll_event events[4];
+        int n = epoll_wait(mEpollFd, events, 4, -1);
+        if (n < 0) {
+            return (EINTR == errno) ? 1 : -1;
+        }
+        ssize_t nBytes = 0;
+        bool connReadable = false;
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == mAbortFd) {
+                LOC_LOGi("recvd abort on %s", mAddr.sun_path);
+                return 0;
+            } else if (fd == mListenFd) {
+                acceptSender();
+            } else if (fd == mRing.mEventFd) {
+                uint64_t count;
+                if (::read(mRing.mEventFd, &count, sizeof(count)) < 0) {
+                    LOC_LOGw("eventfd read failed, reason: %s", strerror(errno));
+                }
+            } else if (fd == mConnFd) {
+                connReadable = true;
+            }
+        }
+        if (mRing.isMapped()) {
+            bool senderLeft = false;
+            if (mSenderOnSocket || connReadable) {
+                // what the sender sent over the socket came before anything
+                // in the ring, and it stops doing so once it writes the ring
+                bool onRing = 0 != mRing.mHead->head.load(memory_order_acquire);
+                ssize_t received = recvSocket();
+                if (received < 0) {
+                    senderLeft = true;
+                } else {
+                    nBytes += received;
+                }
+                mSenderOnSocket = !onRing;
+            }
+            // take what the sender left behind before letting it go
+            ssize_t drained = drain();
+            if (drained > 0) {
+                nBytes += drained;
+            }
+            if (drained < 0 || senderLeft) {
+                dropSender();
+            }
+        }
+        // keep listening regardless of how much was received
+        return (nBytes > 0) ? nBytes : 1;
+    }
+public:
+    LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
+                    uint32_t ringSize) :
+            LocIpcSender(), LocIpcRecver(listener, *this),
+            LocIpcPollRecver(static_cast<const LocIpcRecver&>(*this)),
+            mAddr({.sun_family = AF_UNIX, {}}), mRingSize(LOC_IPC_SHM_MIN_RING_SIZE),
+            mListenFd(-1), mAbortFd(-1), mEpollFd(-1), mConnFd(-1), mSenderOnSocket(false) {
+        // ring size must be a power of 2
+        while (mRingSize < ringSize) {
+            mRingSize <<= 1;
+        }
+        if (nullptr == name) {
+            return;
+        }
+        snprintf(mAddr.sun_path, sizeof(mAddr.sun_path), "%s", name);
+        if ((unlink(mAddr.sun_path) < 0) && (errno != ENOENT)) {
+            LOC_LOGw("unlink socket error. reason:%s", strerror(errno));
+        }
+        umask(0157);
+        mListenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        mAbortFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (mListenFd < 0 || mAbortFd < 0 || mEpollFd < 0 ||
+                ::bind(mListenFd, (struct sockaddr*)&mAddr, sizeof(mAddr)) < 0 ||
+                ::listen(mListenFd, 1) < 0 || !addPoll(mListenFd) || !addPoll(mAbortFd)) {
+            LOC_LOGe("failed to set up %s, reason: %s", mAddr.sun_path, strerror(errno));
+            if (mEpollFd >= 0) {
+                ::close(mEpollFd);
+                mEpollFd = -1;
+            }
+        }
+    }
+    virtual ~LocIpcShmRecver() {
+        if (-1 != mConnFd) {
+            mRing.mHead->recverGone.store(1, memory_order_release);
+            ::close(mConnFd);
+        }
+        if (mListenFd >= 0) {
+            ::close(mListenFd);
+            unlink(mAddr.sun_path);
+        }
+        if (mAbortFd >= 0) {
+            ::close(mAbortFd);
+        }
+        if (mEpollFd >= 0) {
+            ::close(mEpollFd);
+        }
+    }
+    inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual int getPollFd() const override { return mEpollFd; }
+    inline virtual void abort() const override {
+        uint64_t one = 1;
+        if (mAbortFd >= 0 && ::write(mAbortFd, &one, sizeof(one)) < 0) {
+            LOC_LOGw("abort failed, reason: %s", strerror(errno));
+        }
+    }
 };
 
 class LocIpcRunnable : public LocRunnable {
@@ -368,10 +1191,214 @@ void LocIpc::stopBlockingListening(LocIpcRecver& ipcRecver) {
     }
 }
 
+// max number of ready recvers taken per epoll_wait()
+#define LOC_IPC_REACTOR_MAX_EVENTS 16
+
+struct LocIpcReactorEntry {
+    unique_ptr<LocIpcRecver> mRecver;
+    int mFd;
+    bool mSlowListener;
+    inline LocIpcReactorEntry(unique_ptr<LocIpcRecver>& recver, int fd, bool slowListener) :
+            mRecver(move(recver)), mFd(fd), mSlowListener(slowListener) {}
+};
+
+// Every recver is polled with EPOLLONESHOT, so that only one thread at a time,
+// the reactor or the worker, receives from it, and it is re-armed only after
+// its message is done with.
+static inline bool armRecver(int epollFd, int op, LocIpcReactorEntry& entry) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = &entry;
+    return 0 == epoll_ctl(epollFd, op, entry.mFd, &ev);
+}
+
+struct LocIpcReactorRecvMsg : public LocMsg {
+    LocIpcReactor& mReactor;
+    LocIpcReactorEntry& mEntry;
+    inline LocIpcReactorRecvMsg(LocIpcReactor& reactor, LocIpcReactorEntry& entry) :
+            LocMsg(), mReactor(reactor), mEntry(entry) {}
+    inline virtual void proc() const override {
+        mReactor.onReadable(mEntry);
+    }
+};
+
+class LocIpcReactorRunnable : public LocRunnable {
+    LocIpcReactor& mReactor;
+public:
+    inline LocIpcReactorRunnable(LocIpcReactor& reactor) : mReactor(reactor) {}
+    inline bool run() override {
+        struct epoll_event events[LOC_IPC_REACTOR_MAX_EVENTS];
+        int n = epoll_wait(mReactor.mEpollFd, events, LOC_IPC_REACTOR_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (EINTR == errno) {
+                return true;
+            }
+            LOC_LOGe("epoll_wait failed, reason: %s", strerror(errno));
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            LocIpcReactorEntry* entry = (LocIpcReactorEntry*)events[i].data.ptr;
+            if (nullptr == entry) {
+                // mEventFd, the reactor is going away
+                return false;
+            } else if (entry->mSlowListener) {
+                mReactor.mWorker->sendMsg(new LocIpcReactorRecvMsg(mReactor, *entry));
+            } else {
+                mReactor.onReadable(*entry);
+            }
+        }
+        return true;
+    }
+};
+
+LocIpcReactor::LocIpcReactor(const char* threadName) :
+        mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+        mEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+        mWorker(nullptr) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (-1 == mEpollFd || -1 == mEventFd ||
+            0 != epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &ev) ||
+            !mThread.start(threadName, new LocIpcReactorRunnable(*this))) {
+        LOC_LOGe("failed to start %s, recvers get threads of their own, reason: %s",
+                 threadName, strerror(errno));
+        if (-1 != mEpollFd) {
+            ::close(mEpollFd);
+            mEpollFd = -1;
+        }
+    }
+}
+
+LocIpcReactor::~LocIpcReactor() {
+    if (-1 != mEpollFd) {
+        uint64_t one = 1;
+        if (write(mEventFd, &one, sizeof(one)) < 0) {
+            LOC_LOGw("failed to wake up reactor, reason: %s", strerror(errno));
+        }
+        mThread.stop();
+    }
+    if (nullptr != mWorker) {
+        // joins the worker, so that no receive is running any more
+        mWorker->destroy();
+        mWorker = nullptr;
+    }
+    mThreadedIpcs.clear();
+    mEntries.clear();
+    if (-1 != mEpollFd) {
+        ::close(mEpollFd);
+    }
+    if (-1 != mEventFd) {
+        ::close(mEventFd);
+    }
+}
+
+LocIpcReactor& LocIpcReactor::getDefault() {
+    static LocIpcReactor* sReactor = new LocIpcReactor();
+    return *sReactor;
+}
+
+bool LocIpcReactor::startListening(unique_ptr<LocIpcRecver>& ipcRecver, bool slowListener) {
+    if (ipcRecver == nullptr || !ipcRecver->isRecvable()) {
+        LOC_LOGe("ipcRecver is null OR ipcRecver->recvable() is fasle");
+        return false;
+    }
+
+    int fd = LocIpcPollRecver::getPollFd(*ipcRecver);
+    if (-1 == mEpollFd || -1 == fd) {
+        unique_ptr<LocIpc> ipc(new LocIpc());
+        const LocIpcRecver* recver = ipcRecver.get();
+        if (!ipc->startNonBlockingListening(ipcRecver)) {
+            return false;
+        }
+        lock_guard<mutex> lock(mLock);
+        mThreadedIpcs.push_back(make_pair(recver, move(ipc)));
+        return true;
+    }
+
+    lock_guard<mutex> lock(mLock);
+    if (slowListener && nullptr == mWorker) {
+        mWorker = new MsgTask("LocIpcReactorWorker", true);
+    }
+    // inform that the socket is ready to receive message
+    ipcRecver->onListenerReady();
+    mEntries.push_back(make_unique<LocIpcReactorEntry>(ipcRecver, fd, slowListener));
+    if (!armRecver(mEpollFd, EPOLL_CTL_ADD, *mEntries.back())) {
+        LOC_LOGe("failed to poll %s, reason: %s",
+                 mEntries.back()->mRecver->getName(), strerror(errno));
+        mEntries.pop_back();
+        return false;
+    }
+    return true;
+}
+
+void LocIpcReactor::stopListening(const LocIpcRecver& ipcRecver) {
+    lock_guard<mutex> lock(mLock);
+    for (auto& entry : mEntries) {
+        if (entry->mRecver.get() == &ipcRecver) {
+            if (ipcRecver.isRecvable()) {
+                ipcRecver.abort();
+            }
+            return;
+        }
+    }
+    for (auto it = mThreadedIpcs.begin(); it != mThreadedIpcs.end(); ++it) {
+        if (it->first == &ipcRecver) {
+            // the LocIpc dtor stops and joins its thread
+            mThreadedIpcs.erase(it);
+            return;
+        }
+    }
+}
+
+void LocIpcReactor::onReadable(LocIpcReactorEntry& entry) {
+    if (!entry.mRecver->recvData() || !armRecver(mEpollFd, EPOLL_CTL_MOD, entry)) {
+        remove(entry);
+    }
+}
+
+void LocIpcReactor::remove(LocIpcReactorEntry& entry) {
+    lock_guard<mutex> lock(mLock);
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, entry.mFd, nullptr);
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (it->get() == &entry) {
+            mEntries.erase(it);
+            break;
+        }
+    }
+}
+
 bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, int32_t msgId) {
     return sender.sendData(data, length, msgId);
 }
 
+bool LocIpc::send(LocIpcSender& sender, const struct iovec iov[], int iovcnt, int32_t msgId) {
+    const LocIpcGatherSender* gatherSender = LocIpcGatherSender::find(sender);
+    if (nullptr != gatherSender) {
+        return sender.isSendable() && (gatherSender->sendv(iov, iovcnt, msgId) > 0);
+    }
+    // senders that can't gather get the pieces concatenated
+    string data;
+    for (int i = 0; i < iovcnt; i++) {
+        data.append((const char*)iov[i].iov_base, iov[i].iov_len);
+    }
+    return sender.sendData((const uint8_t*)data.data(), data.length(), msgId);
+}
+
+void LocIpc::setBinaryLengthHead(LocIpcSender& sender, bool enable) {
+    LocIpcGatherSender* gatherSender = LocIpcGatherSender::find(sender);
+    if (nullptr != gatherSender) {
+        gatherSender->setBinaryLengthHead(enable);
+    }
+}
+
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const char* shmSockName) {
+    return make_shared<LocIpcShmSender>(shmSockName);
+}
+unique_ptr<LocIpcRecver> LocIpc::getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                                                    const char* shmSockName, uint32_t ringSize) {
+    return make_unique<LocIpcShmRecver>(listener, shmSockName, ringSize);
+}
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
@@ -32,19 +32,25 @@
 
 #include <string>
 #include <memory>
+#include <list>
+#include <mutex>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <LocThread.h>
 
 using namespace std;
 
+class MsgTask;
+
 namespace loc_util {
 
 
 class LocIpcRecver;
 class LocIpcSender;
 class LocIpcRunnable;
+struct LocIpcReactorEntry;
 
 class ILocIpcListener {
 protected:
@@ -86,6 +92,18 @@ public:
             getLocIpcQrtrRecver(const shared_ptr<ILocIpcListener>& listener,
                                 int service, int instance);
 
+    // Shared memory ring transport, for high rate traffic to another process.
+    // The recver listens on the unix socket shmSockName for the one sender
+    // that may write into its ring at a time. ringSize is rounded up to a
+    // power of 2, and limits a message to about half of it. A sender waits at
+    // most 2 seconds for the recver to hand over the ring, and sends over the
+    // socket until it does.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const char* shmSockName);
+    static unique_ptr<LocIpcRecver>
+            getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                               const char* shmSockName, uint32_t ringSize = 256 * 1024);
+
     static pair<shared_ptr<LocIpcSender>, unique_ptr<LocIpcRecver>>
             getLocIpcQmiLocServiceSenderRecverPair(const shared_ptr<ILocIpcListener>& listener,
                                                    int instance);
@@ -111,12 +129,64 @@ public:
     // The function will return true on success, and false on failure.
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
+    // Same as above, with the message gathered from iovcnt pieces in iov[],
+    // e.g. a header and a payload, so that they need not be concatenated.
+    // Only senders from the factories above gather; the pieces are
+    // concatenated for any other sender.
+    static bool send(LocIpcSender& sender, const struct iovec iov[],
+                     int iovcnt, int32_t msgId = -1);
+    // Messages longer than the max tx size go out as a length header and
+    // chunks. By default the header is the ASCII "$MSGLEN$<n>" every recver
+    // understands; true switches sender to a binary header, which only
+    // recvers of this version of LocIpc understand. Only senders from the
+    // local and inet factories above take this.
+    static void setBinaryLengthHead(LocIpcSender& sender, bool enable);
 
 private:
     LocThread mThread;
     LocIpcRunnable *mRunnable;
 };
 
+// Listens on many LocIpcRecvers with one epoll thread, where
+// LocIpc::startNonBlockingListening() takes a thread per recver.
+// onReceive() of a recver's listener is called from the reactor thread, or,
+// for a slow listener, from a worker thread so that it does not hold up the
+// other recvers. Only the local, inet UDP and shm recvers from the LocIpc
+// factories are polled; any other recver falls back to a LocIpc thread of
+// its own.
+class LocIpcReactor {
+public:
+    LocIpcReactor(const char* threadName = "LocIpcReactor");
+    ~LocIpcReactor();
+
+    // shared reactor of the process, created on first use and never deleted
+    static LocIpcReactor& getDefault();
+
+    // Take over ipcRecver and listen for its messages. Returns immediately.
+    // slowListener: true if the listener's onReceive() may take long. It is
+    //               then called from the worker thread. A slow recver has at
+    //               most one receive with the worker at a time; further
+    //               messages wait in its socket until that is done.
+    bool startListening(unique_ptr<LocIpcRecver>& ipcRecver, bool slowListener = false);
+    // Stop listening on a recver taken by startListening(). The recver gets
+    // deleted once the reactor sees its abort message.
+    void stopListening(const LocIpcRecver& ipcRecver);
+
+private:
+    friend class LocIpcReactorRunnable;
+    friend struct LocIpcReactorRecvMsg;
+    int mEpollFd;
+    int mEventFd;
+    LocThread mThread;
+    MsgTask* mWorker;
+    mutex mLock;
+    list<unique_ptr<LocIpcReactorEntry>> mEntries;
+    list<pair<const LocIpcRecver*, unique_ptr<LocIpc>>> mThreadedIpcs;
+    // receive one message, then wait for the next, or drop the recver
+    void onReadable(LocIpcReactorEntry& entry);
+    void remove(LocIpcReactorEntry& entry);
+};
+
 /* this is only when client needs to implement Sender / Recver that are not already provided by
    the factor methods prvoided by LocIpc. */
 
@@ -158,14 +228,32 @@ public:
     virtual const char* getName() const = 0;
 };
 
+// receive buffers of a Sock, see LocIpc.cpp
+struct SockRecvBufs;
+
+// Sock objs are also created by prebuilt libs, so the obj keeps its
+// original members; anything added is a non-virtual member function, or
+// lives with the caller, like SockRecvBufs.
 class Sock {
     static const char MSG_ABORT[];
     static const char LOC_IPC_HEAD[];
+    static const char LOC_IPC_BIN_HEAD[];
     const uint32_t mMaxTxSize;
     ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
                    socklen_t addrlen) const;
+    ssize_t sendmsgv(const struct iovec iov[], int iovcnt, size_t len, int flags,
+                     const struct sockaddr *destAddr, socklen_t addrlen,
+                     bool binaryLengthHead) const;
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvfrom(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                     const shared_ptr<ILocIpcListener>& dataCb,
+                     int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    static size_t parseLengthHead(const char* data, size_t len);
+    ssize_t recvLongMsg(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                        const shared_ptr<ILocIpcListener>& dataCb,
+                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen,
+                        size_t msgLen, struct mmsghdr msgs[], int& next, int count) const;
 public:
     int mSid;
     inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
@@ -173,8 +261,18 @@ public:
     inline bool isValid() const { return -1 != mSid; }
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                  socklen_t addrlen) const;
+    // gathers the message from iov[], see LocIpc::setBinaryLengthHead()
+    // for binaryLengthHead
+    ssize_t sendv(const struct iovec iov[], int iovcnt, int flags,
+                  const struct sockaddr *destAddr, socklen_t addrlen,
+                  bool binaryLengthHead) const;
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
+    // Same as above, but takes a burst of datagrams at a time, into bufs,
+    // which the recver keeps and reuses for every message.
+    ssize_t recv(SockRecvBufs& bufs, const LocIpcRecver& recver,
+                 const shared_ptr<ILocIpcListener>& dataCb, int flags,
+                 struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
     inline void close() {
         if (isValid()) {
@@ -220,6 +220,10 @@ bool LocThread::start(tCreate creator, const char* threadName, LocRunnable* runn
     return success;
 }
 
+bool LocThread::start(const char* threadName, LocRunnable* runnable, bool joinable) {
+    return start(NULL, threadName, runnable, joinable);
+}
+
 void LocThread::stop() {
     if (mThread) {
         mThread->stop();
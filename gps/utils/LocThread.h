@@ -77,9 +77,7 @@ public:
     //          to delete the object
     // Returns 0 if success; false if failure.
     bool start(tCreate creator, const char* threadName, LocRunnable* runnable, bool joinable = true);
-    inline bool start(const char* threadName, LocRunnable* runnable, bool joinable = true) {
-        return start(NULL, threadName, runnable, joinable);
-    }
+    bool start(const char* threadName, LocRunnable* runnable, bool joinable = true);
 
     // NOTE: if this is a joinable thread, this stop may block
     // for a while until the thread is joined.
@@ -32,6 +32,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <vector>
+#include <atomic>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <log_util.h>
@@ -54,18 +56,18 @@ LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerPollTask, LocTimerWrapper
 
 LocTimer - client front end, interface for client to start / stop timers, also
            to provide a callback.
-LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
-                   Its life cycle is different than that of LocTimer. It gets
-                   created when LocTimer::start() is called, and gets deleted
-                   when it expires or clients calls the hosting LocTimer obj's
-                   stop() method. When a LocTimerDelegate obj is ticking, it
-                   stays in the corresponding LocTimerContainer. When expired
-                   or stopped, the obj is removed from the container. Since it
-                   is also a LocRankable obj, and LocTimerContainer also is a
-                   heap, its ranks() implementation decides where it is placed
-                   in the heap.
-LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
+LocTimerDelegate - an internal timer entity. Its life cycle is different than
+                   that of LocTimer. It gets created when LocTimer::start() is
+                   called, and gets deleted when it expires or clients calls the
+                   hosting LocTimer obj's stop() method. LocTimer::restart()
+                   re-arms it in place. When a LocTimerDelegate obj is ticking,
+                   it stays in the corresponding LocTimerContainer. When expired
+                   or stopped, the obj is removed from the container. It keeps
+                   its own position in the container's heap, so that it can be
+                   removed or re-armed without searching for it.
+LocTimerContainer - core of the timer service. It is a container, a 4-ary heap
+                    in an array, for LocTimerDelegate objs ordered by their
+                    expiration times.
                     There are 2 of such containers, one for sw timers (or Linux
                     timers) one for hw timers (or Linux alarms). It adds one of
                     each (those that expire the soonest) to kernel via services
@@ -84,14 +86,15 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 class LocTimerPollTask;
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
-//   events. When that happens, soonest time out changes, so timerfd needs update.
-// * contains the timers, and add / remove them into the heap
+// * keeps the timers in a 4-ary heap in an array, soonest first, for the
+//   detection of head update upon add / remove / rearm events. When that
+//   happens, soonest time out changes, so timerfd needs update.
+// * contains the timers, and add / remove / rearm them in the heap
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -104,20 +107,36 @@ class LocTimerContainer : public LocHeap {
     static LocTimerPollTask* mPollTask;
     // timer / alarm fd
     int mDevFd;
+    // heap of the timers, soonest first. Children of mTimers[i] are
+    // mTimers[4*i+1] to mTimers[4*i+4], and each timer knows its index.
+    std::vector<LocTimerDelegate*> mTimers;
+    // counters, see LocTimerStats. Updated in MsgTask context only.
+    std::atomic<uint64_t> mWakeupCount;
+    std::atomic<uint64_t> mFiredCount;
+    std::atomic<uint64_t> mCoalescedCount;
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
-    LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
+    // heap management
+    void place(LocTimerDelegate* timer, uint32_t index);
+    void siftUp(uint32_t index);
+    void siftDown(uint32_t index);
+    void push(LocTimerDelegate& timer);
+    // remove timer from the heap, returns timer if it was there, NULL otherwise
+    LocTimerDelegate* erase(LocTimerDelegate& timer);
+    // pop the soonest timer if it expires no later than now
+    LocTimerDelegate* popIfExpired(const struct timespec& now);
     // update the timer POSIX calls with updated soonest timer spec
     void updateSoonestTime(LocTimerDelegate* priorTop);
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    // counters of mSwTimers / mHwTimers, all 0 if never created
+    static LocTimerStats getStats(bool wakeOnExpire);
 
     LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
@@ -125,6 +144,9 @@ public:
     void add(LocTimerDelegate& timer);
     // remove a timer / alarm obj from the container
     void remove(LocTimerDelegate& timer);
+    // move a timer / alarm obj in the container to its new time out
+    void rearm(LocTimerDelegate& timer, const struct timespec& futureTime,
+               const struct timespec& deadline, uint32_t armCount);
     // handling of timer / alarm expiration
     void expire();
 };
@@ -171,26 +193,39 @@ public:
 
 // Internal class of timer obj. It gets born when client calls LocTimer::start();
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
-// This class implements LocRankable::ranks() so that when an obj is added into
-// the container (of LocHeap), it gets placed in sorted order.
-class LocTimerDelegate : public LocRankable {
+// The timer may fire anywhere from mFutureTime to mDeadline; the container is
+// ordered by mDeadline and the kernel is armed for the soonest one, upon which
+// all the timers whose windows have opened by then fire together.
+// mHeapIndex, mFutureTime, mDeadline and mQueuedArmCount belong to the container's MsgTask
+// context. mArmCount is counted up by LocTimer::restart() under mLock, so that
+// an expiration that races with a restart can tell the timer was re-armed.
+class LocTimerDelegate {
     friend class LocTimerContainer;
     friend class LocTimer;
+    static const uint32_t NOT_QUEUED = (uint32_t)-1;
     LocTimer* mClient;
     LocSharedLock* mLock;
     struct timespec mFutureTime;
+    struct timespec mDeadline;
     LocTimerContainer* mContainer;
-    // not a complete obj, just ctor for LocRankable comparisons
-    inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+    uint32_t mHeapIndex;
+    uint32_t mArmCount;
+    uint32_t mQueuedArmCount;
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
-    LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
+    LocTimerDelegate(LocTimer& client, struct timespec& futureTime, struct timespec& deadline,
+                     LocTimerContainer* container);
     void destroyLocked();
-    // LocRankable virtual method
-    virtual int ranks(LocRankable& rankable);
-    void expire();
-    inline struct timespec getFutureTime() { return mFutureTime; }
+    // true if this timer expires before the input one
+    inline bool expiresBefore(const LocTimerDelegate& timer) const {
+        return isBefore(mDeadline, timer.mDeadline);
+    }
+    static inline bool isBefore(const struct timespec& a, const struct timespec& b) {
+        return (a.tv_sec < b.tv_sec) || ((a.tv_sec == b.tv_sec) && (a.tv_nsec < b.tv_nsec));
+    }
+    // returns true if the client callback was called
+    bool expire();
+    inline struct timespec getDeadline() { return mDeadline; }
 };
 
 /***************************LocTimerContainer methods***************************/
@@ -210,7 +245,8 @@ LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mWakeupCount(0), mFiredCount(0), mCoalescedCount(0) {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -254,6 +290,19 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
     return container;
 }
 
+LocTimerStats LocTimerContainer::getStats(bool wakeOnExpire) {
+    LocTimerStats stats = {};
+    pthread_mutex_lock(&mMutex);
+    LocTimerContainer* container = wakeOnExpire ? mHwTimers : mSwTimers;
+    if (container) {
+        stats.wakeupCount = container->mWakeupCount.load(std::memory_order_relaxed);
+        stats.firedCount = container->mFiredCount.load(std::memory_order_relaxed);
+        stats.coalescedCount = container->mCoalescedCount.load(std::memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&mMutex);
+    return stats;
+}
+
 MsgTask* LocTimerContainer::getMsgTaskLocked() {
     // it is cheap to check pointer first than locking mutext unconditionally
     if (!mMsgTask) {
@@ -272,7 +321,7 @@ LocTimerPollTask* LocTimerContainer::getPollTaskLocked() {
 
 inline
 LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
-    return (LocTimerDelegate*)(peek());
+    return mTimers.empty() ? NULL : mTimers[0];
 }
 
 inline
@@ -295,11 +344,11 @@ void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
             delay.it_value.tv_sec = 0;
             delay.it_value.tv_nsec = 0;
             toSetTime = true;
-        } else if (!priorTop || curTop->outRanks(*priorTop)) {
+        } else if (!priorTop || curTop->expiresBefore(*priorTop)) {
             // do this first to avoid race condition, in case settime is called
             // with too small an interval
             mPollTask->addPoll(*this);
-            delay.it_value = curTop->getFutureTime();
+            delay.it_value = curTop->getDeadline();
             toSetTime = true;
         }
         if (toSetTime) {
@@ -313,13 +362,12 @@ inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
     struct MsgTimerPush : public LocMsg {
         LocTimerContainer* mTimerContainer;
-        LocHeapNode* mTree;
         LocTimerDelegate* mTimer;
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
+            mTimerContainer->push(*mTimer);
             mTimerContainer->updateSoonestTime(priorTop);
         }
     };
@@ -339,7 +387,7 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
 
             // update soonest timer only if mTimer is actually removed from
             // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
+            if (priorTop == mTimerContainer->erase(*mTimer)) {
                 // if passing in NULL, we tell updateSoonestTime to update
                 // kernel with the current top timer interval.
                 mTimerContainer->updateSoonestTime(NULL);
@@ -352,9 +400,43 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
     mMsgTask->sendMsg(new MsgTimerRemove(*this, timer));
 }
 
+// all the heap management is done in the MsgTask context.
+// A timer is never deleted before a rearm for it is handled, as the
+// MsgTimerRemove that deletes it is always sent after.
+void LocTimerContainer::rearm(LocTimerDelegate& timer, const struct timespec& futureTime,
+                              const struct timespec& deadline, uint32_t armCount) {
+    struct MsgTimerRearm : public LocMsg {
+        LocTimerContainer* mTimerContainer;
+        LocTimerDelegate* mTimer;
+        struct timespec mFutureTime;
+        struct timespec mDeadline;
+        uint32_t mArmCount;
+        inline MsgTimerRearm(LocTimerContainer& container, LocTimerDelegate& timer,
+                             const struct timespec& futureTime, const struct timespec& deadline,
+                             uint32_t armCount) :
+            LocMsg(), mTimerContainer(&container), mTimer(&timer),
+            mFutureTime(futureTime), mDeadline(deadline), mArmCount(armCount) {}
+        inline virtual void proc() const {
+            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
+            // the timer may have been popped for expiration already, in which
+            // case it gets pushed back
+            mTimerContainer->erase(*mTimer);
+            mTimer->mFutureTime = mFutureTime;
+            mTimer->mDeadline = mDeadline;
+            mTimer->mQueuedArmCount = mArmCount;
+            mTimerContainer->push(*mTimer);
+            // a later time out of the prior top needs kernel update too
+            mTimerContainer->updateSoonestTime(priorTop == mTimer ? NULL : priorTop);
+        }
+    };
+
+    mMsgTask->sendMsg(new MsgTimerRearm(*this, timer, futureTime, deadline, armCount));
+}
+
 // all the heap management is done in the MsgTask context.
 // Upon expire, we check and continuously pop the heap until
-// the top node's timeout is in the future.
+// the top node's timeout is in the future. Timers popped before
+// their deadline are coalesced into this wakeup.
 void LocTimerContainer::expire() {
     struct MsgTimerExpire : public LocMsg {
         LocTimerContainer* mTimerContainer;
@@ -364,15 +446,26 @@ void LocTimerContainer::expire() {
             struct timespec now;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
-            LocTimerDelegate timerOfNow(now);
-            // pop everything in the heap that outRanks now, i.e. has time older than now
-            // and then call expire() on that timer.
-            for (LocTimerDelegate* timer = (LocTimerDelegate*)mTimerContainer->pop();
+            uint64_t fired = 0;
+            uint64_t coalesced = 0;
+            // pop everything in the heap that has time older than now and
+            // then call expire() on that timer. The top may be in the future
+            // if it was removed or re-armed after the kernel timer went off.
+            for (LocTimerDelegate* timer = mTimerContainer->popIfExpired(now);
                  NULL != timer;
-                 timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
+                 timer = mTimerContainer->popIfExpired(now)) {
+                bool early = LocTimerDelegate::isBefore(now, timer->mDeadline);
                 // the timer delegate obj will be deleted before the return of this call
-                timer->expire();
+                if (timer->expire()) {
+                    fired++;
+                    if (early) {
+                        coalesced++;
+                    }
+                }
             }
+            mTimerContainer->mWakeupCount.fetch_add(1, std::memory_order_relaxed);
+            mTimerContainer->mFiredCount.fetch_add(fired, std::memory_order_relaxed);
+            mTimerContainer->mCoalescedCount.fetch_add(coalesced, std::memory_order_relaxed);
             mTimerContainer->updateSoonestTime(NULL);
         }
     };
@@ -384,10 +477,83 @@ void LocTimerContainer::expire() {
     mMsgTask->sendMsg(new MsgTimerExpire(*this));
 }
 
-LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
+inline
+void LocTimerContainer::place(LocTimerDelegate* timer, uint32_t index) {
+    mTimers[index] = timer;
+    timer->mHeapIndex = index;
+}
+
+void LocTimerContainer::siftUp(uint32_t index) {
+    LocTimerDelegate* timer = mTimers[index];
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 4;
+        if (!timer->expiresBefore(*mTimers[parent])) {
+            break;
+        }
+        place(mTimers[parent], index);
+        index = parent;
+    }
+    place(timer, index);
+}
+
+void LocTimerContainer::siftDown(uint32_t index) {
+    LocTimerDelegate* timer = mTimers[index];
+    uint32_t size = mTimers.size();
+    while (true) {
+        uint32_t child = index * 4 + 1;
+        if (child >= size) {
+            break;
+        }
+        // find the soonest of up to 4 children
+        uint32_t soonest = child;
+        uint32_t last = (child + 4 < size) ? child + 4 : size;
+        for (child++; child < last; child++) {
+            if (mTimers[child]->expiresBefore(*mTimers[soonest])) {
+                soonest = child;
+            }
+        }
+        if (!mTimers[soonest]->expiresBefore(*timer)) {
+            break;
+        }
+        place(mTimers[soonest], index);
+        index = soonest;
+    }
+    place(timer, index);
+}
+
+void LocTimerContainer::push(LocTimerDelegate& timer) {
+    mTimers.push_back(&timer);
+    siftUp(mTimers.size() - 1);
+}
+
+LocTimerDelegate* LocTimerContainer::erase(LocTimerDelegate& timer) {
+    uint32_t index = timer.mHeapIndex;
+    if (index >= mTimers.size() || mTimers[index] != &timer) {
+        return NULL;
+    }
+
+    timer.mHeapIndex = LocTimerDelegate::NOT_QUEUED;
+    LocTimerDelegate* last = mTimers.back();
+    mTimers.pop_back();
+    if (last != &timer) {
+        // fill the hole with the last timer and move it where it belongs
+        place(last, index);
+        if (index > 0 && last->expiresBefore(*mTimers[(index - 1) / 4])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    }
+    return &timer;
+}
+
+LocTimerDelegate* LocTimerContainer::popIfExpired(const struct timespec& now) {
     LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
-        poppedNode = (LocTimerDelegate*)(pop());
+    if (!mTimers.empty()) {
+        LocTimerDelegate* top = mTimers[0];
+        if (!LocTimerDelegate::isBefore(now, top->mFutureTime)) {
+            poppedNode = erase(*top);
+        }
     }
 
     return poppedNode;
@@ -478,11 +644,16 @@ bool LocTimerPollTask::run() {
 inline
 LocTimerDelegate::LocTimerDelegate(LocTimer& client,
                                    struct timespec& futureTime,
+                                   struct timespec& deadline,
                                    LocTimerContainer* container)
     : mClient(&client),
       mLock(mClient->mLock->share()),
       mFutureTime(futureTime),
-      mContainer(container) {
+      mDeadline(deadline),
+      mContainer(container),
+      mHeapIndex(NOT_QUEUED),
+      mArmCount(0),
+      mQueuedArmCount(0) {
     // adding the timer into the container
     mContainer->add(*this);
 }
@@ -506,35 +677,28 @@ void LocTimerDelegate::destroyLocked() {
       // once, and we want it reach there only once.
 }
 
-int LocTimerDelegate::ranks(LocRankable& rankable) {
-    int rank = -1;
-    LocTimerDelegate* timer = (LocTimerDelegate*)(&rankable);
-    if (timer) {
-        // larger time ranks lower!!!
-        // IOW, if input obj has bigger tv_sec/tv_nsec, this obj outRanks higher
-        rank = timer->mFutureTime.tv_sec - mFutureTime.tv_sec;
-        if(0 == rank)
-        {
-            //rank against tv_nsec for msec accuracy
-            rank = (int)(timer->mFutureTime.tv_nsec - mFutureTime.tv_nsec);
-        }
-    }
-    return rank;
-}
-
 inline
-void LocTimerDelegate::expire() {
+bool LocTimerDelegate::expire() {
     // keeping a copy of client pointer to be safe
     // when timeOutCallback() is called at the end of this
     // method, *this* obj may be already deleted.
-    LocTimer* client = mClient;
-    // force a stop, which will lead to delete of this obj
-    if (client && client->stop()) {
+    LocTimer* client = NULL;
+    mLock->lock();
+    // mClient is NULL if the timer has been stopped already. If restart()
+    // re-armed it after it was popped, the pending rearm pushes it back.
+    if (mClient && mArmCount == mQueuedArmCount) {
+        client = mClient;
+        // force a stop, which will lead to delete of this obj
+        client->mTimer = NULL;
+        destroyLocked();
+    }
+    mLock->unlock();
+    if (client) {
         // calling client callback with a pointer save on the stack
-        // only if stop() returns true, i.e. it hasn't been stopped
-        // already.
+        // only if it hasn't been stopped already.
         client->timeOutCallback();
     }
+    return (NULL != client);
 }
 
 
@@ -550,23 +714,42 @@ LocTimer::~LocTimer() {
     }
 }
 
+static void addMs(struct timespec& time, unsigned int ms) {
+    time.tv_sec += ms / 1000;
+    time.tv_nsec += (ms % 1000) * 1000000;
+    if (time.tv_nsec >= 1000000000) {
+        time.tv_sec += time.tv_nsec / 1000000000;
+        time.tv_nsec %= 1000000000;
+    }
+}
+
+// boot time timeOutInMs from now, and the latest time to fire after that.
+// Wakeup timers always fire on time.
+static void getFutureTime(unsigned int timeOutInMs, unsigned int slackInMs, bool wakeOnExpire,
+                          struct timespec& futureTime, struct timespec& deadline) {
+    clock_gettime(CLOCK_BOOTTIME, &futureTime);
+    addMs(futureTime, timeOutInMs);
+    deadline = futureTime;
+    if (!wakeOnExpire) {
+        addMs(deadline, slackInMs);
+    }
+}
+
 bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
+    return start(timeOutInMs, wakeOnExpire, 0);
+}
+
+bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire, unsigned int slackInMs) {
     bool success = false;
     mLock->lock();
     if (!mTimer) {
-        struct timespec futureTime;
-        clock_gettime(CLOCK_BOOTTIME, &futureTime);
-        futureTime.tv_sec += timeOutInMs / 1000;
-        futureTime.tv_nsec += (timeOutInMs % 1000) * 1000000;
-        if (futureTime.tv_nsec >= 1000000000) {
-            futureTime.tv_sec += futureTime.tv_nsec / 1000000000;
-            futureTime.tv_nsec %= 1000000000;
-        }
+        struct timespec futureTime, deadline;
+        getFutureTime(timeOutInMs, slackInMs, wakeOnExpire, futureTime, deadline);
 
         LocTimerContainer* container;
         container = LocTimerContainer::get(wakeOnExpire);
         if (NULL != container) {
-            mTimer = new LocTimerDelegate(*this, futureTime, container);
+            mTimer = new LocTimerDelegate(*this, futureTime, deadline, container);
             // if mTimer is non 0, success should be 0; or vice versa
         }
         success = (NULL != mTimer);
@@ -575,6 +758,30 @@ bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
     return success;
 }
 
+bool LocTimer::restart(unsigned int timeOutInMs, bool wakeOnExpire, unsigned int slackInMs) {
+    bool success = false;
+    mLock->lock();
+    LocTimerContainer* container = LocTimerContainer::get(wakeOnExpire);
+    if (mTimer && NULL != container && mTimer->mContainer == container) {
+        struct timespec futureTime, deadline;
+        getFutureTime(timeOutInMs, slackInMs, wakeOnExpire, futureTime, deadline);
+        container->rearm(*mTimer, futureTime, deadline, ++mTimer->mArmCount);
+        success = true;
+    }
+    mLock->unlock();
+
+    if (!success) {
+        // not running, or running in the other container
+        stop();
+        success = start(timeOutInMs, wakeOnExpire, slackInMs);
+    }
+    return success;
+}
+
+LocTimerStats LocTimer::getStats(bool wakeOnExpire) {
+    return LocTimerContainer::getStats(wakeOnExpire);
+}
+
 bool LocTimer::stop() {
     bool success = false;
     mLock->lock();
@@ -33,6 +33,14 @@
 #include <stddef.h>
 #include <loc_pla.h>
 
+// Counters of one timer container, see LocTimer::getStats()
+struct LocTimerStats {
+    uint64_t wakeupCount;    // kernel timer expirations handled
+    uint64_t firedCount;     // timers fired upon those expirations
+    uint64_t coalescedCount; // ... of which fired early within their slack,
+                             //     i.e. wakeups saved
+};
+
 // opaque class to provide service implementation.
 class LocTimerDelegate;
 class LocSharedLock;
@@ -61,10 +69,27 @@ public:
     //               false on failure, e.g. timer is already running.
     bool start(uint32_t timeOutInMs, bool wakeOnExpire);
 
+    // Same as start() above, plus
+    // slackInMs:    how late the timer may fire, so that it can share a
+    //               wakeup with other timers. Ignored if wakeOnExpire.
+    bool start(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs);
+
+    // Same as stop() followed by start(), except that a running timer is
+    // re-armed in place rather than torn down and created again.
+    // timeOutInMs:  timeout delay in ms, counted from now
+    // wakeOnExpire: same as start()
+    // slackInMs:    same as start()
+    // return:       true on success;
+    //               false on failure.
+    bool restart(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs = 0);
+
     // return:       true on success;
     //               false on failure, e.g. timer is not running.
     bool stop();
 
+    // counters of the wakeOnExpire or the non wakeup timers of the process
+    static LocTimerStats getStats(bool wakeOnExpire);
+
     //  LocTimer client Should implement this method.
     //  This method is used for timeout calling back to client. This method
     //  should be short enough (eg: send a message to your own thread).
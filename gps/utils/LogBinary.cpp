@@ -0,0 +1,412 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "LogBinary.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace loc_util {
+
+enum LogArgLength {
+    LOG_ARG_LEN_NONE,
+    LOG_ARG_LEN_HH,
+    LOG_ARG_LEN_H,
+    LOG_ARG_LEN_L,
+    LOG_ARG_LEN_LL,
+    LOG_ARG_LEN_J,
+    LOG_ARG_LEN_Z,
+    LOG_ARG_LEN_T,
+    LOG_ARG_LEN_LONG_DOUBLE
+};
+
+// one printf conversion spec
+struct LogArgSpec {
+    const char* flags;
+    size_t flagsLen;
+    bool widthStar;
+    int width;          // -1 if none
+    bool hasPrecision;
+    bool precisionStar;
+    int precision;      // -1 if none
+    LogArgLength length;
+    char conversion;
+};
+
+// Parses the conversion spec following a '%'.
+// return: the char past the spec; nullptr if the format ends within it
+static const char* parseSpec(const char* p, LogArgSpec& spec) {
+    spec.flags = p;
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    spec.flagsLen = p - spec.flags;
+
+    spec.widthStar = false;
+    spec.width = -1;
+    if ('*' == *p) {
+        spec.widthStar = true;
+        p++;
+    } else if (*p >= '0' && *p <= '9') {
+        for (spec.width = 0; *p >= '0' && *p <= '9'; p++) {
+            spec.width = spec.width * 10 + (*p - '0');
+        }
+    }
+
+    spec.hasPrecision = false;
+    spec.precisionStar = false;
+    spec.precision = -1;
+    if ('.' == *p) {
+        spec.hasPrecision = true;
+        p++;
+        if ('*' == *p) {
+            spec.precisionStar = true;
+            p++;
+        } else {
+            for (spec.precision = 0; *p >= '0' && *p <= '9'; p++) {
+                spec.precision = spec.precision * 10 + (*p - '0');
+            }
+        }
+    }
+
+    spec.length = LOG_ARG_LEN_NONE;
+    switch (*p) {
+    case 'h':
+        spec.length = ('h' == *++p) ? (p++, LOG_ARG_LEN_HH) : LOG_ARG_LEN_H;
+        break;
+    case 'l':
+        spec.length = ('l' == *++p) ? (p++, LOG_ARG_LEN_LL) : LOG_ARG_LEN_L;
+        break;
+    case 'q': spec.length = LOG_ARG_LEN_LL; p++; break;
+    case 'j': spec.length = LOG_ARG_LEN_J; p++; break;
+    case 'z': spec.length = LOG_ARG_LEN_Z; p++; break;
+    case 't': spec.length = LOG_ARG_LEN_T; p++; break;
+    case 'L': spec.length = LOG_ARG_LEN_LONG_DOUBLE; p++; break;
+    default: break;
+    }
+
+    spec.conversion = *p;
+    return ('\0' == *p) ? nullptr : p + 1;
+}
+
+int encodeLogArgs(char* buf, size_t size, const char* format, va_list args) {
+    size_t len = 0;
+    auto put = [&](const void* value, size_t n) {
+        if (n > size - len) {
+            return false;
+        }
+        memcpy(buf + len, value, n);
+        len += n;
+        return true;
+    };
+
+    for (const char* p = format; *p; ) {
+        if ('%' != *p++) {
+            continue;
+        }
+        if ('%' == *p) {
+            p++;
+            continue;
+        }
+        LogArgSpec spec;
+        p = parseSpec(p, spec);
+        if (nullptr == p) {
+            return -1;
+        }
+
+        int64_t precision = spec.precision;
+        if (spec.widthStar) {
+            int64_t width = va_arg(args, int);
+            if (!put(&width, sizeof(width))) {
+                return -1;
+            }
+        }
+        if (spec.precisionStar) {
+            precision = va_arg(args, int);
+            if (!put(&precision, sizeof(precision))) {
+                return -1;
+            }
+        }
+
+        bool fits = true;
+        switch (spec.conversion) {
+        case 'd':
+        case 'i': {
+            int64_t value;
+            switch (spec.length) {
+            case LOG_ARG_LEN_HH: value = (signed char)va_arg(args, int); break;
+            case LOG_ARG_LEN_H: value = (short)va_arg(args, int); break;
+            case LOG_ARG_LEN_L: value = va_arg(args, long); break;
+            case LOG_ARG_LEN_LL: value = va_arg(args, long long); break;
+            case LOG_ARG_LEN_J: value = va_arg(args, intmax_t); break;
+            case LOG_ARG_LEN_Z: value = va_arg(args, ssize_t); break;
+            case LOG_ARG_LEN_T: value = va_arg(args, ptrdiff_t); break;
+            default: value = va_arg(args, int); break;
+            }
+            fits = put(&value, sizeof(value));
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t value;
+            switch (spec.length) {
+            case LOG_ARG_LEN_HH: value = (unsigned char)va_arg(args, unsigned int); break;
+            case LOG_ARG_LEN_H: value = (unsigned short)va_arg(args, unsigned int); break;
+            case LOG_ARG_LEN_L: value = va_arg(args, unsigned long); break;
+            case LOG_ARG_LEN_LL: value = va_arg(args, unsigned long long); break;
+            case LOG_ARG_LEN_J: value = va_arg(args, uintmax_t); break;
+            case LOG_ARG_LEN_Z: value = va_arg(args, size_t); break;
+            case LOG_ARG_LEN_T: value = (uint64_t)va_arg(args, ptrdiff_t); break;
+            default: value = va_arg(args, unsigned int); break;
+            }
+            fits = put(&value, sizeof(value));
+            break;
+        }
+        case 'c': {
+            if (LOG_ARG_LEN_L == spec.length) {
+                return -1;
+            }
+            int64_t value = va_arg(args, int);
+            fits = put(&value, sizeof(value));
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double value = (LOG_ARG_LEN_LONG_DOUBLE == spec.length) ?
+                    (double)va_arg(args, long double) : va_arg(args, double);
+            fits = put(&value, sizeof(value));
+            break;
+        }
+        case 's': {
+            if (LOG_ARG_LEN_L == spec.length) {
+                return -1;
+            }
+            const char* str = va_arg(args, const char*);
+            if (nullptr == str) {
+                str = "(null)";
+            }
+            // the precision bounds the read, the string need not be terminated
+            size_t n = (precision >= 0) ? strnlen(str, precision) : strlen(str);
+            fits = put(str, n) && put("", 1);
+            break;
+        }
+        case 'p': {
+            uint64_t value = (uintptr_t)va_arg(args, void*);
+            fits = put(&value, sizeof(value));
+            break;
+        }
+        case 'n':
+            (void)va_arg(args, void*);
+            break;
+        default:
+            return -1;
+        }
+        if (!fits) {
+            return -1;
+        }
+    }
+    return (int)len;
+}
+
+static void appendFormatted(string& out, const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n < 0) {
+        return;
+    }
+    if ((size_t)n < sizeof(buf)) {
+        out.append(buf, n);
+    } else {
+        size_t len = out.size();
+        out.resize(len + n + 1);
+        va_start(args, format);
+        vsnprintf(&out[len], n + 1, format, args);
+        va_end(args);
+        out.resize(len + n);
+    }
+}
+
+void renderLogArgs(string& out, const char* format, const char* args, size_t len) {
+    size_t pos = 0;
+    auto get = [&](void* value, size_t n) {
+        if (n > len - pos) {
+            return false;
+        }
+        memcpy(value, args + pos, n);
+        pos += n;
+        return true;
+    };
+
+    const char* p = format;
+    while (*p) {
+        const char* percent = strchr(p, '%');
+        if (nullptr == percent) {
+            out.append(p);
+            break;
+        }
+        out.append(p, percent - p);
+        p = percent + 1;
+        if ('%' == *p) {
+            out.push_back('%');
+            p++;
+            continue;
+        }
+        LogArgSpec spec;
+        const char* next = parseSpec(p, spec);
+        if (nullptr == next) {
+            out.append(percent);
+            break;
+        }
+        p = next;
+
+        // rebuild the spec with the '*' values filled in, and the length of
+        // the packed value in place of the original one
+        int64_t width = spec.width;
+        int64_t precision = spec.precision;
+        bool ok = (!spec.widthStar || get(&width, sizeof(width))) &&
+                (!spec.precisionStar || get(&precision, sizeof(precision)));
+        char conv[48];
+        int n = snprintf(conv, sizeof(conv), "%%%.*s%s", (int)min(spec.flagsLen, (size_t)8),
+                         spec.flags, (width < 0 && spec.widthStar) ? "-" : "");
+        if (width != -1 || spec.widthStar) {
+            n += snprintf(conv + n, sizeof(conv) - n, "%d",
+                          (int)min<int64_t>(width < 0 ? -width : width, 4096));
+        }
+        if (spec.hasPrecision && precision >= 0) {
+            n += snprintf(conv + n, sizeof(conv) - n, ".%d",
+                          (int)min<int64_t>(precision, 4096));
+        }
+
+        switch (spec.conversion) {
+        case 'd':
+        case 'i': {
+            int64_t value;
+            if ((ok = ok && get(&value, sizeof(value)))) {
+                snprintf(conv + n, sizeof(conv) - n, "ll%c", spec.conversion);
+                appendFormatted(out, conv, (long long)value);
+            }
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t value;
+            if ((ok = ok && get(&value, sizeof(value)))) {
+                snprintf(conv + n, sizeof(conv) - n, "ll%c", spec.conversion);
+                appendFormatted(out, conv, (unsigned long long)value);
+            }
+            break;
+        }
+        case 'c': {
+            int64_t value;
+            if ((ok = ok && get(&value, sizeof(value)))) {
+                snprintf(conv + n, sizeof(conv) - n, "c");
+                appendFormatted(out, conv, (int)value);
+            }
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double value;
+            if ((ok = ok && get(&value, sizeof(value)))) {
+                snprintf(conv + n, sizeof(conv) - n, "%c", spec.conversion);
+                appendFormatted(out, conv, value);
+            }
+            break;
+        }
+        case 's': {
+            const char* str = args + pos;
+            size_t strLen = strnlen(str, len - pos);
+            if ((ok = ok && strLen < len - pos)) {
+                pos += strLen + 1;
+                snprintf(conv + n, sizeof(conv) - n, "s");
+                appendFormatted(out, conv, str);
+            }
+            break;
+        }
+        case 'p': {
+            uint64_t value;
+            if ((ok = ok && get(&value, sizeof(value)))) {
+                snprintf(conv + n, sizeof(conv) - n, "p");
+                appendFormatted(out, conv, (void*)(uintptr_t)value);
+            }
+            break;
+        }
+        case 'n':
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok) {
+            out.append("<?>");
+        }
+    }
+}
+
+int formatLogHead(char* buf, size_t size, uint64_t realTimeNs, int32_t pid, int32_t tid,
+                  const char* tag) {
+    uint64_t sec = realTimeNs / 1000000000;
+    return snprintf(buf, size, "%02d:%02d:%02d.%06ld %d %ld %s :",
+                    (int)(sec / 3600 % 24), (int)(sec % 3600 / 60), (int)(sec % 60),
+                    (long)(realTimeNs % 1000000000 / 1000), pid, (long)tid,
+                    (nullptr == tag) ? "" : tag);
+}
+
+void renderLogLine(string& out, uint64_t realTimeNs, int32_t pid, int32_t tid,
+                   const char* tag, const char* format, const char* args, size_t len) {
+    char head[LOG_BINARY_HEAD_LEN];
+    int n = formatLogHead(head, sizeof(head), realTimeNs, pid, tid, tag);
+    out.append(head, min((size_t)max(n, 0), sizeof(head) - 1));
+    renderLogArgs(out, format, args, len);
+    out.push_back('\n');
+}
+
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOG_BINARY_H
+#define LOG_BINARY_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Deferred formatting of the LOC_LOGx lines kept in binary in LogBuffer.
+// A line is kept as the address of its format literal plus its arguments,
+// packed in the order the format consumes them: integers, pointers and
+// '*' widths as 8 byte integers, floating point as 8 byte doubles and
+// strings as NUL terminated copies. The sizes don't depend on the ABI of
+// the logging process, so a dump taken on target renders on a host.
+
+//magic at the start of a binary log buffer dump, and of each dump
+//appended to the same file later on
+#define LOG_BINARY_FILE_MAGIC "GPSLOGB1"
+//binary log buffer dump file entries
+#define LOG_BINARY_ENTRY_STRING 'S'
+#define LOG_BINARY_ENTRY_LINE   'L'
+//room for the head of a line, see formatLogHead()
+#define LOG_BINARY_HEAD_LEN 128
+
+namespace loc_util {
+
+// Packs the arguments of format into buf.
+// return: number of bytes used in buf;
+//         -1 if they don't fit in size bytes, or format has a conversion
+//         that can't be deferred, e.g. %ls. args is consumed either way.
+int encodeLogArgs(char* buf, size_t size, const char* format, va_list args);
+
+// Appends format, with the arguments packed by encodeLogArgs(), to out.
+// Conversions missing their arguments render as "<?>".
+void renderLogArgs(std::string& out, const char* format, const char* args, size_t len);
+
+// Prints the head INSERT_BUFFER gives a text line, "hh:mm:ss.us pid tid tag :",
+// into buf. Returns what snprintf() returns.
+int formatLogHead(char* buf, size_t size, uint64_t realTimeNs, int32_t pid, int32_t tid,
+                  const char* tag);
+
+// Appends a whole line to out: the head, format and "\n".
+void renderLogLine(std::string& out, uint64_t realTimeNs, int32_t pid, int32_t tid,
+                   const char* tag, const char* format, const char* args, size_t len);
+
+}
+
+#endif
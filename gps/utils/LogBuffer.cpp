@@ -28,10 +28,27 @@
  */
 
 #include "LogBuffer.h"
+#include <LocConfWatcher.h>
 #include <utils/Log.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <unordered_set>
 
 #define LOG_TAG "LocSvc_LogBuffer"
 
+#define NS_PER_SEC ((uint64_t)1000000000)
+// slots append() tries before giving a line up
+#define LOG_BUFFER_CLAIM_TRIES 4
+// output buffered by dumpToFd() between writes
+#define LOG_BUFFER_DUMP_BUF_LEN 4096
+// format and tag strings dumpToFd() writes to a binary dump only once
+#define LOG_BUFFER_DUMP_STRINGS 256
+
+using namespace std;
+
 namespace loc_util {
 
 LogBuffer* LogBuffer::mInstance;
@@ -41,66 +58,253 @@ mutex LogBuffer::sLock;
 
 LogBuffer* LogBuffer::getInstance() {
     if (mInstance == nullptr) {
-        lock_guard<mutex> guard(sLock);
-        if (mInstance == nullptr) {
-            mInstance = new LogBuffer();
+        bool created = false;
+        {
+            lock_guard<mutex> guard(sLock);
+            if (mInstance == nullptr) {
+                mInstance = new LogBuffer();
+                created = true;
+            }
+        }
+        // out of sLock, as the watcher logs, i.e. comes back to getInstance()
+        if (created) {
+            LocConfWatcher::getInstance().addWatch(LOC_PATH_GPS_CONF_STR,
+                    [] (const char*) { mInstance->reloadConfig(); });
         }
     }
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
+LogBuffer::LogBuffer():
         mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
-                    MAXIMUM_NUM_IN_LIST, 0)) {
+                    MAXIMUM_NUM_IN_LIST)) {
+    readConfig(mConfigVec);
+
+    // all the memory the buffer will ever use is taken here, up front
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        mRings[i].mCapacity = mConfigVec[i].mMaxNumThres;
+        if (mRings[i].mCapacity > 0) {
+            mRings[i].mRecords.reset(new LogBufferRecord[mRings[i].mCapacity]);
+        }
+    }
+    mPid = getpid();
+
+    // what the crash dump needs is set up here, it can't be from a signal handler
+    mDumpDirFd = open(LOG_BUFFER_FILE_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (mDumpDirFd < 0) {
+        ALOGE("failed to open %s, errno: %d", LOG_BUFFER_FILE_PATH, errno);
+    }
+    time_t now = time(NULL);
+    struct tm localTime;
+    mUtcOffset = (nullptr != localtime_r(&now, &localTime)) ? localTime.tm_gmtoff : 0;
+    registerSignalHandler();
+}
+
+void LogBuffer::readConfig(vector<ConfigsInLevel>& configs) {
     loc_param_s_type log_buff_config_table[] =
     {
-        {"E_LEVEL_TIME_DEPTH",      &mConfigVec[0].mTimeDepthThres,  NULL, 'n'},
-        {"E_LEVEL_MAX_CAPACITY",    &mConfigVec[0].mMaxNumThres,     NULL, 'n'},
-        {"W_LEVEL_TIME_DEPTH",      &mConfigVec[1].mTimeDepthThres,  NULL, 'n'},
-        {"W_LEVEL_MAX_CAPACITY",    &mConfigVec[1].mMaxNumThres,     NULL, 'n'},
-        {"I_LEVEL_TIME_DEPTH",      &mConfigVec[2].mTimeDepthThres,  NULL, 'n'},
-        {"I_LEVEL_MAX_CAPACITY",    &mConfigVec[2].mMaxNumThres,     NULL, 'n'},
-        {"D_LEVEL_TIME_DEPTH",      &mConfigVec[3].mTimeDepthThres,  NULL, 'n'},
-        {"D_LEVEL_MAX_CAPACITY",    &mConfigVec[3].mMaxNumThres,     NULL, 'n'},
-        {"V_LEVEL_TIME_DEPTH",      &mConfigVec[4].mTimeDepthThres,  NULL, 'n'},
-        {"V_LEVEL_MAX_CAPACITY",    &mConfigVec[4].mMaxNumThres,     NULL, 'n'},
+        {"E_LEVEL_TIME_DEPTH",      &configs[0].mTimeDepthThres,  NULL, 'n'},
+        {"E_LEVEL_MAX_CAPACITY",    &configs[0].mMaxNumThres,     NULL, 'n'},
+        {"W_LEVEL_TIME_DEPTH",      &configs[1].mTimeDepthThres,  NULL, 'n'},
+        {"W_LEVEL_MAX_CAPACITY",    &configs[1].mMaxNumThres,     NULL, 'n'},
+        {"I_LEVEL_TIME_DEPTH",      &configs[2].mTimeDepthThres,  NULL, 'n'},
+        {"I_LEVEL_MAX_CAPACITY",    &configs[2].mMaxNumThres,     NULL, 'n'},
+        {"D_LEVEL_TIME_DEPTH",      &configs[3].mTimeDepthThres,  NULL, 'n'},
+        {"D_LEVEL_MAX_CAPACITY",    &configs[3].mMaxNumThres,     NULL, 'n'},
+        {"V_LEVEL_TIME_DEPTH",      &configs[4].mTimeDepthThres,  NULL, 'n'},
+        {"V_LEVEL_MAX_CAPACITY",    &configs[4].mMaxNumThres,     NULL, 'n'},
     };
     loc_read_conf(LOC_PATH_GPS_CONF_STR, log_buff_config_table,
             sizeof(log_buff_config_table)/sizeof(log_buff_config_table[0]));
-    registerSignalHandler();
+}
+
+void LogBuffer::reloadConfig() {
+    vector<ConfigsInLevel> configs(mConfigVec);
+    readConfig(configs);
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        if (configs[i].mTimeDepthThres != mConfigVec[i].mTimeDepthThres) {
+            ALOGI("%s_LEVEL_TIME_DEPTH %u -> %u", mLevelMap[i].c_str(),
+                    mConfigVec[i].mTimeDepthThres, configs[i].mTimeDepthThres);
+            // a single word store, dump() sees either the old or the new depth
+            mConfigVec[i].mTimeDepthThres = configs[i].mTimeDepthThres;
+        }
+        if (configs[i].mMaxNumThres != mConfigVec[i].mMaxNumThres) {
+            // the rings are allocated once, a new capacity needs a restart
+            ALOGW("%s_LEVEL_MAX_CAPACITY %u -> %u ignored until restart", mLevelMap[i].c_str(),
+                    mConfigVec[i].mMaxNumThres, configs[i].mMaxNumThres);
+        }
+    }
+}
+
+LogBufferRecord* LogBuffer::claim(int level, uint64_t& index) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS || 0 == mRings[level].mCapacity) {
+        return nullptr;
+    }
+    LogBufferRing& ring = mRings[level];
+
+    // The slot handed out may still be in the hands of a writer preempted
+    // a lap ago, or, if this thread got preempted for a whole lap, may
+    // already hold a newer line; move on to a fresh index then, leaving
+    // that index a hole which dump() skips.
+    for (int tries = 0; tries < LOG_BUFFER_CLAIM_TRIES; tries++) {
+        index = ring.mWriteIndex.fetch_add(1, memory_order_relaxed);
+        LogBufferRecord& slot = ring.mRecords[index % ring.mCapacity];
+        uint64_t seq = slot.mSeq.load(memory_order_relaxed);
+        while (0 == (seq & 1) && seq <= 2 * index) {
+            if (slot.mSeq.compare_exchange_weak(seq, 2 * index + 1, memory_order_relaxed)) {
+                atomic_thread_fence(memory_order_release);
+                return &slot;
+            }
+        }
+    }
+    ring.mDroppedCount.fetch_add(1, memory_order_relaxed);
+    return nullptr;
+}
+
+void LogBuffer::publish(LogBufferRecord* record, uint64_t index, uint64_t bootTimeNs) {
+    record->mBootTimeNs = bootTimeNs;
+    record->mSeq.store(2 * index + 2, memory_order_release);
+}
+
+void LogBuffer::append(const char* data, size_t len, int level, uint64_t bootTimeNs) {
+    uint64_t index = 0;
+    LogBufferRecord* record = claim(level, index);
+    if (nullptr == record) {
+        return;
+    }
+    if (len > LOG_BUFFER_RECORD_LEN) {
+        len = LOG_BUFFER_RECORD_LEN;
+    }
+    memcpy(record->mText, data, len);
+    record->mLen = len;
+    record->mFormat = nullptr;
+    publish(record, index, bootTimeNs);
 }
 
 void LogBuffer::append(string& data, int level, uint64_t timestamp) {
-    lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
+    append(data.c_str(), data.size(), level, timestamp * NS_PER_SEC);
+}
 
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+void LogBuffer::appendBinary(int level, const char* tag, const char* format, va_list args,
+                             uint64_t bootTimeNs, uint64_t realTimeNs, int32_t tid) {
+    uint64_t index = 0;
+    LogBufferRecord* record = claim(level, index);
+    if (nullptr == record) {
+        return;
+    }
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int len = encodeLogArgs(record->mText, LOG_BUFFER_RECORD_LEN, format, argsCopy);
+    va_end(argsCopy);
+    if (len >= 0) {
+        record->mFormat = format;
+        record->mTag = tag;
+        record->mTid = tid;
+        record->mRealTimeNs = realTimeNs;
+    } else {
+        // arguments that can't be deferred, format the line right away
+        char* text = record->mText;
+        len = formatLogHead(text, LOG_BUFFER_RECORD_LEN, realTimeNs, mPid, tid, tag);
+        len = min(max(len, 0), LOG_BUFFER_RECORD_LEN - 1);
+        len += max(vsnprintf(text + len, LOG_BUFFER_RECORD_LEN - len, format, args), 0);
+        len = min(len, LOG_BUFFER_RECORD_LEN - 2);
+        text[len++] = '\n';
+        record->mFormat = nullptr;
+    }
+    record->mLen = len;
+    publish(record, index, bootTimeNs);
+}
+
+// a line copied out of the buffer by collect()
+struct LogBuffer::Line {
+    uint64_t bootTimeNs;
+    int level;
+    const char* format;
+    const char* tag;
+    int32_t tid;
+    uint64_t realTimeNs;
+    string text;
+};
+
+// Copies line index of level into out, without locking and without
+// allocating, so it can run in a signal handler too.
+// return: false if the line is gone, or is being overwritten
+bool LogBuffer::readRecord(int level, uint64_t index, LogBufferRecord& out) {
+    LogBufferRecord& record = mRings[level].mRecords[index % mRings[level].mCapacity];
+    if (record.mSeq.load(memory_order_acquire) != 2 * index + 2) {
+        return false;
+    }
+    out.mBootTimeNs = record.mBootTimeNs;
+    out.mFormat = record.mFormat;
+    out.mTag = record.mTag;
+    out.mTid = record.mTid;
+    out.mRealTimeNs = record.mRealTimeNs;
+    out.mLen = min(record.mLen, (uint32_t)LOG_BUFFER_RECORD_LEN);
+    memcpy(out.mText, record.mText, out.mLen);
+    // keep the copy only if no writer touched the slot meanwhile
+    atomic_thread_fence(memory_order_acquire);
+    return record.mSeq.load(memory_order_relaxed) == 2 * index + 2;
+}
+
+// Copies the lines of level, or of all the levels if level is -1, out of the
+// buffer, oldest first. Returns the number of lines dropped by append().
+uint64_t LogBuffer::collect(vector<Line>& li, int level) {
+    uint64_t dropped = 0;
+    LogBufferRecord record;
+    for (int l = 0; l < TOTAL_LOG_LEVELS; l++) {
+        LogBufferRing& ring = mRings[l];
+        if ((-1 != level && l != level) || 0 == ring.mCapacity) {
+            continue;
+        }
+        uint64_t end = ring.mWriteIndex.load(memory_order_acquire);
+        uint64_t begin = max(ring.mFlushIndex.load(memory_order_relaxed),
+                             end > ring.mCapacity ? end - ring.mCapacity : 0);
+        size_t first = li.size();
+        for (uint64_t index = begin; index < end; index++) {
+            if (readRecord(l, index, record)) {
+                li.push_back({record.mBootTimeNs, l, record.mFormat, record.mTag, record.mTid,
+                              record.mRealTimeNs, string(record.mText, record.mLen)});
+            }
+        }
+        // apply the time depth of the level against its newest line
+        if (li.size() > first) {
+            uint64_t newest = 0;
+            for (size_t i = first; i < li.size(); i++) {
+                newest = max(newest, li[i].bootTimeNs / NS_PER_SEC);
+            }
+            li.erase(remove_if(li.begin() + first, li.end(), [&](const Line& line) {
+                return newest - line.bootTimeNs / NS_PER_SEC > mConfigVec[l].mTimeDepthThres;
+            }), li.end());
+        }
+        dropped += ring.mDroppedCount.load(memory_order_relaxed);
     }
+    stable_sort(li.begin(), li.end(), [](const Line& a, const Line& b) {
+        return a.bootTimeNs < b.bootTimeNs;
+    });
+    return dropped;
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
-    lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
-    }
-    ALOGE("Begining of dump, buffer size: %d", (int)li.size());
+    vector<Line> li;
+    uint64_t dropped = collect(li, level);
+
+    ALOGE("Begining of dump, buffer size: %d, dropped: %" PRIu64, (int)li.size(), dropped);
     stringstream ln;
     ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+    for_each (li.begin(), li.end(), [&, this](const Line &item){
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        line << "["<< item.bootTimeNs / NS_PER_SEC << "] ";
+        line << "Level " << mLevelMap[item.level] << ": ";
+        if (nullptr != item.format) {
+            string text;
+            renderLogLine(text, item.realTimeNs, mPid, item.tid, item.tag, item.format,
+                          item.text.data(), item.text.size());
+            line << text << endl;
+        } else {
+            line << item.text << endl;
+        }
         if (log != nullptr) {
             log(line);
         }
@@ -124,8 +328,204 @@ void LogBuffer::dumpToLogFile(string filePath) {
     s.close();
 }
 
+void LogBuffer::dumpBinaryToLogFile(string filePath) {
+    ALOGE("Dump GPS binary log buffer to file: %s", filePath.c_str());
+    int fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGE("failed to open %s, errno: %d", filePath.c_str(), errno);
+        return;
+    }
+    dumpToFd(fd, true);
+    close(fd);
+}
+
+// Buffers output for write(2), on the stack of an async-signal-safe dump.
+class LogBufferFdWriter {
+    int mFd;
+    size_t mLen;
+    char mBuf[LOG_BUFFER_DUMP_BUF_LEN];
+public:
+    inline LogBufferFdWriter(int fd): mFd(fd), mLen(0) {}
+    inline ~LogBufferFdWriter() { flush(); }
+
+    void flush() {
+        const char* data = mBuf;
+        while (mLen > 0 && mFd >= 0) {
+            ssize_t n = write(mFd, data, mLen);
+            if (n > 0) {
+                data += n;
+                mLen -= n;
+            } else if (n < 0 && EINTR != errno) {
+                mFd = -1;
+            }
+        }
+        mLen = 0;
+    }
+    void put(const void* data, size_t len) {
+        const char* bytes = (const char*)data;
+        while (len > 0) {
+            if (mLen == sizeof(mBuf)) {
+                flush();
+            }
+            size_t n = min(len, sizeof(mBuf) - mLen);
+            memcpy(mBuf + mLen, bytes, n);
+            mLen += n;
+            bytes += n;
+            len -= n;
+        }
+    }
+    inline void putStr(const char* str) { put(str, strlen(str)); }
+    void putUint(uint64_t value) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[sizeof(digits) - ++n] = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        put(digits + sizeof(digits) - n, n);
+    }
+};
+
+// Writes all the lines to fd, oldest first, as dumpToLogFile() would in text,
+// or in the format of loc_log_decode if binary. Only async-signal-safe calls
+// are made: the levels are merged in place, one line of each at a time
+// copied out on the stack, and fd is written with write(2).
+void LogBuffer::dumpToFd(int fd, bool binary) {
+    static const char* levelNames[TOTAL_LOG_LEVELS] = {"E", "W", "I", "D", "V"};
+    LogBufferFdWriter out(fd);
+    LogBufferRecord heads[TOTAL_LOG_LEVELS];
+    uint64_t next[TOTAL_LOG_LEVELS] = {};
+    uint64_t end[TOTAL_LOG_LEVELS] = {};
+    uint64_t oldest[TOTAL_LOG_LEVELS] = {};
+    bool valid[TOTAL_LOG_LEVELS] = {};
+    // the format and tag strings already written to a binary dump; once
+    // full, strings are simply written again
+    const char* written[LOG_BUFFER_DUMP_STRINGS] = {};
+
+    // loads the next line of level l which is within its time depth
+    auto advance = [&](int l) {
+        valid[l] = false;
+        for (; !valid[l] && next[l] < end[l]; next[l]++) {
+            valid[l] = readRecord(l, next[l], heads[l]) &&
+                    heads[l].mBootTimeNs / NS_PER_SEC >= oldest[l];
+        }
+    };
+    auto putString = [&](const char* str) {
+        size_t slot = ((uintptr_t)str >> 3) % LOG_BUFFER_DUMP_STRINGS;
+        for (size_t i = 0; i < LOG_BUFFER_DUMP_STRINGS; i++) {
+            size_t s = (slot + i) % LOG_BUFFER_DUMP_STRINGS;
+            if (written[s] == str) {
+                return;
+            } else if (nullptr == written[s]) {
+                written[s] = str;
+                break;
+            }
+        }
+        uint8_t type = LOG_BINARY_ENTRY_STRING;
+        uint64_t id = (uintptr_t)str;
+        uint32_t len = strlen(str);
+        out.put(&type, sizeof(type));
+        out.put(&id, sizeof(id));
+        out.put(&len, sizeof(len));
+        out.put(str, len);
+    };
+
+    for (int l = 0; l < TOTAL_LOG_LEVELS; l++) {
+        LogBufferRing& ring = mRings[l];
+        if (0 == ring.mCapacity) {
+            continue;
+        }
+        end[l] = ring.mWriteIndex.load(memory_order_acquire);
+        next[l] = max(ring.mFlushIndex.load(memory_order_relaxed),
+                      end[l] > ring.mCapacity ? end[l] - ring.mCapacity : 0);
+        // the time depth counts back from the newest line of the level
+        for (uint64_t index = end[l]; index > next[l]; index--) {
+            if (readRecord(l, index - 1, heads[l])) {
+                uint64_t newest = heads[l].mBootTimeNs / NS_PER_SEC;
+                oldest[l] = (newest > mConfigVec[l].mTimeDepthThres) ?
+                        newest - mConfigVec[l].mTimeDepthThres : 0;
+                break;
+            }
+        }
+        advance(l);
+    }
+
+    if (binary) {
+        out.put(LOG_BINARY_FILE_MAGIC, strlen(LOG_BINARY_FILE_MAGIC));
+        out.put(&mPid, sizeof(mPid));
+    } else {
+        out.putStr("dump log buffer, level[-1]\n");
+    }
+    for (;;) {
+        int l = -1;
+        for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+            if (valid[i] && (-1 == l || heads[i].mBootTimeNs < heads[l].mBootTimeNs)) {
+                l = i;
+            }
+        }
+        if (-1 == l) {
+            break;
+        }
+        const LogBufferRecord& line = heads[l];
+        if (binary) {
+            if (nullptr != line.mFormat) {
+                putString(line.mFormat);
+            }
+            if (nullptr != line.mTag) {
+                putString(line.mTag);
+            }
+            uint8_t type = LOG_BINARY_ENTRY_LINE;
+            uint32_t level = l;
+            uint64_t formatId = (uintptr_t)line.mFormat;
+            uint64_t tagId = (uintptr_t)line.mTag;
+            out.put(&type, sizeof(type));
+            out.put(&line.mBootTimeNs, sizeof(line.mBootTimeNs));
+            out.put(&line.mRealTimeNs, sizeof(line.mRealTimeNs));
+            out.put(&line.mTid, sizeof(line.mTid));
+            out.put(&level, sizeof(level));
+            out.put(&formatId, sizeof(formatId));
+            out.put(&tagId, sizeof(tagId));
+            out.put(&line.mLen, sizeof(line.mLen));
+            out.put(line.mText, line.mLen);
+        } else {
+            out.putStr("[");
+            out.putUint(line.mBootTimeNs / NS_PER_SEC);
+            out.putStr("] Level ");
+            out.putStr(levelNames[l]);
+            out.putStr(": ");
+            if (nullptr != line.mFormat) {
+                // formatting isn't async-signal-safe, so the arguments are
+                // left out; a binary dump keeps them for loc_log_decode
+                out.putStr("(undecoded) ");
+                out.putStr(line.mFormat);
+            } else {
+                out.put(line.mText, line.mLen);
+            }
+            out.putStr("\n");
+        }
+        advance(l);
+    }
+}
+
 void LogBuffer::flush() {
-    mLogList.flush();
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        mRings[i].mFlushIndex.store(mRings[i].mWriteIndex.load(memory_order_relaxed),
+                                    memory_order_relaxed);
+    }
+}
+
+// year, month and day of the days since 1970-01-01, computed without
+// localtime(), which isn't async-signal-safe
+static void civilFromDays(int64_t days, int& year, int& month, int& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
 }
 
 void LogBuffer::registerSignalHandler() {
@@ -143,24 +543,67 @@ void LogBuffer::registerSignalHandler() {
 }
 
 void LogBuffer::signalHandler(const int code, siginfo_t *const si, void *const sc) {
-    ALOGE("[Gnss Log buffer]Singal handler, signal ID: %d", code);
+    // Only async-signal-safe calls from here on, the heap, or a lock, may
+    // be in any state. Of threads crashing at once, only the first dumps.
+    static atomic_flag sDumping = ATOMIC_FLAG_INIT;
+    LogBuffer* instance = mInstance;
+    if (nullptr != instance && !sDumping.test_and_set()) {
+        //Dump the log buffer to file, named after the local time
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int64_t seconds = now.tv_sec + instance->mUtcOffset;
+        int64_t days = (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+        int64_t secondOfDay = seconds - days * 86400;
+        int year, month, day;
+        civilFromDays(days, year, month, day);
+        int fields[] = {year, month, day, (int)(secondOfDay / 3600),
+                        (int)(secondOfDay % 3600 / 60), (int)(secondOfDay % 60)};
 
-    //Dump the log buffer to adb logcat
-    mInstance->dumpToAdbLogcat();
-
-    //Dump the log buffer to file
-    time_t now = time(NULL);
-    struct tm *curr_time = localtime(&now);
-    char path[50];
-    snprintf(path, 50, LOG_BUFFER_FILE_PATH "gpslog_%d%d%d-%d%d%d.log",
-            (1900 + curr_time->tm_year), ( 1 + curr_time->tm_mon), curr_time->tm_mday,
-            curr_time->tm_hour, curr_time->tm_min, curr_time->tm_sec);
+        char name[64] = "gpslog_";
+        size_t len = strlen(name);
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            if (3 == i) {
+                name[len++] = '-';
+            }
+            char digits[12];
+            int n = 0;
+            unsigned value = (unsigned)fields[i];
+            do {
+                digits[n++] = '0' + value % 10;
+                value /= 10;
+            } while (value > 0);
+            while (n > 0) {
+                name[len++] = digits[--n];
+            }
+        }
+        //In binary mode, leave the formatting to loc_log_decode
+        bool binary = loc_logger.LOG_BUFFER_BINARY;
+        memcpy(name + len, binary ? ".bin" : ".log", 5);
 
-    mInstance->dumpToLogFile(path);
+        int fd = -1;
+        if (instance->mDumpDirFd >= 0) {
+            fd = openat(instance->mDumpDirFd, name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                        0644);
+        }
+        if (fd >= 0) {
+            instance->dumpToFd(fd, binary);
+            close(fd);
+        }
+        sDumping.clear();
+    }
 
     //Process won't be terminated if SIGUSR1 is recieved
     if (code != SIGUSR1) {
-        mOriSigAction[code].sa_sigaction(code, si, sc);
+        const struct sigaction& original = mOriSigAction[code];
+        if (original.sa_flags & SA_SIGINFO) {
+            original.sa_sigaction(code, si, sc);
+        } else if (SIG_IGN != original.sa_handler && SIG_DFL != original.sa_handler) {
+            original.sa_handler(code);
+        } else if (SIG_DFL == original.sa_handler) {
+            // put the default action back, and have it taken
+            sigaction(code, &original, nullptr);
+            raise(code);
+        }
     }
 }
 
@@ -30,8 +30,8 @@
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
-#include "SkipList.h"
 #include "log_util.h"
+#include "LogBinary.h"
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <string>
@@ -40,6 +40,10 @@
 #include <fstream>
 #include <time.h>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdarg.h>
 #include <signal.h>
 #include <thread>
 #include <functional>
@@ -50,6 +54,8 @@
 #define MAXIMUM_NUM_IN_LIST 50
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
+//text size of one buffered log line, longer lines are truncated
+#define LOG_BUFFER_RECORD_LEN LOGGING_BUFFER_MAX_LEN
 
 namespace loc_util {
 
@@ -57,10 +63,46 @@ class ConfigsInLevel{
 public:
     uint32_t mTimeDepthThres;
     uint32_t mMaxNumThres;
-    int mCurrentSize;
 
-    ConfigsInLevel(uint32_t time, int num, int size):
-        mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
+    ConfigsInLevel(uint32_t time, int num):
+        mTimeDepthThres(time), mMaxNumThres(num) {}
+};
+
+// one log line, written in place by LogBuffer::append() / appendBinary()
+struct LogBufferRecord {
+    // 2 * (index + 1) of the line held, odd while a writer is copying it in
+    std::atomic<uint64_t> mSeq;
+    uint64_t mBootTimeNs;
+    // format literal of a binary line, whose arguments mText then holds
+    // as packed by encodeLogArgs(); nullptr if mText is the line itself
+    const char* mFormat;
+    const char* mTag;
+    int32_t mTid;
+    uint64_t mRealTimeNs;
+    uint32_t mLen;
+    char mText[LOG_BUFFER_RECORD_LEN];
+
+    inline LogBufferRecord(): mSeq(0), mBootTimeNs(0), mFormat(nullptr), mTag(nullptr),
+            mTid(0), mRealTimeNs(0), mLen(0) {}
+};
+
+// Fixed capacity ring of the lines of one level. Writers claim a slot with
+// a fetch_add on mWriteIndex, so append() neither locks nor allocates; the
+// oldest lines are overwritten once the ring is full.
+class LogBufferRing {
+public:
+    std::unique_ptr<LogBufferRecord[]> mRecords;
+    uint32_t mCapacity;
+    std::atomic<uint64_t> mWriteIndex;
+    std::atomic<uint64_t> mFlushIndex;
+    // lines given up because every slot append() tried was busy
+    std::atomic<uint64_t> mDroppedCount;
+    // keeps mWriteIndex a cache line away from the next ring's, without
+    // over-aligning LogBuffer, which is created with plain new
+    char mPad[64];
+
+    inline LogBufferRing(): mCapacity(0), mWriteIndex(0), mFlushIndex(0),
+            mDroppedCount(0) {}
 };
 
 class LogBuffer {
@@ -68,23 +110,51 @@ private:
     static LogBuffer* mInstance;
     static struct sigaction mOriSigAction[NSIG];
     static struct sigaction mNewSigAction;
-    static mutex sLock;
+    static std::mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
-    vector<ConfigsInLevel> mConfigVec;
-    mutex mLock;
+    std::vector<ConfigsInLevel> mConfigVec;
+    LogBufferRing mRings[TOTAL_LOG_LEVELS];
+    int32_t mPid;
+    // LOG_BUFFER_FILE_PATH, opened ahead for the crash dump
+    int mDumpDirFd;
+    // local time minus UTC in seconds, as of the start of the process
+    long mUtcOffset;
 
-    const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
+    const std::vector<std::string> mLevelMap {"E", "W", "I", "D", "V"};
 
 public:
     static LogBuffer* getInstance();
-    void append(string& data, int level, uint64_t timestamp);
-    void dump(std::function<void(stringstream&)> log, int level = -1);
+    // data:       log line of len bytes, need not be NUL terminated
+    // bootTimeNs: CLOCK_BOOTTIME of the line in ns
+    void append(const char* data, size_t len, int level, uint64_t bootTimeNs);
+    // timestamp:  CLOCK_BOOTTIME of the line in seconds
+    void append(std::string& data, int level, uint64_t timestamp);
+    // Keeps the line as format plus its packed arguments, to be formatted
+    // only when dumped. format and tag must be literals, or else outlive
+    // the buffer.
+    // realTimeNs: CLOCK_REALTIME of the line in ns
+    // tid:        thread id of the caller
+    void appendBinary(int level, const char* tag, const char* format, va_list args,
+                      uint64_t bootTimeNs, uint64_t realTimeNs, int32_t tid);
+    void dump(std::function<void(std::stringstream&)> log, int level = -1);
     void dumpToAdbLogcat();
-    void dumpToLogFile(string filePath);
+    void dumpToLogFile(std::string filePath);
+    // Dumps the lines unformatted, with the format strings they use, for
+    // loc_log_decode to render offline.
+    void dumpBinaryToLogFile(std::string filePath);
     void flush();
 private:
+    struct Line;
+
     LogBuffer();
+    void readConfig(std::vector<ConfigsInLevel>& configs);
+    // takes in the time depths of an edited gps.conf
+    void reloadConfig();
+    LogBufferRecord* claim(int level, uint64_t& index);
+    void publish(LogBufferRecord* record, uint64_t index, uint64_t bootTimeNs);
+    bool readRecord(int level, uint64_t index, LogBufferRecord& out);
+    uint64_t collect(std::vector<Line>& lines, int level);
+    void dumpToFd(int fd, bool binary);
     void registerSignalHandler();
     static void signalHandler(const int code, siginfo_t *const si, void *const sc);
 
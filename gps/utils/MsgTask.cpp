@@ -30,43 +30,214 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <time.h>
+#include <pthread.h>
 #include <MsgTask.h>
 #include <msg_q.h>
 #include <log_util.h>
 #include <loc_log.h>
 #include <loc_pla.h>
 
+// LocMsg pool size classes go from 64 bytes to 32 KB, which covers the
+// largest report (GnssMeasurementsNotification); bigger requests go to
+// the heap directly. Each class caches up to LOC_MSG_POOL_CACHE_BYTES
+// worth of free blocks, but at least LOC_MSG_POOL_MIN_CACHED of them.
+#define LOC_MSG_POOL_MIN_SHIFT 6
+#define LOC_MSG_POOL_MAX_SHIFT 15
+#define LOC_MSG_POOL_CLASSES (LOC_MSG_POOL_MAX_SHIFT - LOC_MSG_POOL_MIN_SHIFT + 1)
+#define LOC_MSG_POOL_CACHE_BYTES (64 * 1024)
+#define LOC_MSG_POOL_MIN_CACHED 4
+
+// Every block is preceded by this header, which remembers the size class
+// while the block is in use and links the free list while it is cached.
+union LocMsgPoolHeader {
+    union LocMsgPoolHeader* next;
+    uint32_t sizeClass;
+    max_align_t align;
+};
+
+struct LocMsgPoolClass {
+    pthread_mutex_t lock;
+    LocMsgPoolHeader* freeList;
+    uint32_t freeCount;
+};
+
+static LocMsgPoolClass sLocMsgPool[LOC_MSG_POOL_CLASSES] = {
+#define LOC_MSG_POOL_CLASS_INIT { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }
+    LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT,
+    LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT,
+    LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT, LOC_MSG_POOL_CLASS_INIT,
+    LOC_MSG_POOL_CLASS_INIT
+#undef LOC_MSG_POOL_CLASS_INIT
+};
+static_assert(LOC_MSG_POOL_CLASSES == 10, "update sLocMsgPool initializer");
+
+static std::atomic<uint64_t> sLocMsgAllocCount(0);
+static std::atomic<uint64_t> sLocMsgPoolHitCount(0);
+static std::atomic<uint64_t> sLocMsgHeapAllocCount(0);
+static std::atomic<uint64_t> sLocMsgHeapFreeCount(0);
+
+static inline uint32_t locMsgPoolClass(size_t size) {
+    uint32_t sizeClass = 0;
+    while (sizeClass < LOC_MSG_POOL_CLASSES &&
+           ((size_t)1 << (sizeClass + LOC_MSG_POOL_MIN_SHIFT)) < size) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+static inline uint32_t locMsgPoolMaxCached(uint32_t sizeClass) {
+    uint32_t count = LOC_MSG_POOL_CACHE_BYTES >> (sizeClass + LOC_MSG_POOL_MIN_SHIFT);
+    return (count < LOC_MSG_POOL_MIN_CACHED) ? LOC_MSG_POOL_MIN_CACHED : count;
+}
+
+void* LocMsg::poolAlloc(size_t size) {
+    uint32_t sizeClass = locMsgPoolClass(size);
+    LocMsgPoolHeader* block = NULL;
+
+    sLocMsgAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (sizeClass < LOC_MSG_POOL_CLASSES) {
+        LocMsgPoolClass& pool = sLocMsgPool[sizeClass];
+        pthread_mutex_lock(&pool.lock);
+        block = pool.freeList;
+        if (NULL != block) {
+            pool.freeList = block->next;
+            pool.freeCount--;
+        }
+        pthread_mutex_unlock(&pool.lock);
+        size = (size_t)1 << (sizeClass + LOC_MSG_POOL_MIN_SHIFT);
+    }
+
+    if (NULL != block) {
+        sLocMsgPoolHitCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        size += sizeof(LocMsgPoolHeader);
+        block = (LocMsgPoolHeader*)::operator new(size);
+        sLocMsgHeapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    block->sizeClass = sizeClass;
+    return block + 1;
+}
+
+void LocMsg::poolFree(void* ptr) {
+    if (NULL == ptr) {
+        return;
+    }
+
+    LocMsgPoolHeader* block = (LocMsgPoolHeader*)ptr - 1;
+    uint32_t sizeClass = block->sizeClass;
+    if (sizeClass < LOC_MSG_POOL_CLASSES) {
+        LocMsgPoolClass& pool = sLocMsgPool[sizeClass];
+        pthread_mutex_lock(&pool.lock);
+        if (pool.freeCount < locMsgPoolMaxCached(sizeClass)) {
+            block->next = pool.freeList;
+            pool.freeList = block;
+            pool.freeCount++;
+            block = NULL;
+        }
+        pthread_mutex_unlock(&pool.lock);
+    }
+
+    if (NULL != block) {
+        ::operator delete(block);
+        sLocMsgHeapFreeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LocMsgAllocStats LocMsg::getAllocStats() {
+    LocMsgAllocStats stats = {};
+    stats.allocCount = sLocMsgAllocCount.load(std::memory_order_relaxed);
+    stats.poolHitCount = sLocMsgPoolHitCount.load(std::memory_order_relaxed);
+    stats.heapAllocCount = sLocMsgHeapAllocCount.load(std::memory_order_relaxed);
+    stats.heapFreeCount = sLocMsgHeapFreeCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
 static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
+// upper bound of setBatchDrain(), sizes the on stack batch array
+#define MSG_TASK_MAX_BATCH_SIZE 64
+// ring slots of the high priority lane
+#define MSG_TASK_HIGH_LANE_Q_SIZE 64
+// max high priority msgs served in a row ahead of one normal msg
+#define MSG_TASK_HIGH_LANE_BURST 8
+
+// Queued in the normal lane for every high priority msg, so that the
+// consumer wakes up and serves the high lane. It is never deleted.
+struct LocMsgHighLaneMarker : public LocMsg {
+    inline virtual void proc() const {}
+};
+static LocMsgHighLaneMarker sHighLaneMarker;
+
+struct MsgTaskState {
+    const void* mQ;
+    const void* mHighQ;
+    std::atomic<int32_t> mHighLanePending;
+    std::atomic<uint64_t> mHighLaneCount;
+    std::atomic<uint32_t> mMaxBatchSize;
+    std::atomic<uint64_t> mBatchCount;
+    std::atomic<uint64_t> mBatchMsgCount;
+    std::atomic<uint32_t> mBatchSizeMax;
+    std::atomic<uint64_t> mBatchTimeTotalNs;
+    std::atomic<uint64_t> mBatchTimeMaxNs;
+    inline MsgTaskState(size_t ringCapacity) :
+        mQ((0 == ringCapacity) ? msg_q_init2() : msg_q_init2_ring(ringCapacity)),
+        mHighQ(msg_q_init2_ring(MSG_TASK_HIGH_LANE_Q_SIZE)),
+        mHighLanePending(0), mHighLaneCount(0),
+        mMaxBatchSize(1), mBatchCount(0), mBatchMsgCount(0), mBatchSizeMax(0),
+        mBatchTimeTotalNs(0), mBatchTimeMaxNs(0) {}
+};
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+template <typename T>
+static inline void atomicMax(std::atomic<T>& target, T value) {
+    T cur = target.load(std::memory_order_relaxed);
+    while (value > cur &&
+           !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+
 MsgTask::MsgTask(LocThread::tCreate tCreator,
-                 const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
+                 const char* threadName, bool joinable, size_t ringCapacity) :
+    mState(new MsgTaskState(ringCapacity)), mThread(new LocThread()) {
     if (!mThread->start(tCreator, threadName, this, joinable)) {
         delete mThread;
         mThread = NULL;
     }
 }
 
+MsgTask::MsgTask(const char* threadName, bool joinable, size_t ringCapacity) :
+    MsgTask((LocThread::tCreate)NULL, threadName, joinable, ringCapacity) {
+}
+
+MsgTask::MsgTask(LocThread::tCreate tCreator, const char* threadName, bool joinable) :
+    MsgTask(tCreator, threadName, joinable, 0) {
+}
+
 MsgTask::MsgTask(const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
-    if (!mThread->start(threadName, this, joinable)) {
-        delete mThread;
-        mThread = NULL;
-    }
+    MsgTask((LocThread::tCreate)NULL, threadName, joinable, 0) {
 }
 
 MsgTask::~MsgTask() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    msg_q_flush((void*)mState->mQ);
+    msg_q_destroy((void**)&mState->mQ);
+    msg_q_flush((void*)mState->mHighQ);
+    msg_q_destroy((void**)&mState->mHighQ);
+    delete mState;
 }
 
 void MsgTask::destroy() {
     LocThread* thread = mThread;
-    msg_q_unblock((void*)mQ);
+    // once unblocked, the thread may exit and delete this obj right away
+    mThread = NULL;
+    msg_q_unblock((void*)mState->mQ);
     if (thread) {
-        mThread = NULL;
         delete thread;
     } else {
         delete this;
@@ -74,33 +245,125 @@ void MsgTask::destroy() {
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
+    sendMsg(msg, LOC_MSG_PRIORITY_NORMAL);
+}
+
+void MsgTask::sendMsg(const LocMsg* msg, LocMsgPriority priority) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        if (LOC_MSG_PRIORITY_HIGH == priority && NULL != mState->mHighQ) {
+            if (eMSG_Q_SUCCESS ==
+                    msg_q_snd((void*)mState->mHighQ, (void*)msg, LocMsgDestroy)) {
+                mState->mHighLanePending.fetch_add(1, std::memory_order_release);
+                msg_q_snd((void*)mState->mQ, (void*)&sHighLaneMarker, NULL);
+            }
+        } else {
+            msg_q_snd((void*)mState->mQ, (void*)msg, LocMsgDestroy);
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
     }
 }
 
+void MsgTask::setBatchDrain(uint32_t maxBatchSize) {
+    if (0 == maxBatchSize) {
+        maxBatchSize = 1;
+    } else if (maxBatchSize > MSG_TASK_MAX_BATCH_SIZE) {
+        maxBatchSize = MSG_TASK_MAX_BATCH_SIZE;
+    }
+    mState->mMaxBatchSize = maxBatchSize;
+}
+
+MsgTaskStats MsgTask::getStats() const {
+    MsgTaskStats stats = {};
+    stats.batchCount = mState->mBatchCount.load(std::memory_order_relaxed);
+    stats.msgCount = mState->mBatchMsgCount.load(std::memory_order_relaxed);
+    stats.maxBatchSize = mState->mBatchSizeMax.load(std::memory_order_relaxed);
+    stats.totalBatchTimeNs = mState->mBatchTimeTotalNs.load(std::memory_order_relaxed);
+    stats.maxBatchTimeNs = mState->mBatchTimeMaxNs.load(std::memory_order_relaxed);
+    stats.highLaneCount = mState->mHighLaneCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MsgTask::runHighLane() {
+    LocMsg* msg;
+    for (uint32_t i = 0; i < MSG_TASK_HIGH_LANE_BURST &&
+            mState->mHighLanePending.load(std::memory_order_acquire) > 0; i++) {
+        if (eMSG_Q_SUCCESS != msg_q_rmv((void*)mState->mHighQ, (void**)&msg)) {
+            break;
+        }
+        mState->mHighLanePending.fetch_sub(1, std::memory_order_relaxed);
+        mState->mHighLaneCount.fetch_add(1, std::memory_order_relaxed);
+        msg->log();
+        msg->proc();
+        delete msg;
+    }
+}
+
+// serves the high lane first, then msg taken from the normal lane
+inline void MsgTask::procMsg(LocMsg* msg) {
+    runHighLane();
+    if (&sHighLaneMarker != msg) {
+        msg->log();
+        // there is where each individual msg handling is invoked
+        msg->proc();
+    }
+}
+
 void MsgTask::prerun() {
     // make sure we do not run in background scheduling group
      set_sched_policy(gettid(), SP_FOREGROUND);
 }
 
+bool MsgTask::runBatch(uint32_t maxBatchSize) {
+    LocMsg* msgs[MSG_TASK_MAX_BATCH_SIZE];
+    size_t count = 0;
+    msq_q_err_type result = msg_q_rcv_batch((void*)mState->mQ, (void**)msgs, maxBatchSize, &count);
+    if (eMSG_Q_SUCCESS != result) {
+        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
+                 loc_get_msg_q_status(result));
+        return false;
+    }
+
+    uint64_t start = monotonicNs();
+    for (size_t i = 0; i < count; i++) {
+        procMsg(msgs[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (&sHighLaneMarker != msgs[i]) {
+            delete msgs[i];
+        }
+    }
+    uint64_t elapsed = monotonicNs() - start;
+
+    mState->mBatchCount.fetch_add(1, std::memory_order_relaxed);
+    mState->mBatchMsgCount.fetch_add(count, std::memory_order_relaxed);
+    mState->mBatchTimeTotalNs.fetch_add(elapsed, std::memory_order_relaxed);
+    atomicMax(mState->mBatchSizeMax, (uint32_t)count);
+    atomicMax(mState->mBatchTimeMaxNs, elapsed);
+
+    return true;
+}
+
 bool MsgTask::run() {
+    uint32_t maxBatchSize = mState->mMaxBatchSize.load(std::memory_order_relaxed);
+    if (maxBatchSize > 1) {
+        return runBatch(maxBatchSize);
+    }
+
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
+    msq_q_err_type result = msg_q_rcv((void*)mState->mQ, (void **)&msg);
     if (eMSG_Q_SUCCESS != result) {
         LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
                  loc_get_msg_q_status(result));
         return false;
     }
 
-    msg->log();
-    // there is where each individual msg handling is invoked
-    msg->proc();
+    procMsg(msg);
 
-    delete msg;
+    if (&sHighLaneMarker != msg) {
+        delete msg;
+    }
 
     return true;
 }
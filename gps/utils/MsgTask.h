@@ -29,27 +29,99 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
+#include <atomic>
 #include <LocThread.h>
 
+// Lane a LocMsg is queued in by MsgTask::sendMsg(). HIGH msgs (position,
+// SV and NI reports) are served ahead of the NORMAL lane, which is the
+// default and carries everything else. Each lane is FIFO on its own.
+// The lane is chosen by the sender rather than stored in LocMsg, whose
+// layout prebuilt libs depend on.
+enum LocMsgPriority {
+    LOC_MSG_PRIORITY_NORMAL = 0,
+    LOC_MSG_PRIORITY_HIGH
+};
+
+// Counters of the LocMsg memory pool, see LocMsg::getAllocStats()
+struct LocMsgAllocStats {
+    uint64_t allocCount;     // poolAlloc() allocations, LocPooledMsg objs included
+    uint64_t poolHitCount;   // ... of which were served from the pool
+    uint64_t heapAllocCount; // ... of which had to go to the heap
+    uint64_t heapFreeCount;  // blocks released back to the heap
+};
+
 struct LocMsg {
     inline LocMsg() {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+
+    // Power of 2 size class free lists that recycle freed blocks, so that
+    // steady state reporting does not hit the heap. Msgs use them for their
+    // variable length payloads, and LocPooledMsg for the msgs themselves.
+    static void* poolAlloc(size_t size);
+    static void poolFree(void* ptr);
+    static LocMsgAllocStats getAllocStats();
 };
 
+// Mix-in that takes the objs of a LocMsg leaf class from the LocMsg pool.
+// Only for msg classes local to a .cpp of this tree: prebuilt libs new and
+// delete the msgs they know of with the global operators, so the pool
+// can't be put on LocMsg or on any msg class in a header.
+struct LocPooledMsg {
+    inline static void* operator new(size_t size) { return LocMsg::poolAlloc(size); }
+    inline static void operator delete(void* ptr) { LocMsg::poolFree(ptr); }
+};
+
+// Counters of the batch drain mode, see MsgTask::setBatchDrain(), and
+// of the high priority lane
+struct MsgTaskStats {
+    uint64_t batchCount;       // number of drained batches
+    uint64_t msgCount;         // number of msgs processed in those batches
+    uint32_t maxBatchSize;     // largest batch seen
+    uint64_t totalBatchTimeNs; // time spent processing all batches
+    uint64_t maxBatchTimeNs;   // longest single batch
+    uint64_t highLaneCount;    // number of LOC_MSG_PRIORITY_HIGH msgs processed
+};
+
+// queue and counters of a MsgTask, see MsgTask.cpp
+struct MsgTaskState;
+
 class MsgTask : public LocRunnable {
-    const void* mQ;
+    // MsgTask objs are also allocated by prebuilt libs, so the obj keeps its
+    // original two pointers; anything added lives in MsgTaskState.
+    MsgTaskState* mState;
     LocThread* mThread;
     friend class LocThreadDelegate;
+    bool runBatch(uint32_t maxBatchSize);
+    void runHighLane();
+    void procMsg(LocMsg* msg);
 protected:
     virtual ~MsgTask();
 public:
     MsgTask(LocThread::tCreate tCreator, const char* threadName = NULL, bool joinable = true);
     MsgTask(const char* threadName = NULL, bool joinable = true);
+    // ringCapacity of 0 backs the task with the linked list msg_q, as the
+    // above do; any other value selects the lock-free MPSC ring msg_q of
+    // (at least) that many slots, which is the better choice for high
+    // traffic tasks.
+    MsgTask(LocThread::tCreate tCreator, const char* threadName, bool joinable,
+            size_t ringCapacity);
+    MsgTask(const char* threadName, bool joinable, size_t ringCapacity);
     // this obj will be deleted once thread is deleted
     void destroy();
+    // same as sendMsg(msg, LOC_MSG_PRIORITY_NORMAL)
     void sendMsg(const LocMsg* msg) const;
+    // LOC_MSG_PRIORITY_HIGH msgs overtake queued NORMAL msgs; to bound
+    // starvation, at most a burst of MSG_TASK_HIGH_LANE_BURST of them is
+    // served before the next NORMAL msg.
+    void sendMsg(const LocMsg* msg, LocMsgPriority priority) const;
+    // maxBatchSize > 1 makes run() take everything pending (up to
+    // maxBatchSize msgs) off the queue in one go, proc() them in order,
+    // and only then delete them. 1, the default, handles one msg per run().
+    void setBatchDrain(uint32_t maxBatchSize);
+    MsgTaskStats getStats() const;
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
     // until thread is stopped.
@@ -39,6 +39,11 @@
 #include <time.h>
 #include <grp.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <loc_target.h>
@@ -60,6 +65,8 @@ static uint32_t TIMESTAMP = 0;
 static uint32_t DATUM_TYPE = 0;
 static bool sVendorEnhanced = true;
 static uint32_t sLogBufferEnabled = 0;
+static uint32_t sLogBufferBinary = 0;
+static uint32_t sLogBufferLogcatLevel = 5;
 
 /* Parameter spec table */
 static const loc_param_s_type loc_param_table[] =
@@ -68,6 +75,8 @@ static const loc_param_s_type loc_param_table[] =
     {"TIMESTAMP",               &TIMESTAMP,          NULL, 'n'},
     {"DATUM_TYPE",              &DATUM_TYPE,         NULL, 'n'},
     {"LOG_BUFFER_ENABLED",      &sLogBufferEnabled,  NULL, 'n'},
+    {"LOG_BUFFER_BINARY",       &sLogBufferBinary,   NULL, 'n'},
+    {"LOG_BUFFER_LOGCAT_LEVEL", &sLogBufferLogcatLevel, NULL, 'n'},
 };
 static const int loc_param_num = sizeof(loc_param_table) / sizeof(loc_param_s_type);
 
@@ -207,6 +216,63 @@ int loc_set_config_entry(const loc_param_s_type* config_entry, loc_param_v_type*
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_item
+
+DESCRIPTION
+   Splits a line of configuration item into its parameter name and value,
+   and parses the value as a number too.
+
+PARAMETERS:
+   input_buf : buffer contanis config item, tokenized in place
+   config_value: name and values parsed, pointing into input_buf
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if the line is a "name = value" item
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static bool loc_parse_conf_item(char* input_buf, loc_param_v_type* config_value)
+{
+    char *lasts;
+    memset(config_value, 0, sizeof(*config_value));
+
+    /* Separate variable and value */
+    config_value->param_name = strtok_r(input_buf, "=", &lasts);
+    /* skip lines that do not contain "=" */
+    if (NULL == config_value->param_name) {
+        return false;
+    }
+    config_value->param_str_value = strtok_r(NULL, "\0", &lasts);
+    /* skip lines that do not contain two operands */
+    if (NULL == config_value->param_str_value) {
+        return false;
+    }
+
+    /* Trim leading and trailing spaces */
+    loc_util_trim_space(config_value->param_name);
+    loc_util_trim_space(config_value->param_str_value);
+
+    /* Parse numerical value */
+    if ((strlen(config_value->param_str_value) >=3) &&
+        (config_value->param_str_value[0] == '0') &&
+        (tolower(config_value->param_str_value[1]) == 'x'))
+    {
+        /* hex */
+        config_value->param_int_value = (int) strtol(&config_value->param_str_value[2],
+                                                     (char**) NULL, 16);
+    }
+    else {
+        config_value->param_double_value = (double) atof(config_value->param_str_value); /* float */
+        config_value->param_int_value = atoi(config_value->param_str_value); /* dec */
+    }
+    return true;
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -233,44 +299,13 @@ int loc_fill_conf_item(char* input_buf,
                        const loc_param_s_type* config_table, uint32_t table_length)
 {
     int ret = 0;
+    loc_param_v_type config_value;
 
-    if (input_buf && config_table) {
-        char *lasts;
-        loc_param_v_type config_value;
-        memset(&config_value, 0, sizeof(config_value));
-
-        /* Separate variable and value */
-        config_value.param_name = strtok_r(input_buf, "=", &lasts);
-        /* skip lines that do not contain "=" */
-        if (config_value.param_name) {
-            config_value.param_str_value = strtok_r(NULL, "\0", &lasts);
-
-            /* skip lines that do not contain two operands */
-            if (config_value.param_str_value) {
-                /* Trim leading and trailing spaces */
-                loc_util_trim_space(config_value.param_name);
-                loc_util_trim_space(config_value.param_str_value);
-
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
-                }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
-                }
-
-                for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-                {
-                    if(!loc_set_config_entry(&config_table[i], &config_value)) {
-                        ret += 1;
-                    }
-                }
+    if (input_buf && config_table && loc_parse_conf_item(input_buf, &config_value)) {
+        for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+        {
+            if(!loc_set_config_entry(&config_table[i], &config_value)) {
+                ret += 1;
             }
         }
     }
@@ -404,13 +439,209 @@ int loc_update_conf(const char* conf_data, int32_t length,
     return ret;
 }
 
+/*=============================================================================
+ *
+ *   Cache of the parsed configuration files
+ *
+ *============================================================================*/
+/* value of a parameter, as loc_parse_conf_item() parsed it */
+struct LocConfValue {
+    std::string strValue;
+    int intValue;
+    double doubleValue;
+};
+
+/* a configuration file parsed once, keyed by parameter name; the stat
+   fields tell whether the file changed since */
+struct LocConfFile {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    std::unordered_map<std::string, LocConfValue> values;
+};
+
+static std::mutex sConfCacheLock;
+static std::unordered_map<std::string, LocConfFile> sConfCache;
+static loc_conf_stats_s_type sConfStats;
+
+static inline bool loc_conf_file_same(const LocConfFile& file, const struct stat& st)
+{
+    return file.dev == st.st_dev && file.ino == st.st_ino && file.size == st.st_size &&
+            file.mtime.tv_sec == st.st_mtim.tv_sec && file.mtime.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+/*===========================================================================
+FUNCTION loc_get_conf_file
+
+DESCRIPTION
+   Returns the cached parameters of a configuration file, parsing the file
+   if it is not cached yet, or changed since. sConfCacheLock must be held.
+   Nothing is logged here, as logging may read gps.conf in turn.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the cached file; NULL if the file can't be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static LocConfFile* loc_get_conf_file(const char* conf_file_name)
+{
+    struct stat st;
+    auto it = sConfCache.find(conf_file_name);
+    if (0 != stat(conf_file_name, &st)) {
+        if (it != sConfCache.end()) {
+            sConfCache.erase(it);
+        }
+        return NULL;
+    }
+    if (it != sConfCache.end() && loc_conf_file_same(it->second, st)) {
+        sConfStats.cache_hits++;
+        return &it->second;
+    }
+
+    FILE* conf_fp = fopen(conf_file_name, "r");
+    if (NULL == conf_fp) {
+        return NULL;
+    }
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sConfStats.file_opens++;
+
+    LocConfFile& file = sConfCache[conf_file_name];
+    file.values.clear();
+    if (0 == fstat(fileno(conf_fp), &st)) {
+        file.dev = st.st_dev;
+        file.ino = st.st_ino;
+        file.size = st.st_size;
+        file.mtime = st.st_mtim;
+    }
+    char input_buf[LOC_MAX_PARAM_LINE];
+    loc_param_v_type config_value;
+    while (fgets(input_buf, LOC_MAX_PARAM_LINE, conf_fp)) {
+        if (loc_parse_conf_item(input_buf, &config_value) &&
+                '#' != config_value.param_name[0]) {
+            /* a later line of the same parameter overrides an earlier one */
+            LocConfValue& value = file.values[config_value.param_name];
+            value.strValue = config_value.param_str_value;
+            value.intValue = config_value.param_int_value;
+            value.doubleValue = config_value.param_double_value;
+        }
+    }
+    fclose(conf_fp);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sConfStats.parse_time_ns += (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+            end.tv_nsec - start.tv_nsec;
+    return &file;
+}
+
+/*===========================================================================
+FUNCTION loc_bind_conf
+
+DESCRIPTION
+   Sets the entries of the passed in configuration tables from the cached
+   configuration file, with a hash lookup per entry.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   config_tables: tables definition of strings to places to store information
+   table_lengths: lengths of the configuration tables
+   table_count: number of the configuration tables
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   false if the file can't be read, in which case no entry is touched
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static bool loc_bind_conf(const char* conf_file_name,
+                          const loc_param_s_type* const config_tables[],
+                          const uint32_t table_lengths[], uint32_t table_count)
+{
+    struct Match {
+        const loc_param_s_type* entry;
+        LocConfValue value;
+    };
+    std::vector<Match> matches;
+    {
+        std::lock_guard<std::mutex> guard(sConfCacheLock);
+        LocConfFile* file = loc_get_conf_file(conf_file_name);
+        if (NULL == file) {
+            return false;
+        }
+        for (uint32_t t = 0; t < table_count; t++) {
+            for (uint32_t i = 0; NULL != config_tables[t] && i < table_lengths[t]; i++) {
+                auto it = file->values.find(config_tables[t][i].param_name);
+                if (it != file->values.end()) {
+                    matches.push_back({&config_tables[t][i], it->second});
+                }
+            }
+        }
+    }
+
+    /* the entries are set, and logged, out of the lock */
+    for (uint32_t t = 0; t < table_count; t++) {
+        for (uint32_t i = 0; NULL != config_tables[t] && i < table_lengths[t]; i++) {
+            if (NULL != config_tables[t][i].param_set) {
+                *(config_tables[t][i].param_set) = 0;
+            }
+        }
+    }
+    for (Match& match : matches) {
+        loc_param_v_type config_value;
+        config_value.param_name = (char*)match.entry->param_name;
+        config_value.param_str_value = (char*)match.value.strValue.c_str();
+        config_value.param_int_value = match.value.intValue;
+        config_value.param_double_value = match.value.doubleValue;
+        loc_set_config_entry(match.entry, &config_value);
+    }
+    return true;
+}
+
+/*===========================================================================
+FUNCTION loc_get_conf_stats
+
+DESCRIPTION
+   Reads the counters of the configuration file cache.
+
+PARAMETERS:
+   stats: where to copy the counters to
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_get_conf_stats(loc_conf_stats_s_type* stats)
+{
+    if (NULL != stats) {
+        std::lock_guard<std::mutex> guard(sConfCacheLock);
+        *stats = sConfStats;
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf
 
 DESCRIPTION
    Reads the specified configuration file and sets defined values based on
    the passed in configuration table. This table maps strings to values to
-   set along with the type of each of these values.
+   set along with the type of each of these values. The file is parsed
+   once, and read from the cache from then on, until it changes.
 
 PARAMETERS:
    conf_file_name: configuration file to read
@@ -429,21 +660,18 @@ SIDE EFFECTS
 void loc_read_conf(const char* conf_file_name, const loc_param_s_type* config_table,
                    uint32_t table_length)
 {
-    FILE *conf_fp = NULL;
+    const loc_param_s_type* config_tables[] = {config_table, loc_param_table};
+    const uint32_t table_lengths[] = {config_table ? table_length : 0,
+                                      (uint32_t)loc_param_num};
 
     log_buffer_init(false);
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
-    {
+    if (loc_bind_conf(conf_file_name, config_tables, table_lengths,
+                      sizeof(config_tables) / sizeof(config_tables[0]))) {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
-        if(table_length && config_table) {
-            loc_read_conf_r(conf_fp, config_table, table_length);
-            rewind(conf_fp);
-        }
-        loc_read_conf_r(conf_fp, loc_param_table, loc_param_num);
-        fclose(conf_fp);
     }
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
+    log_buffer_mode_init(sLogBufferBinary, sLogBufferLogcatLevel);
     log_buffer_init(sLogBufferEnabled);
 }
 
@@ -730,6 +958,10 @@ int loc_read_process_conf(const char* conf_file_name, uint32_t * process_count_p
 
     LOC_LOGD("%s:%d]: loc_service_mask: %x\n", __func__, __LINE__, loc_service_mask);
 
+    {
+        std::lock_guard<std::mutex> guard(sConfCacheLock);
+        sConfStats.file_opens++;
+    }
     if((conf_fp = fopen(conf_file_name, "r")) == NULL) {
         LOC_LOGE("%s:%d]: Error opening %s %s\n", __func__,
                  __LINE__, conf_file_name, strerror(errno));
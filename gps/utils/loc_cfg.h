@@ -80,6 +80,13 @@ typedef struct
                               'f' for double */
 } loc_param_s_type;
 
+/* counters of the configuration files read, see loc_get_conf_stats() */
+typedef struct {
+    uint32_t file_opens;     /* configuration files opened and parsed */
+    uint32_t cache_hits;     /* loc_read_conf() calls served from the cache */
+    uint64_t parse_time_ns;  /* time spent parsing the files opened */
+} loc_conf_stats_s_type;
+
 typedef enum {
     ENABLED,
     RUNNING,
@@ -122,6 +129,7 @@ int loc_read_conf_r(FILE *conf_fp, const loc_param_s_type* config_table,
                     uint32_t table_length);
 int loc_update_conf(const char* conf_data, int32_t length,
                     const loc_param_s_type* config_table, uint32_t table_length);
+void loc_get_conf_stats(loc_conf_stats_s_type* stats);
 
 // Below are the location conf file paths
 extern const char LOC_PATH_GPS_CONF[];
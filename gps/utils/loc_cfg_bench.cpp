@@ -0,0 +1,221 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replays the conf file reads of the location HAL startup and times them,
+// through the loc_read_conf() cache and through the uncached line by line
+// parser of loc_read_conf_r():
+//     loc_cfg_bench [<gps.conf> [<sap.conf> [<flp.conf>]]]
+// The tables are the ones ContextBase, LogBuffer, GnssAdapter,
+// BatchingAdapter and LocationAPIClientBase read. The values bound both
+// ways are compared byte by byte. Reported are the time of each replay and
+// the files parsed into the cache and the cache hits of
+// loc_get_conf_stats().
+
+#include "loc_cfg.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+using namespace std;
+
+#define REPLAYS 100
+
+struct BenchParam {
+    const char* name;
+    char type;
+};
+
+// ContextBase
+static const BenchParam sGpsParams[] = {
+    {"GPS_LOCK", 'n'}, {"SUPL_VER", 'n'}, {"LPP_PROFILE", 'n'},
+    {"A_GLONASS_POS_PROTOCOL_SELECT", 'n'}, {"LPPE_CP_TECHNOLOGY", 'n'},
+    {"LPPE_UP_TECHNOLOGY", 'n'}, {"AGPS_CERT_WRITABLE_MASK", 'n'}, {"SUPL_MODE", 'n'},
+    {"SUPL_ES", 'n'}, {"INTERMEDIATE_POS", 'n'}, {"ACCURACY_THRES", 'n'},
+    {"NMEA_PROVIDER", 'n'}, {"CAPABILITIES", 'n'}, {"XTRA_VERSION_CHECK", 'n'},
+    {"XTRA_SERVER_1", 's'}, {"XTRA_SERVER_2", 's'}, {"XTRA_SERVER_3", 's'},
+    {"USE_EMERGENCY_PDN_FOR_EMERGENCY_SUPL", 'n'}, {"AGPS_CONFIG_INJECT", 'n'},
+    {"EXTERNAL_DR_ENABLED", 'n'}, {"SUPL_HOST", 's'}, {"SUPL_PORT", 'n'},
+    {"MODEM_TYPE", 'n'}, {"MO_SUPL_HOST", 's'}, {"MO_SUPL_PORT", 'n'},
+    {"CONSTRAINED_TIME_UNCERTAINTY_ENABLED", 'n'},
+    {"CONSTRAINED_TIME_UNCERTAINTY_THRESHOLD", 'f'},
+    {"CONSTRAINED_TIME_UNCERTAINTY_ENERGY_BUDGET", 'n'},
+    {"POSITION_ASSISTED_CLOCK_ESTIMATOR_ENABLED", 'n'}, {"PROXY_APP_PACKAGE_NAME", 's'},
+    {"CP_MTLR_ES", 'n'}, {"GNSS_DEPLOYMENT", 'n'},
+    {"CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED", 'n'}, {"NI_SUPL_DENY_ON_NFW_LOCKED", 'n'},
+    {"GEOFENCE_OVERFLOW_ENABLED", 'n'},
+};
+
+// ContextBase
+static const BenchParam sSapParams[] = {
+    {"GYRO_BIAS_RANDOM_WALK", 'f'}, {"ACCEL_RANDOM_WALK_SPECTRAL_DENSITY", 'f'},
+    {"ANGLE_RANDOM_WALK_SPECTRAL_DENSITY", 'f'}, {"RATE_RANDOM_WALK_SPECTRAL_DENSITY", 'f'},
+    {"VELOCITY_RANDOM_WALK_SPECTRAL_DENSITY", 'f'}, {"SENSOR_ACCEL_BATCHES_PER_SEC", 'n'},
+    {"SENSOR_ACCEL_SAMPLES_PER_BATCH", 'n'}, {"SENSOR_GYRO_BATCHES_PER_SEC", 'n'},
+    {"SENSOR_GYRO_SAMPLES_PER_BATCH", 'n'}, {"SENSOR_ACCEL_BATCHES_PER_SEC_HIGH", 'n'},
+    {"SENSOR_ACCEL_SAMPLES_PER_BATCH_HIGH", 'n'}, {"SENSOR_GYRO_BATCHES_PER_SEC_HIGH", 'n'},
+    {"SENSOR_GYRO_SAMPLES_PER_BATCH_HIGH", 'n'}, {"SENSOR_CONTROL_MODE", 'n'},
+    {"SENSOR_ALGORITHM_CONFIG_MASK", 'n'},
+};
+
+// LogBuffer
+static const BenchParam sLogParams[] = {
+    {"E_LEVEL_TIME_DEPTH", 'n'}, {"E_LEVEL_MAX_CAPACITY", 'n'},
+    {"W_LEVEL_TIME_DEPTH", 'n'}, {"W_LEVEL_MAX_CAPACITY", 'n'},
+    {"I_LEVEL_TIME_DEPTH", 'n'}, {"I_LEVEL_MAX_CAPACITY", 'n'},
+    {"D_LEVEL_TIME_DEPTH", 'n'}, {"D_LEVEL_MAX_CAPACITY", 'n'},
+    {"V_LEVEL_TIME_DEPTH", 'n'}, {"V_LEVEL_MAX_CAPACITY", 'n'},
+};
+
+// GnssAdapter
+static const BenchParam sFlpParams[] = {
+    {"ALLOW_NETWORK_FIXES", 'n'},
+};
+
+// BatchingAdapter
+static const BenchParam sBatchingParams[] = {
+    {"BATCH_SIZE", 'n'}, {"OUTDOOR_TRIP_BATCH_SIZE", 'n'}, {"BATCH_SESSION_TIMEOUT", 'n'},
+    {"ACCURACY", 'n'},
+};
+
+// LocationAPIClientBase
+static const BenchParam sApiParams[] = {
+    {"CAPABILITIES", 'n'},
+};
+
+// one table of one file, bound to its own storage
+struct BenchTable {
+    const char* file;
+    vector<loc_param_s_type> params;
+    vector<char> values;
+    vector<uint8_t> set;
+    BenchTable(const char* file, const BenchParam* benchParams, size_t count) :
+            file(file), params(count), values(count * LOC_MAX_PARAM_STRING), set(count) {
+        for (size_t i = 0; i < count; i++) {
+            params[i] = {benchParams[i].name, &values[i * LOC_MAX_PARAM_STRING], &set[i],
+                         benchParams[i].type};
+        }
+    }
+};
+
+// the startup reads, in order
+static vector<BenchTable> startupTables(const char* gpsConf, const char* sapConf,
+                                        const char* flpConf) {
+    vector<BenchTable> tables;
+    tables.emplace_back(gpsConf, sGpsParams, sizeof(sGpsParams) / sizeof(sGpsParams[0]));
+    tables.emplace_back(sapConf, sSapParams, sizeof(sSapParams) / sizeof(sSapParams[0]));
+    tables.emplace_back(gpsConf, sLogParams, sizeof(sLogParams) / sizeof(sLogParams[0]));
+    tables.emplace_back(flpConf, sFlpParams, sizeof(sFlpParams) / sizeof(sFlpParams[0]));
+    tables.emplace_back(flpConf, sBatchingParams,
+                        sizeof(sBatchingParams) / sizeof(sBatchingParams[0]));
+    tables.emplace_back(flpConf, sApiParams, sizeof(sApiParams) / sizeof(sApiParams[0]));
+    return tables;
+}
+
+static void readCached(vector<BenchTable>& tables) {
+    for (BenchTable& table : tables) {
+        loc_read_conf(table.file, table.params.data(), table.params.size());
+    }
+}
+
+// each read parses its file line by line, as every loc_read_conf() did
+static void readUncached(vector<BenchTable>& tables) {
+    for (BenchTable& table : tables) {
+        FILE* file = fopen(table.file, "r");
+        if (NULL != file) {
+            loc_read_conf_r(file, table.params.data(), table.params.size());
+            fclose(file);
+        }
+    }
+}
+
+static double nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void printReplay(const char* name, double us, const loc_conf_stats_s_type& before,
+                        uint32_t replays) {
+    loc_conf_stats_s_type after;
+    loc_get_conf_stats(&after);
+    printf("%-26s %8.1f us/replay, %5.1f cache parses %5.1f cache hits per replay\n", name,
+           us / replays, (double)(after.file_opens - before.file_opens) / replays,
+           (double)(after.cache_hits - before.cache_hits) / replays);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 4) {
+        fprintf(stderr, "usage: %s [<gps.conf> [<sap.conf> [<flp.conf>]]]\n", argv[0]);
+        return 1;
+    }
+    const char* gpsConf = argc > 1 ? argv[1] : LOC_PATH_GPS_CONF;
+    const char* sapConf = argc > 2 ? argv[2] : LOC_PATH_SAP_CONF;
+    const char* flpConf = argc > 3 ? argv[3] : LOC_PATH_FLP_CONF;
+    vector<BenchTable> cached = startupTables(gpsConf, sapConf, flpConf);
+    vector<BenchTable> uncached = startupTables(gpsConf, sapConf, flpConf);
+
+    loc_conf_stats_s_type before;
+    loc_get_conf_stats(&before);
+    double start = nowUs();
+    readCached(cached);
+    printReplay("loc_read_conf(), first", nowUs() - start, before, 1);
+
+    loc_get_conf_stats(&before);
+    start = nowUs();
+    for (int i = 0; i < REPLAYS; i++) {
+        readCached(cached);
+    }
+    printReplay("loc_read_conf(), again", nowUs() - start, before, REPLAYS);
+
+    loc_get_conf_stats(&before);
+    start = nowUs();
+    for (int i = 0; i < REPLAYS; i++) {
+        readUncached(uncached);
+    }
+    printReplay("loc_read_conf_r()", nowUs() - start, before, REPLAYS);
+
+    uint32_t params = 0;
+    uint32_t bound = 0;
+    uint32_t differ = 0;
+    for (size_t t = 0; t < cached.size(); t++) {
+        for (size_t i = 0; i < cached[t].params.size(); i++) {
+            params++;
+            bound += cached[t].set[i];
+            if (cached[t].set[i] != uncached[t].set[i] ||
+                    0 != memcmp(cached[t].params[i].param_ptr, uncached[t].params[i].param_ptr,
+                                LOC_MAX_PARAM_STRING)) {
+                printf("%s %s differs\n", cached[t].file, cached[t].params[i].param_name);
+                differ++;
+            }
+        }
+    }
+    printf("%u params, %u set by the files, %u bound differently\n", params, bound, differ);
+    return (0 == differ) ? 0 : 1;
+}
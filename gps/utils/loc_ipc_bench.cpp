@@ -0,0 +1,238 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Measures LocIpc throughput over AF_UNIX datagram sockets and over the
+// shared memory ring on this machine. A forked child floods a local or a
+// shm recver with <count> messages of each size, sent in one piece or
+// gathered from a header and a payload. For long messages, a local recver
+// also gets them with the ASCII and with the binary length head. Paced cases
+// send one message every 200 us, to show the one way latency of an idle
+// transport:
+//     loc_ipc_bench [<count> [<socket dir>]]
+// Reported per case are messages/s, MB/s, heap allocations per message
+// received and the median and 99th percentile latency.
+
+#include "LocIpc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace loc_util;
+
+// where the location daemons keep their sockets, see SOCKET_DIR_LOCATION
+static const char* sDefaultDir = "/dev/socket/location/";
+static atomic<uint64_t> sAllocs(0);
+
+#define PACED_COUNT 3000
+#define PACED_INTERVAL_US 200
+
+void* operator new(size_t size) {
+    sAllocs++;
+    void* ptr = malloc(size ? size : 1);
+    if (nullptr == ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct BenchHeader {
+    double sentAt;
+    uint32_t seq;
+    uint32_t len;
+};
+
+class BenchListener : public ILocIpcListener {
+public:
+    atomic<uint32_t> mGot;
+    atomic<uint32_t> mBad;
+    uint32_t mNextSeq;
+    // reserved up front, so that recording allocates nothing
+    vector<double> mLatencies;
+    inline BenchListener(uint32_t count) : mGot(0), mBad(0), mNextSeq(0) {
+        mLatencies.reserve(count);
+    }
+    virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver*) override {
+        BenchHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.seq != mNextSeq++ || header.len != len || 0 != data[len]) {
+            mBad++;
+        }
+        if (mLatencies.size() < mLatencies.capacity()) {
+            mLatencies.push_back(now() - header.sentAt);
+        }
+        mGot++;
+    }
+};
+
+enum BenchTransport {
+    BENCH_LOCAL,
+    BENCH_SHM,
+};
+
+static const char* sTransportNames[] = {"local", "shm"};
+
+enum BenchMode {
+    BENCH_ONE_PIECE,
+    BENCH_GATHERED,
+    BENCH_GATHERED_BINARY_HEAD,
+};
+
+static const char* sModeNames[] = {"one piece", "gathered", "gathered, binary head"};
+
+static void sendAll(const string& name, BenchTransport transport, uint32_t size,
+                    uint32_t count, BenchMode mode, bool paced) {
+    shared_ptr<LocIpcSender> sender = (BENCH_SHM == transport) ?
+            LocIpc::getLocIpcShmSender(name.c_str()) :
+            LocIpc::getLocIpcLocalSender(name.c_str());
+    if (nullptr == sender) {
+        _exit(1);
+    }
+    LocIpc::setBinaryLengthHead(*sender, BENCH_GATHERED_BINARY_HEAD == mode);
+    vector<uint8_t> buf(size, 'x');
+    BenchHeader header = {0, 0, size};
+    struct iovec iov[2] = {
+        {&header, sizeof(header)},
+        {buf.data() + sizeof(header), size - sizeof(header)}
+    };
+    for (uint32_t i = 0; i < count; ) {
+        header.seq = i;
+        header.sentAt = now();
+        bool sent;
+        if (BENCH_ONE_PIECE == mode) {
+            memcpy(buf.data(), &header, sizeof(header));
+            sent = LocIpc::send(*sender, buf.data(), size);
+        } else {
+            sent = LocIpc::send(*sender, iov, 2);
+        }
+        if (sent) {
+            i++;
+            if (paced) {
+                usleep(PACED_INTERVAL_US);
+            }
+        } else {
+            // recver socket buffer or ring is full
+            usleep(100);
+        }
+    }
+}
+
+static bool runCase(const string& dir, BenchTransport transport, uint32_t size,
+                    uint32_t count, BenchMode mode, bool paced = false) {
+    string name = dir + ((BENCH_SHM == transport) ? "loc_ipc_bench_shm" : "loc_ipc_bench");
+    auto listener = make_shared<BenchListener>(count);
+    LocIpc ipc;
+    unique_ptr<LocIpcRecver> recver((BENCH_SHM == transport) ?
+            LocIpc::getLocIpcShmRecver(listener, name.c_str()) :
+            LocIpc::getLocIpcLocalRecver(listener, name.c_str()));
+    if (nullptr == recver || !ipc.startNonBlockingListening(recver)) {
+        fprintf(stderr, "cannot listen on %s\n", name.c_str());
+        return false;
+    }
+    // let the listening thread settle before counting
+    usleep(20000);
+    uint64_t allocs = sAllocs;
+    double start = now();
+    pid_t pid = fork();
+    if (0 == pid) {
+        sendAll(name, transport, size, count, mode, paced);
+        _exit(0);
+    }
+    double deadline = start + 60;
+    while (listener->mGot < count && now() < deadline) {
+        usleep(100);
+    }
+    double elapsed = now() - start;
+    allocs = sAllocs - allocs;
+    waitpid(pid, nullptr, 0);
+    uint32_t got = listener->mGot;
+    vector<double>& latencies = listener->mLatencies;
+    sort(latencies.begin(), latencies.end());
+    double p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2] * 1e6;
+    double p99 = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100] * 1e6;
+    printf("%-5s %5u B %-21s %-7s %9.0f msg/s %8.1f MB/s %5.2f allocs/msg "
+           "p50 %7.1f us p99 %8.1f us  %u/%u received, %u bad\n",
+           sTransportNames[transport], size, sModeNames[mode], paced ? "paced" : "flooded",
+           got / elapsed, (double)got * size / elapsed / 1e6,
+           got ? (double)allocs / got : 0.0, p50, p99, got, count, (uint32_t)listener->mBad);
+    fflush(stdout);
+    ipc.stopNonBlockingListening();
+    return got == count && 0 == listener->mBad;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 3) {
+        fprintf(stderr, "usage: %s [<count> [<socket dir>]]\n", argv[0]);
+        return 1;
+    }
+    uint32_t count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 20000;
+    string dir = argc > 2 ? string(argv[2]) + "/" : sDefaultDir;
+    if (0 == count) {
+        fprintf(stderr, "usage: %s [<count> [<socket dir>]]\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (BenchTransport transport : {BENCH_LOCAL, BENCH_SHM}) {
+        for (uint32_t size : {64u, 1024u, 8000u}) {
+            ok = runCase(dir, transport, size, count, BENCH_ONE_PIECE) && ok;
+            ok = runCase(dir, transport, size, count, BENCH_GATHERED) && ok;
+        }
+    }
+    // longer than the max tx size, so these go out as a length head and chunks
+    for (uint32_t size : {20000u, 60000u}) {
+        ok = runCase(dir, BENCH_LOCAL, size, count / 4, BENCH_GATHERED) && ok;
+        ok = runCase(dir, BENCH_LOCAL, size, count / 4, BENCH_GATHERED_BINARY_HEAD) && ok;
+    }
+    for (BenchTransport transport : {BENCH_LOCAL, BENCH_SHM}) {
+        for (uint32_t size : {64u, 1024u}) {
+            ok = runCase(dir, transport, size, PACED_COUNT, BENCH_ONE_PIECE, true) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
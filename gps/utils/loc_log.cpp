@@ -33,6 +33,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <string.h>
+#include <stdarg.h>
 #include "log_util.h"
 #include "loc_log.h"
 #include "msg_q.h"
@@ -224,7 +226,36 @@ void log_buffer_insert(char *str, unsigned long buf_size, int level)
 {
     timespec tv;
     clock_gettime(CLOCK_BOOTTIME, &tv);
-    uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
-    string ss = str;
-    loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
+    uint64_t elapsedTimeNs = (uint64_t)tv.tv_sec * 1000000000ULL + (uint64_t)tv.tv_nsec;
+    loc_util::LogBuffer::getInstance()->append(str, strnlen(str, buf_size), level,
+                                               elapsedTimeNs);
+}
+
+/*===========================================================================
+
+FUNCTION log_buffer_insert_binary
+
+DESCRIPTION
+   Insert a log sentence with specific level to the log buffer, as its
+   format plus arguments, leaving the formatting to the dump of the buffer.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void log_buffer_insert_binary(int level, const char *tag, const char *format, ...)
+{
+    static thread_local int32_t sTid = 0;
+    if (0 == sTid) {
+        sTid = syscall(SYS_gettid);
+    }
+    timespec bootTime, realTime;
+    clock_gettime(CLOCK_BOOTTIME, &bootTime);
+    clock_gettime(CLOCK_REALTIME, &realTime);
+    va_list args;
+    va_start(args, format);
+    loc_util::LogBuffer::getInstance()->appendBinary(level, tag, format, args,
+            (uint64_t)bootTime.tv_sec * 1000000000ULL + (uint64_t)bootTime.tv_nsec,
+            (uint64_t)realTime.tv_sec * 1000000000ULL + (uint64_t)realTime.tv_nsec, sTid);
+    va_end(args);
 }
@@ -0,0 +1,143 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Renders a binary log buffer dump, as written by
+// LogBuffer::dumpBinaryToLogFile(), the way LogBuffer::dump() would have:
+//     loc_log_decode /data/vendor/location/gpslog_<time>.bin
+
+#include "LogBinary.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+using namespace loc_util;
+
+static const char* sLevelMap[] = {"E", "W", "I", "D", "V"};
+
+template <typename T>
+static bool readField(FILE* file, T& value) {
+    return 1 == fread(&value, sizeof(value), 1, file);
+}
+
+static bool readBytes(FILE* file, string& bytes, uint32_t len) {
+    bytes.resize(len);
+    return len == fread(&bytes[0], 1, len, file);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <binary log buffer dump>\n", argv[0]);
+        return 1;
+    }
+    FILE* file = fopen(argv[1], "r");
+    if (nullptr == file) {
+        fprintf(stderr, "failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    // a file may hold several dumps, each starting with the magic
+    char magic[sizeof(LOG_BINARY_FILE_MAGIC) - 1];
+    int32_t pid = 0;
+    auto readHead = [&](size_t start) {
+        return sizeof(magic) - start == fread(magic + start, 1, sizeof(magic) - start, file) &&
+                0 == memcmp(magic, LOG_BINARY_FILE_MAGIC, sizeof(magic)) &&
+                readField(file, pid);
+    };
+    if (!readHead(0)) {
+        fprintf(stderr, "%s is not a binary log buffer dump\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    printf("dump log buffer, level[-1]\n");
+
+    unordered_map<uint64_t, string> strings;
+    uint8_t type = 0;
+    size_t count = 0;
+    bool ok = true;
+    while (ok && readField(file, type)) {
+        uint64_t id = 0;
+        uint64_t bootTimeNs = 0, realTimeNs = 0, formatId = 0, tagId = 0;
+        int32_t tid = 0;
+        uint32_t level = 0, len = 0;
+        string bytes;
+        switch (type) {
+        case LOG_BINARY_FILE_MAGIC[0]:
+            magic[0] = type;
+            ok = readHead(1);
+            if (ok) {
+                strings.clear();
+                printf("dump log buffer, level[-1]\n");
+            }
+            break;
+        case LOG_BINARY_ENTRY_STRING:
+            ok = readField(file, id) && readField(file, len) && readBytes(file, bytes, len);
+            if (ok) {
+                strings[id] = bytes;
+            }
+            break;
+        case LOG_BINARY_ENTRY_LINE: {
+            ok = readField(file, bootTimeNs) && readField(file, realTimeNs) &&
+                    readField(file, tid) && readField(file, level) &&
+                    readField(file, formatId) && readField(file, tagId) &&
+                    readField(file, len) && readBytes(file, bytes, len);
+            if (!ok) {
+                break;
+            }
+            string line;
+            if (0 == formatId) {
+                line = bytes;
+            } else {
+                auto format = strings.find(formatId);
+                auto tag = strings.find(tagId);
+                renderLogLine(line, realTimeNs, pid, tid,
+                              (strings.end() == tag) ? nullptr : tag->second.c_str(),
+                              (strings.end() == format) ? "<unknown format>" :
+                                                          format->second.c_str(),
+                              bytes.data(), bytes.size());
+            }
+            printf("[%llu] Level %s: %s\n", (unsigned long long)(bootTimeNs / 1000000000),
+                   (level < sizeof(sLevelMap) / sizeof(sLevelMap[0])) ? sLevelMap[level] : "?",
+                   line.c_str());
+            count++;
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+    }
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "%s is truncated or corrupt after %zu lines\n", argv[1], count);
+        return 1;
+    }
+    return 0;
+}
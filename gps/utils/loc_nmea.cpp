@@ -145,6 +145,28 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+// "*hh\r\n" and the NULL character that complete every sentence
+#define LOC_NMEA_TRAILER_LENGTH     6
+// fixed point formatting is used below this scaled magnitude, where the
+// scaling error stays far below LOC_NMEA_FIXED_TIE_MARGIN
+#define LOC_NMEA_FIXED_MAX          1e9
+#define LOC_NMEA_FIXED_TIE_MARGIN   1e-6
+#define LOC_NMEA_FIXED_MAX_DECIMALS 6
+
+static const double sLocNmeaPow10[LOC_NMEA_FIXED_MAX_DECIMALS + 1] =
+        {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+static const char sLocNmeaHexDigits[] = "0123456789ABCDEF";
+
+typedef struct loc_nmea_writer_s
+{
+    LocNmeaBuffer* nmeaBuffer;
+    char* start;        // '$' of the sentence being written
+    char* pos;          // where the next character goes
+    char* end;          // end of the space for the sentence body
+    uint8_t checksum;   // checksum of the body written so far
+    bool overflow;      // sentence does not fit
+} loc_nmea_writer;
+
 /*===========================================================================
 FUNCTION    convert_Lla_to_Ecef
 
@@ -513,41 +535,340 @@ static loc_nmea_sv_meta* loc_nmea_sv_meta_init(loc_nmea_sv_meta& sv_meta,
 }
 
 /*===========================================================================
-FUNCTION    loc_nmea_put_checksum
+FUNCTION    loc_nmea_begin
 
 DESCRIPTION
-   Generate NMEA sentences generated based on position report
+   Start a new sentence at the end of the output buffer and write its '$'.
+   A sentence may use at most NMEA_SENTENCE_MAX_LENGTH bytes of the buffer,
+   including the checksum, line terminator and NULL character.
 
 DEPENDENCIES
    NONE
 
 RETURN VALUE
-   Total length of the nmea sentence
+   NONE
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static int loc_nmea_put_checksum(char *pNmea, int maxSize)
+static void loc_nmea_begin(loc_nmea_writer &writer, LocNmeaBuffer &nmeaBuffer)
 {
-    uint8_t checksum = 0;
-    int length = 0;
-    if(NULL == pNmea)
-        return 0;
+    size_t remaining = 0;
+    if (nmeaBuffer.length < nmeaBuffer.size) {
+        remaining = nmeaBuffer.size - nmeaBuffer.length;
+    }
+    if (remaining > NMEA_SENTENCE_MAX_LENGTH) {
+        remaining = NMEA_SENTENCE_MAX_LENGTH;
+    }
 
-    pNmea++; //skip the $
-    while (*pNmea != '\0')
-    {
-        checksum ^= *pNmea++;
-        length++;
+    writer.nmeaBuffer = &nmeaBuffer;
+    writer.start = nmeaBuffer.buffer + nmeaBuffer.length;
+    writer.pos = writer.start;
+    // leave room for the "*hh\r\n" trailer and the NULL character
+    writer.end = writer.start;
+    if (remaining > LOC_NMEA_TRAILER_LENGTH) {
+        writer.end += remaining - LOC_NMEA_TRAILER_LENGTH;
+    }
+    writer.checksum = 0;
+    writer.overflow = (NULL == nmeaBuffer.buffer) || (NULL == nmeaBuffer.sentences) ||
+            (nmeaBuffer.count >= nmeaBuffer.maxCount) || (writer.pos >= writer.end);
+
+    if (!writer.overflow) {
+        // $ is not part of the checksum
+        *writer.pos++ = '$';
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_char
+
+DESCRIPTION
+   Append one character to the current sentence and fold it into the
+   checksum
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static inline void loc_nmea_put_char(loc_nmea_writer &writer, char c)
+{
+    if (writer.pos < writer.end) {
+        *writer.pos++ = c;
+        writer.checksum ^= (uint8_t)c;
+    } else {
+        writer.overflow = true;
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_str
+
+DESCRIPTION
+   Append a NULL terminated string to the current sentence, same as "%s"
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_str(loc_nmea_writer &writer, const char* str)
+{
+    while ('\0' != *str) {
+        loc_nmea_put_char(writer, *str++);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_int
+
+DESCRIPTION
+   Append a decimal integer to the current sentence, zero padded to width
+   characters including the sign, same as "%0<width>d"
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_int(loc_nmea_writer &writer, int value, int width)
+{
+    char digits[12];
+    int count = 0;
+    uint32_t magnitude = (value < 0) ? (0u - (uint32_t)value) : (uint32_t)value;
+
+    do {
+        digits[count++] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) {
+        loc_nmea_put_char(writer, '-');
+        width--;
+    }
+    for (int i = count; i < width; i++) {
+        loc_nmea_put_char(writer, '0');
+    }
+    while (count > 0) {
+        loc_nmea_put_char(writer, digits[--count]);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_hex
+
+DESCRIPTION
+   Append an unsigned integer in upper case hex to the current sentence,
+   same as "%X"
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_hex(loc_nmea_writer &writer, uint32_t value)
+{
+    char digits[8];
+    int count = 0;
+
+    do {
+        digits[count++] = sLocNmeaHexDigits[value & 0xF];
+        value >>= 4;
+    } while (value > 0);
+
+    while (count > 0) {
+        loc_nmea_put_char(writer, digits[--count]);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_fixed
+
+DESCRIPTION
+   Append a floating point value with the given number of decimals to the
+   current sentence, zero padded to width characters including the sign,
+   same as "%0<width>.<decimals>f".
+   The value is rounded in fixed point. printf rounds the exact binary value
+   instead, so values that are too large or too close to a rounding tie for
+   the scaled result to be trusted are still formatted with snprintf, which
+   keeps the output identical to printf for every input.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_fixed(loc_nmea_writer &writer, double value, int decimals, int width)
+{
+    double scaled = fabs(value) * sLocNmeaPow10[decimals];
+    double whole = floor(scaled);
+    double fraction = scaled - whole;
+
+    // false for NaN and infinity as well
+    if (scaled < LOC_NMEA_FIXED_MAX && fabs(fraction - 0.5) > LOC_NMEA_FIXED_TIE_MARGIN) {
+        uint64_t units = (uint64_t)whole + ((fraction > 0.5) ? 1 : 0);
+        char digits[24];
+        int count = 0;
+
+        for (int i = 0; i < decimals; i++) {
+            digits[count++] = '0' + (units % 10);
+            units /= 10;
+        }
+        if (decimals > 0) {
+            digits[count++] = '.';
+        }
+        do {
+            digits[count++] = '0' + (units % 10);
+            units /= 10;
+        } while (units > 0);
+
+        if (signbit(value)) {
+            loc_nmea_put_char(writer, '-');
+            width--;
+        }
+        for (int i = count; i < width; i++) {
+            loc_nmea_put_char(writer, '0');
+        }
+        while (count > 0) {
+            loc_nmea_put_char(writer, digits[--count]);
+        }
+    } else {
+        char text[NMEA_SENTENCE_MAX_LENGTH];
+        int length = snprintf(text, sizeof(text), "%0*.*f", width, decimals, value);
+        if (length < 0 || length >= (int)sizeof(text)) {
+            writer.overflow = true;
+            return;
+        }
+        loc_nmea_put_str(writer, text);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_end
+
+DESCRIPTION
+   Complete the current sentence with its checksum and line terminator
+   and add it to the output buffer.
+   A sentence that did not fit is dropped.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if the sentence was added
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static bool loc_nmea_end(loc_nmea_writer &writer)
+{
+    if (writer.overflow) {
+        LOC_LOGE("NMEA Error in string formatting");
+        return false;
     }
 
-    // length now contains nmea sentence string length not including $ sign.
-    int checksumLength = snprintf(pNmea,(maxSize-length-1),"*%02X\r\n", checksum);
+    char* pos = writer.pos;
+    *pos++ = '*';
+    *pos++ = sLocNmeaHexDigits[writer.checksum >> 4];
+    *pos++ = sLocNmeaHexDigits[writer.checksum & 0xF];
+    *pos++ = '\r';
+    *pos++ = '\n';
+    *pos = '\0';
+
+    LocNmeaBuffer &nmeaBuffer = *writer.nmeaBuffer;
+    GnssNmeaSentence &sentence = nmeaBuffer.sentences[nmeaBuffer.count++];
+    sentence.sentence = writer.start;
+    sentence.length = pos - writer.start;
+    nmeaBuffer.length += sentence.length + 1;
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_sentence
+
+DESCRIPTION
+   Add a fixed sentence, given without its leading '$', to the output buffer
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if the sentence was added
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static bool loc_nmea_put_sentence(LocNmeaBuffer &nmeaBuffer, const char* body)
+{
+    loc_nmea_writer writer;
+    loc_nmea_begin(writer, nmeaBuffer);
+    loc_nmea_put_str(writer, body);
+    return loc_nmea_end(writer);
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_repeat_sentence
+
+DESCRIPTION
+   Add another copy of an already generated sentence to the output buffer
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if the sentence was added
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static bool loc_nmea_repeat_sentence(LocNmeaBuffer &nmeaBuffer, uint32_t index)
+{
+    if (index >= nmeaBuffer.count) {
+        return false;
+    }
+    const GnssNmeaSentence &sentence = nmeaBuffer.sentences[index];
+    if (nmeaBuffer.count >= nmeaBuffer.maxCount ||
+        nmeaBuffer.length + sentence.length + 1 > nmeaBuffer.size) {
+        LOC_LOGE("NMEA Error in string formatting");
+        return false;
+    }
 
-    // total length of nmea sentence is length of nmea sentence inc $ sign plus
-    // length of checksum (+1 is to cover the $ character in the length).
-    return (length + checksumLength + 1);
+    char* start = nmeaBuffer.buffer + nmeaBuffer.length;
+    memcpy(start, sentence.sentence, sentence.length + 1);
+    GnssNmeaSentence &copy = nmeaBuffer.sentences[nmeaBuffer.count++];
+    copy.sentence = start;
+    copy.length = sentence.length;
+    nmeaBuffer.length += sentence.length + 1;
+    return true;
 }
 
 /*===========================================================================
@@ -572,20 +893,16 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtended,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmeaBuffer)
 {
-    if (!sentence || bufSize <= 0 || !sv_meta_p)
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid arguments.");
         return 0;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    loc_nmea_writer writer;
 
     uint32_t svUsedCount = 0;
     uint32_t svUsedList[64] = {0};
@@ -627,56 +944,43 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     // v.v : Vertical DOP
     // s : GNSS System Id
     // cc : Checksum value
-    length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-
-    if (length < 0 || length >= lengthRemaining)
-    {
-        LOC_LOGE("NMEA Error in string formatting");
-        return 0;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    loc_nmea_begin(writer, nmeaBuffer);
+    loc_nmea_put_str(writer, talker);
+    loc_nmea_put_str(writer, "GSA,A,");
+    loc_nmea_put_char(writer, fixType);
+    loc_nmea_put_char(writer, ',');
 
     // Add first 12 satellite IDs
     for (uint8_t i = 0; i < 12; i++)
     {
         if (i < svUsedCount)
-            length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[i]);
-        else
-            length = snprintf(pMarker, lengthRemaining, ",");
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            loc_nmea_put_int(writer, svUsedList[i], 2);
+        loc_nmea_put_char(writer, ',');
     }
 
     // Add the position/horizontal/vertical DOP values
     if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
     {
-        length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                locationExtended.pdop,
-                locationExtended.hdop,
-                locationExtended.vdop);
+        loc_nmea_put_fixed(writer, locationExtended.pdop, 1, 0);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_fixed(writer, locationExtended.hdop, 1, 0);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_fixed(writer, locationExtended.vdop, 1, 0);
+        loc_nmea_put_char(writer, ',');
     }
     else
     {   // no dop
-        length = snprintf(pMarker, lengthRemaining, ",,,");
+        loc_nmea_put_str(writer, ",,,");
     }
-    pMarker += length;
-    lengthRemaining -= length;
 
     // system id
-    length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-    pMarker += length;
-    lengthRemaining -= length;
+    loc_nmea_put_int(writer, sv_meta_p->systemId, 0);
 
     /* Sentence is ready, add checksum and broadcast */
-    length = loc_nmea_put_checksum(sentence, bufSize);
-    nmeaArraystr.push_back(sentence);
+    if (!loc_nmea_end(writer))
+    {
+        return 0;
+    }
 
     return svUsedCount;
 }
@@ -702,20 +1006,10 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmeaBuffer)
 {
-    if (!sentence || bufSize <= 0)
-    {
-        LOC_LOGE("NMEA Error invalid argument.");
-        return;
-    }
-
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    loc_nmea_writer writer;
     int sentenceCount = 0;
     int sentenceNumber = 1;
     size_t svNumber = 1;
@@ -738,19 +1032,14 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
 
     while (sentenceNumber <= sentenceCount)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_begin(writer, nmeaBuffer);
+        loc_nmea_put_str(writer, talker);
+        loc_nmea_put_str(writer, "GSV,");
+        loc_nmea_put_int(writer, sentenceCount, 0);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_int(writer, sentenceNumber, 0);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_int(writer, svCount, 2);
 
         for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
         {
@@ -790,31 +1079,21 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
             if (sv_meta_p->svType == svNotify.gnssSvs[svNumber - 1].type &&
                     sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
             {
-                length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
+                loc_nmea_put_char(writer, ',');
+                loc_nmea_put_int(writer,
+                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset, 2);
+                loc_nmea_put_char(writer, ',');
+                loc_nmea_put_int(writer,
+                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), 2); //float to int
+                loc_nmea_put_char(writer, ',');
+                loc_nmea_put_int(writer,
+                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth), 3); //float to int
+                loc_nmea_put_char(writer, ',');
 
                 if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
                 {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
+                    loc_nmea_put_int(writer,
+                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz), 2); //float to int
                 }
 
                 i++;
@@ -823,12 +1102,13 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         }
 
         // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_hex(writer, sv_meta_p->signalId);
 
-        length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        if (!loc_nmea_end(writer))
+        {
+            return;
+        }
         sentenceNumber++;
 
     }  //while
@@ -844,21 +1124,18 @@ DEPENDENCIES
    NONE
 
 RETURN VALUE
-   NONE
+   true if the sentence was added
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_nmea_generate_DTM(const LocLla &ref_lla,
+static bool loc_nmea_generate_DTM(const LocLla &ref_lla,
                                   const LocLla &local_lla,
-                                  char *talker,
-                                  char *sentence,
-                                  int bufSize)
+                                  const char *talker,
+                                  LocNmeaBuffer &nmeaBuffer)
 {
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    loc_nmea_writer writer;
     int datum_type;
     char ref_datum[4] = {0};
     char local_datum[4] = {0};
@@ -889,13 +1166,11 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    loc_nmea_begin(writer, nmeaBuffer);
+    loc_nmea_put_str(writer, talker);
+    loc_nmea_put_str(writer, "DTM,");
+    loc_nmea_put_str(writer, local_datum);
+    loc_nmea_put_str(writer, ",,");
 
     lla_offset[0] = local_lla.lat - ref_lla.lat;
     lla_offset[1] = fmod(local_lla.lon - ref_lla.lon, 360.0);
@@ -919,24 +1194,21 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-
-    length = loc_nmea_put_checksum(sentence, bufSize);
+    loc_nmea_put_int(writer, (uint8_t)floor(lla_offset[0]), 2);
+    loc_nmea_put_fixed(writer, latMins, 6, 9);
+    loc_nmea_put_char(writer, ',');
+    loc_nmea_put_char(writer, latHem);
+    loc_nmea_put_char(writer, ',');
+    loc_nmea_put_int(writer, (uint8_t)floor(lla_offset[1]), 3);
+    loc_nmea_put_fixed(writer, longMins, 6, 9);
+    loc_nmea_put_char(writer, ',');
+    loc_nmea_put_char(writer, longHem);
+    loc_nmea_put_char(writer, ',');
+    loc_nmea_put_fixed(writer, lla_offset[2], 3, 0);
+    loc_nmea_put_char(writer, ',');
+    loc_nmea_put_str(writer, ref_datum);
+
+    return loc_nmea_end(writer);
 }
 
 /*===========================================================================
@@ -1234,66 +1506,155 @@ static void loc_nmea_get_fix_quality(const UlpLocation & location,
 }
 
 /*===========================================================================
-FUNCTION    loc_nmea_generate_pos
+FUNCTION    loc_nmea_put_utc_time
 
 DESCRIPTION
-   Generate NMEA sentences generated based on position report
-   Currently below sentences are generated within this function:
-   - $GPGSA : GPS DOP and active SVs
-   - $GLGSA : GLONASS DOP and active SVs
-   - $GAGSA : GALILEO DOP and active SVs
-   - $GNGSA : GNSS DOP and active SVs
-   - $--VTG : Track made good and ground speed
-   - $--RMC : Recommended minimum navigation information
-   - $--GGA : Time, position and fix related data
+   Append a UTC time field, same as "%02d%02d%02d.%02d"
 
 DEPENDENCIES
    NONE
 
 RETURN VALUE
-   0
+   NONE
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-void loc_nmea_generate_pos(const UlpLocation &location,
-                               const GpsLocationExtended &locationExtended,
-                               const LocationSystemInfo &systemInfo,
-                               unsigned char generate_nmea,
-                               bool custom_gga_fix_quality,
-                               std::vector<std::string> &nmeaArraystr)
+static void loc_nmea_put_utc_time(loc_nmea_writer &writer, int hours, int minutes,
+                                  int seconds, int mseconds)
 {
-    ENTRY_LOG();
+    loc_nmea_put_int(writer, hours, 2);
+    loc_nmea_put_int(writer, minutes, 2);
+    loc_nmea_put_int(writer, seconds, 2);
+    loc_nmea_put_char(writer, '.');
+    loc_nmea_put_int(writer, mseconds/10, 2);
+}
 
-    LocGpsUtcTime utcPosTimestamp = 0;
-    bool inLsTransition = false;
+/*===========================================================================
+FUNCTION    loc_nmea_put_lat_lon
 
-    inLsTransition = get_utctime_with_leapsecond_transition
-                    (location, locationExtended, systemInfo, utcPosTimestamp);
+DESCRIPTION
+   Append the latitude and longitude fields of RMC, GNS and GGA, followed
+   by a ','
 
-    time_t utcTime(utcPosTimestamp/1000);
-    struct tm result;
-    tm * pTm = gmtime_r(&utcTime, &result);
-    if (NULL == pTm) {
-        LOC_LOGE("gmtime failed");
-        return;
-    }
+DEPENDENCIES
+   NONE
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_DTM[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_RMC[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_GNS[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_GGA[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
-    int length = 0;
-    int utcYear = pTm->tm_year % 100; // 2 digit year
-    int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
-    int utcDay = pTm->tm_mday;
-    int utcHours = pTm->tm_hour;
-    int utcMinutes = pTm->tm_min;
-    int utcSeconds = pTm->tm_sec;
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_lat_lon(loc_nmea_writer &writer, const UlpLocation &location,
+                                 const LocLla &ref_lla)
+{
+    if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
+    {
+        double latitude = ref_lla.lat;
+        double longitude = ref_lla.lon;
+        char latHemisphere;
+        char lonHemisphere;
+        double latMinutes;
+        double lonMinutes;
+
+        if (latitude > 0)
+        {
+            latHemisphere = 'N';
+        }
+        else
+        {
+            latHemisphere = 'S';
+            latitude *= -1.0;
+        }
+
+        if (longitude < 0)
+        {
+            lonHemisphere = 'W';
+            longitude *= -1.0;
+        }
+        else
+        {
+            lonHemisphere = 'E';
+        }
+
+        latMinutes = fmod(latitude * 60.0 , 60.0);
+        lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+        loc_nmea_put_int(writer, (uint8_t)floor(latitude), 2);
+        loc_nmea_put_fixed(writer, latMinutes, 6, 9);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_char(writer, latHemisphere);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_int(writer, (uint8_t)floor(longitude), 3);
+        loc_nmea_put_fixed(writer, lonMinutes, 6, 9);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_char(writer, lonHemisphere);
+        loc_nmea_put_char(writer, ',');
+    }
+    else
+    {
+        loc_nmea_put_str(writer, ",,,,");
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_generate_pos
+
+DESCRIPTION
+   Generate NMEA sentences generated based on position report
+   Currently below sentences are generated within this function:
+   - $GPGSA : GPS DOP and active SVs
+   - $GLGSA : GLONASS DOP and active SVs
+   - $GAGSA : GALILEO DOP and active SVs
+   - $GNGSA : GNSS DOP and active SVs
+   - $--VTG : Track made good and ground speed
+   - $--RMC : Recommended minimum navigation information
+   - $--GGA : Time, position and fix related data
+   Sentences are appended to nmeaBuffer without any heap allocation.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   0
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               LocNmeaBuffer &nmeaBuffer)
+{
+    ENTRY_LOG();
+
+    LocGpsUtcTime utcPosTimestamp = 0;
+    bool inLsTransition = false;
+
+    inLsTransition = get_utctime_with_leapsecond_transition
+                    (location, locationExtended, systemInfo, utcPosTimestamp);
+
+    time_t utcTime(utcPosTimestamp/1000);
+    struct tm result;
+    tm * pTm = gmtime_r(&utcTime, &result);
+    if (NULL == pTm) {
+        LOC_LOGE("gmtime failed");
+        return;
+    }
+
+    loc_nmea_writer writer;
+    int utcYear = pTm->tm_year % 100; // 2 digit year
+    int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
+    int utcDay = pTm->tm_mday;
+    int utcHours = pTm->tm_hour;
+    int utcMinutes = pTm->tm_min;
+    int utcSeconds = pTm->tm_sec;
     int utcMSeconds = (location.gpsLocation.timestamp)%1000;
     int datum_type = loc_get_datum_type();
     LocEcef ecef_w84;
@@ -1340,9 +1701,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GPGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_GPS_L1CA, true), nmeaBuffer);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1354,9 +1715,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GLGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GLONASS_G1, true), nmeaBuffer);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1368,9 +1729,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GAGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GALILEO_E1, true), nmeaBuffer);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1381,9 +1742,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         // ---$GBGSA/$GNGSA (BEIDOU)---
         // ----------------------------
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaBuffer);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1395,9 +1756,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GQGSA/$GNGSA (QZSS)---
         // --------------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaBuffer);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1408,9 +1769,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // if svUsedCount is 0, it means we do not generate any GSA sentence yet.
         // in this case, generate an empty GSA sentence
         if (svUsedCount == 0) {
-            strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-            nmeaArraystr.push_back(sentence);
+            loc_nmea_put_sentence(nmeaBuffer, "GPGSA,A,1,,,,,,,,,,,,,,,,");
         }
 
         char ggaGpsQuality[3] = {'0', '\0', '\0'};
@@ -1424,8 +1783,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        loc_nmea_begin(writer, nmeaBuffer);
+        loc_nmea_put_str(writer, talker);
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
@@ -1439,45 +1798,38 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                     magTrack -= 360.0;
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            loc_nmea_put_str(writer, "VTG,");
+            loc_nmea_put_fixed(writer, location.gpsLocation.bearing, 1, 0);
+            loc_nmea_put_str(writer, ",T,");
+            loc_nmea_put_fixed(writer, magTrack, 1, 0);
+            loc_nmea_put_str(writer, ",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
+            loc_nmea_put_str(writer, "VTG,,T,,M,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
             float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            loc_nmea_put_fixed(writer, speedKnots, 1, 0);
+            loc_nmea_put_str(writer, ",N,");
+            loc_nmea_put_fixed(writer, speedKmPerHour, 1, 0);
+            loc_nmea_put_str(writer, ",K,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
+            loc_nmea_put_str(writer, ",N,,K,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
+        loc_nmea_put_char(writer, vtgModeIndicator);
+
+        if (!loc_nmea_end(writer))
         {
-            LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
-
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
 
         memset(&ecef_w84, 0, sizeof(ecef_w84));
         memset(&ecef_p90, 0, sizeof(ecef_p90));
@@ -1517,131 +1869,47 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
+        uint32_t dtmIndex = nmeaBuffer.count;
+        if (!loc_nmea_generate_DTM(ref_lla, local_lla, talker, nmeaBuffer))
+        {
+            return;
+        }
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
-
         bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
                 (0 != sv_cache_info.glo_used_mask) ||
                 (0 != sv_cache_info.gal_used_mask) ||
                 (0 != sv_cache_info.qzss_used_mask) ||
                 (0 != sv_cache_info.bds_used_mask));
 
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
+        loc_nmea_begin(writer, nmeaBuffer);
+        loc_nmea_put_str(writer, talker);
+        loc_nmea_put_str(writer, "RMC,");
+        loc_nmea_put_utc_time(writer, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        loc_nmea_put_str(writer, validFix ? ",A," : ",V,");
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_lon(writer, location, ref_lla);
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            loc_nmea_put_fixed(writer, speedKnots, 1, 0);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            loc_nmea_put_fixed(writer, location.gpsLocation.bearing, 1, 0);
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
+        loc_nmea_put_char(writer, ',');
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_int(writer, utcDay, 2);
+        loc_nmea_put_int(writer, utcMonth, 2);
+        loc_nmea_put_int(writer, utcYear, 2);
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
         {
@@ -1657,394 +1925,157 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 direction = 'E';
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
+            loc_nmea_put_fixed(writer, magneticVariation, 1, 0);
+            loc_nmea_put_char(writer, ',');
+            loc_nmea_put_char(writer, direction);
+            loc_nmea_put_char(writer, ',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            loc_nmea_put_str(writer, ",,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, rmcModeIndicator);
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC));
-
-        // -------------------
-        // ------$--GNS-------
-        // -------------------
+        loc_nmea_put_str(writer, ",V");
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
+        if (!loc_nmea_end(writer))
         {
-            LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
 
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
+            // ------$--DTM-------
+            loc_nmea_repeat_sentence(nmeaBuffer, dtmIndex);
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        // -------------------
+        // ------$--GNS-------
+        // -------------------
 
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
+        loc_nmea_begin(writer, nmeaBuffer);
+        loc_nmea_put_str(writer, talker);
+        loc_nmea_put_str(writer, "GNS,");
+        loc_nmea_put_utc_time(writer, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        loc_nmea_put_char(writer, ',');
 
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_lon(writer, location, ref_lla);
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
-        }
-        else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
+        loc_nmea_put_str(writer, gnsModeIndicator);
+        loc_nmea_put_char(writer, ',');
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+        loc_nmea_put_int(writer, svUsedCount, 2);
+        loc_nmea_put_char(writer, ',');
+        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
+            loc_nmea_put_fixed(writer, locationExtended.hdop, 1, 0);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",");
+            loc_nmea_put_fixed(writer, locationExtended.altitudeMeanSeaLevel, 1, 0);
         }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            loc_nmea_put_fixed(writer, ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1, 0);
         }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            loc_nmea_put_fixed(writer, (float)locationExtended.dgnssDataAgeMsec / 1000, 1, 0);
         }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            loc_nmea_put_int(writer, locationExtended.dgnssRefStationId, 4);
         }
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS));
-
+        loc_nmea_put_str(writer, ",V");
 
-        // -------------------
-        // ------$--GGA-------
-        // -------------------
-
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
+        if (!loc_nmea_end(writer))
         {
-            LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
 
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
+        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
+            // ------$--DTM-------
+            loc_nmea_repeat_sentence(nmeaBuffer, dtmIndex);
+        }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
+        // -------------------
+        // ------$--GGA-------
+        // -------------------
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
+        loc_nmea_begin(writer, nmeaBuffer);
+        loc_nmea_put_str(writer, talker);
+        loc_nmea_put_str(writer, "GGA,");
+        loc_nmea_put_utc_time(writer, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        loc_nmea_put_char(writer, ',');
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_lon(writer, location, ref_lla);
 
         // Number of satellites in use, 00-12
         if (svUsedCount > MAX_SATELLITES_IN_USE)
             svUsedCount = MAX_SATELLITES_IN_USE;
+        loc_nmea_put_str(writer, ggaGpsQuality);
+        loc_nmea_put_char(writer, ',');
+        loc_nmea_put_int(writer, svUsedCount, 2);
+        loc_nmea_put_char(writer, ',');
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
-        }
-        else
-        {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
+            loc_nmea_put_fixed(writer, locationExtended.hdop, 1, 0);
         }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
+            loc_nmea_put_fixed(writer, locationExtended.altitudeMeanSeaLevel, 1, 0);
+            loc_nmea_put_str(writer, ",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            loc_nmea_put_str(writer, ",,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            loc_nmea_put_fixed(writer, ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1, 0);
+            loc_nmea_put_str(writer, ",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            loc_nmea_put_str(writer, ",,");
         }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            loc_nmea_put_fixed(writer, (float)locationExtended.dgnssDataAgeMsec / 1000, 1, 0);
         }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_char(writer, ',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            loc_nmea_put_int(writer, locationExtended.dgnssRefStationId, 4);
         }
 
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA));
-
-        // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
-        // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
-        }
-        // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
-        }
-        // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-
+        loc_nmea_end(writer);
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_put_sentence(nmeaBuffer, "GPGSA,A,1,,,,,,,,,,,,,,,,");
+        loc_nmea_put_sentence(nmeaBuffer, "GPVTG,,T,,M,,N,,K,N");
+        loc_nmea_put_sentence(nmeaBuffer, "GPDTM,,,,,,,,");
+        loc_nmea_put_sentence(nmeaBuffer, "GPRMC,,V,,,,,,,,,,N,V");
+        loc_nmea_put_sentence(nmeaBuffer, "GPGNS,,,,,,N,,,,,,,V");
+        loc_nmea_put_sentence(nmeaBuffer, "GPGGA,,,,,,0,,,,,,,,");
     }
 
     EXIT_LOG(%d, 0);
@@ -2057,6 +2088,7 @@ FUNCTION    loc_nmea_generate_sv
 
 DESCRIPTION
    Generate NMEA sentences generated based on sv report
+   Sentences are appended to nmeaBuffer without any heap allocation.
 
 DEPENDENCIES
    NONE
@@ -2069,11 +2101,10 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmeaBuffer)
 {
     ENTRY_LOG();
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
     loc_sv_cache_info sv_cache_info = {};
 
     //Count GPS SVs for saparating GPS from GLONASS and throw others
@@ -2191,86 +2222,223 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
     // ------$GPGSV:L1CA----
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L1CA, false), nmeaBuffer);
 
     // ---------------------
     // ------$GPGSV:L5------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L5, false), nmeaBuffer);
     // ---------------------
     // ------$GLGSV:G1------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G1, false), nmeaBuffer);
 
     // ---------------------
     // ------$GLGSV:G2------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G2, false), nmeaBuffer);
 
     // ---------------------
     // ------$GAGSV:E1------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E1, false), nmeaBuffer);
 
     // -------------------------
     // ------$GAGSV:E5A---------
     // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5A, false), nmeaBuffer);
 
     // -----------------------------
     // ------$PQGSV (QZSS):L1CA-----
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L1CA, false), nmeaBuffer);
 
     // -----------------------------
     // ------$PQGSV (QZSS):L5-------
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L5, false), nmeaBuffer);
     // -----------------------------
     // ------$PQGSV (BEIDOU:B1I)----
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I,false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1I,false), nmeaBuffer);
 
     // -----------------------------
     // ------$PQGSV (BEIDOU:B2AI)---
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI,false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B2AI,false), nmeaBuffer);
 
     // -----------------------------
     // ------$GIGSV (NAVIC:L5)------
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+            GNSS_SIGNAL_NAVIC_L5,false), nmeaBuffer);
 
     EXIT_LOG(%d, 0);
 }
+
+/*===========================================================================
+FUNCTION    loc_nmea_copy_sentences
+
+DESCRIPTION
+   Copy the sentences of nmeaBuffer into a vector of strings, for the
+   std::vector variants of the generators
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_copy_sentences(const LocNmeaBuffer &nmeaBuffer,
+                                    std::vector<std::string> &nmeaArraystr)
+{
+    for (uint32_t i = 0; i < nmeaBuffer.count; i++) {
+        nmeaArraystr.push_back(std::string(nmeaBuffer.sentences[i].sentence,
+                                           nmeaBuffer.sentences[i].length));
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_generate_pos
+
+DESCRIPTION
+   Same as above, but each generated sentence is returned as a string
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   0
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               std::vector<std::string> &nmeaArraystr)
+{
+    std::vector<char> buffer(LOC_NMEA_BUFFER_SIZE);
+    std::vector<GnssNmeaSentence> sentences(LOC_NMEA_MAX_SENTENCES);
+    LocNmeaBuffer nmeaBuffer;
+    loc_nmea_buffer_init(nmeaBuffer, buffer.data(), buffer.size(),
+                         sentences.data(), sentences.size());
+
+    loc_nmea_generate_pos(location, locationExtended, systemInfo,
+                          generate_nmea, custom_gga_fix_quality, nmeaBuffer);
+    loc_nmea_copy_sentences(nmeaBuffer, nmeaArraystr);
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_generate_sv
+
+DESCRIPTION
+   Same as above, but each generated sentence is returned as a string
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   0
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              std::vector<std::string> &nmeaArraystr)
+{
+    std::vector<char> buffer(LOC_NMEA_BUFFER_SIZE);
+    std::vector<GnssNmeaSentence> sentences(LOC_NMEA_MAX_SENTENCES);
+    LocNmeaBuffer nmeaBuffer;
+    loc_nmea_buffer_init(nmeaBuffer, buffer.data(), buffer.size(),
+                         sentences.data(), sentences.size());
+
+    loc_nmea_generate_sv(svNotify, nmeaBuffer);
+    loc_nmea_copy_sentences(nmeaBuffer, nmeaArraystr);
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_split
+
+DESCRIPTION
+   Split a block of NMEA text into its sentences. Each sentence runs up to and
+   including its '\n', the last one may be left unterminated. The sentences
+   are copied back to back into buffer, each followed by a NULL character, so
+   they can be handed out individually. Parsing stops at the first NULL
+   character of the text.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   buffer and sentences are cleared first, sentences point into buffer and
+   stay valid until buffer is modified
+
+===========================================================================*/
+void loc_nmea_split(const char* nmea, size_t length, std::string &buffer,
+                    std::vector<GnssNmeaSentence> &sentences)
+{
+    buffer.clear();
+    sentences.clear();
+    if (NULL == nmea) {
+        return;
+    }
+
+    length = strnlen(nmea, length);
+    // there are at most length sentences, each needs one extra NULL, so
+    // appending below never reallocates and the pointers stay valid
+    buffer.reserve(2 * length + 1);
+
+    const char* end = nmea + length;
+    while (nmea < end) {
+        const char* eol = (const char*)memchr(nmea, '\n', end - nmea);
+        const char* next = (NULL != eol) ? (eol + 1) : end;
+        size_t offset = buffer.length();
+        buffer.append(nmea, next - nmea);
+        buffer.push_back('\0');
+        GnssNmeaSentence sentence = { buffer.data() + offset, (uint32_t)(next - nmea) };
+        sentences.push_back(sentence);
+        nmea = next;
+    }
+}
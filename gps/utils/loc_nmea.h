@@ -72,6 +72,43 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/** Upper bound of the sentences one loc_nmea_generate_pos/sv call adds */
+#define LOC_NMEA_MAX_SENTENCES      64
+/** Size of a buffer that fits LOC_NMEA_MAX_SENTENCES sentences */
+#define LOC_NMEA_BUFFER_SIZE        (LOC_NMEA_MAX_SENTENCES * NMEA_SENTENCE_MAX_LENGTH)
+
+/** Caller supplied output of the NMEA generators. Sentences are appended
+    back to back to buffer, each one NULL terminated, with one entry per
+    sentence added to sentences */
+typedef struct {
+    char*             buffer;       // storage for the sentences
+    size_t            size;         // size of buffer
+    size_t            length;       // bytes of buffer used, NULL characters included
+    GnssNmeaSentence* sentences;    // sentences in buffer, in order
+    uint32_t          maxCount;     // number of entries in sentences
+    uint32_t          count;        // number of sentences in buffer
+} LocNmeaBuffer;
+
+inline void loc_nmea_buffer_init(LocNmeaBuffer &nmeaBuffer, char* buffer, size_t size,
+                                 GnssNmeaSentence* sentences, uint32_t maxCount) {
+    nmeaBuffer.buffer = buffer;
+    nmeaBuffer.size = size;
+    nmeaBuffer.length = 0;
+    nmeaBuffer.sentences = sentences;
+    nmeaBuffer.maxCount = maxCount;
+    nmeaBuffer.count = 0;
+}
+
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              LocNmeaBuffer &nmeaBuffer);
+
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               LocNmeaBuffer &nmeaBuffer);
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
                               std::vector<std::string> &nmeaArraystr);
 
@@ -82,6 +119,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                bool custom_gga_fix_quality,
                                std::vector<std::string> &nmeaArraystr);
 
+void loc_nmea_split(const char* nmea, size_t length, std::string &buffer,
+                    std::vector<GnssNmeaSentence> &sentences);
+
 #define DEBUG_NMEA_MINSIZE 6
 #define DEBUG_NMEA_MAXSIZE 4096
 inline bool loc_nmea_is_debug(const char* nmea, int length) {
@@ -0,0 +1,257 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Checks and times the NMEA generators on a fixed set of pseudo random
+// position and SV reports, the same on every build and machine:
+//     loc_nmea_bench [-d] [<epochs>]
+// The digest of all generated sentences is compared with the one the
+// generator of the original tree produced for these reports, and the
+// caller buffer output with the std::vector<std::string> output. -d dumps
+// the sentences instead, so that the output of two builds can be diffed.
+// Reported is the cost of one epoch, a position and 60 SVs.
+// This file also builds against a loc_nmea.h that has no LocNmeaBuffer.
+
+#include "loc_nmea.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// digest of 20000 epochs, as produced by the original generator with
+// DATUM_TYPE 0
+#define BASELINE_EPOCHS 20000
+#define BASELINE_DIGEST 0x6c57074f349d2f01ULL
+#define TIMED_EPOCHS 20000
+
+// xorshift64*, so the reports do not depend on the C++ library
+static uint64_t sRandom = 12345;
+static uint64_t nextRandom() {
+    sRandom ^= sRandom >> 12;
+    sRandom ^= sRandom << 25;
+    sRandom ^= sRandom >> 27;
+    return sRandom * 0x2545F4914F6CDD1DULL;
+}
+
+static double randomIn(double low, double high) {
+    return low + (high - low) * ((nextRandom() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+// values on, next to and away from the decimal rounding ties of printf
+static double nearTie(double low, double high, int decimals) {
+    double scale = pow(10, decimals);
+    double value = floor(randomIn(low, high) * scale) / scale + 0.5 / scale;
+    switch (nextRandom() % 4) {
+    case 0:
+        return value;
+    case 1:
+        return nextafter(value, 1e9);
+    case 2:
+        return nextafter(value, -1e9);
+    default:
+        return randomIn(low, high);
+    }
+}
+
+static void fillPosition(UlpLocation& location, GpsLocationExtended& extended) {
+    memset(&location, 0, sizeof(location));
+    memset(&extended, 0, sizeof(extended));
+    location.gpsLocation.flags = nextRandom() & 0xffff;
+    location.gpsLocation.latitude = (0 == nextRandom() % 8) ? 0.0 : nearTie(-90, 90, 6);
+    location.gpsLocation.longitude = nearTie(-180, 180, 6);
+    location.gpsLocation.altitude = nearTie(-500, 9000, 1);
+    location.gpsLocation.speed = (float)nearTie(0, 300, 1);
+    location.gpsLocation.bearing = (float)nearTie(0, 360, 1);
+    location.gpsLocation.timestamp = 1500000000000ULL + nextRandom() % 400000000000ULL;
+    extended.flags = nextRandom();
+    extended.pdop = (float)nearTie(0, 50, 1);
+    extended.hdop = (float)nearTie(-1, 50, 1);
+    extended.vdop = (float)nearTie(0, 50, 1);
+    extended.magneticDeviation = (float)nearTie(-30, 30, 1);
+    extended.altitudeMeanSeaLevel = (float)nearTie(-500, 9000, 1);
+    if (0 == nextRandom() % 50) {
+        extended.altitudeMeanSeaLevel = 1e30f;
+    }
+    extended.dgnssDataAgeMsec = nextRandom() % 100000;
+    extended.dgnssRefStationId = nextRandom();
+    extended.navSolutionMask = nextRandom();
+    extended.tech_mask = nextRandom();
+    GnssSvUsedInPosition& used = extended.gnss_sv_used_ids;
+    used.gps_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() & 0xffffffff : 0;
+    used.glo_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() & 0xffffff : 0;
+    used.gal_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() & 0xfffffffff : 0;
+    used.bds_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() : 0;
+    used.qzss_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() & 0x1f : 0;
+    used.navic_sv_used_ids_mask = (nextRandom() % 3) ? nextRandom() & 0x3fff : 0;
+    extended.gpsTime.gpsWeek = nextRandom() % 3000;
+    extended.gpsTime.gpsTimeOfWeekMs = nextRandom() % 604800000;
+}
+
+static void fillSvs(GnssSvNotification& svNotify, uint32_t count) {
+    static const GnssSvType sTypes[] = {
+        GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS, GNSS_SV_TYPE_GALILEO, GNSS_SV_TYPE_QZSS,
+        GNSS_SV_TYPE_BEIDOU, GNSS_SV_TYPE_SBAS, GNSS_SV_TYPE_NAVIC, (GnssSvType)99};
+    static const GnssSignalTypeMask sSignals[] = {
+        0, GNSS_SIGNAL_GPS_L1CA, GNSS_SIGNAL_GPS_L5, GNSS_SIGNAL_GLONASS_G1,
+        GNSS_SIGNAL_GLONASS_G2, GNSS_SIGNAL_GALILEO_E1, GNSS_SIGNAL_GALILEO_E5A,
+        GNSS_SIGNAL_QZSS_L1CA, GNSS_SIGNAL_QZSS_L5, GNSS_SIGNAL_BEIDOU_B1I,
+        GNSS_SIGNAL_BEIDOU_B2AI, GNSS_SIGNAL_NAVIC_L5};
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        GnssSv& sv = svNotify.gnssSvs[i];
+        sv.type = sTypes[nextRandom() % 8];
+        sv.gnssSignalTypeMask = sSignals[nextRandom() % 12];
+        sv.svId = 1 + nextRandom() % 250;
+        sv.elevation = randomIn(-10, 90);
+        sv.azimuth = randomIn(0, 360);
+        sv.cN0Dbhz = randomIn(-5, 55);
+        sv.gnssSvOptionsMask = nextRandom() & 7;
+    }
+}
+
+// FNV-1a over the sentences and their NULL terminators
+static uint64_t addToDigest(uint64_t digest, const char* sentence, size_t length) {
+    for (size_t i = 0; i <= length; i++) {
+        digest = (digest ^ (unsigned char)sentence[i]) * 0x100000001b3ULL;
+    }
+    return digest;
+}
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    bool dump = false;
+    int epochs = BASELINE_EPOCHS;
+    int arg = 1;
+    if (arg < argc && 0 == strcmp(argv[arg], "-d")) {
+        dump = true;
+        arg++;
+    }
+    if (arg < argc) {
+        epochs = atoi(argv[arg++]);
+    }
+    if (arg < argc || epochs <= 0) {
+        fprintf(stderr, "usage: %s [-d] [<epochs>]\n", argv[0]);
+        return 1;
+    }
+
+    LocationSystemInfo systemInfo;
+    memset(&systemInfo, 0, sizeof(systemInfo));
+    static UlpLocation location;
+    static GpsLocationExtended extended;
+    static GnssSvNotification svNotify;
+#ifdef LOC_NMEA_BUFFER_SIZE
+    static char buffer[LOC_NMEA_BUFFER_SIZE];
+    static GnssNmeaSentence sentences[LOC_NMEA_MAX_SENTENCES];
+    uint32_t mismatches = 0;
+#endif
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        fillPosition(location, extended);
+        unsigned char generateNmea = (0 != nextRandom() % 10);
+        bool customGgaFixQuality = (0 != (nextRandom() & 1));
+        fillSvs(svNotify, nextRandom() % (GNSS_SV_MAX + 1));
+        vector<string> nmea;
+        loc_nmea_generate_pos(location, extended, systemInfo, generateNmea,
+                              customGgaFixQuality, nmea);
+        size_t posCount = nmea.size();
+        loc_nmea_generate_sv(svNotify, nmea);
+        for (const string& sentence : nmea) {
+            digest = addToDigest(digest, sentence.c_str(), sentence.length());
+            if (dump) {
+                printf("%s", sentence.c_str());
+            }
+        }
+#ifdef LOC_NMEA_BUFFER_SIZE
+        LocNmeaBuffer nmeaBuffer;
+        loc_nmea_buffer_init(nmeaBuffer, buffer, sizeof(buffer), sentences,
+                             LOC_NMEA_MAX_SENTENCES);
+        loc_nmea_generate_pos(location, extended, systemInfo, generateNmea,
+                              customGgaFixQuality, nmeaBuffer);
+        bool same = (posCount == nmeaBuffer.count);
+        loc_nmea_buffer_init(nmeaBuffer, buffer, sizeof(buffer), sentences,
+                             LOC_NMEA_MAX_SENTENCES);
+        loc_nmea_generate_sv(svNotify, nmeaBuffer);
+        same = same && (nmea.size() - posCount == nmeaBuffer.count);
+        for (uint32_t i = 0; same && i < nmeaBuffer.count; i++) {
+            const string& sentence = nmea[posCount + i];
+            same = (sentence.length() == sentences[i].length &&
+                    0 == memcmp(sentence.c_str(), sentences[i].sentence, sentence.length()));
+        }
+        if (!same) {
+            mismatches++;
+        }
+#endif
+    }
+    if (dump) {
+        return 0;
+    }
+    printf("%d epochs, digest 0x%016llx", epochs, (unsigned long long)digest);
+    if (BASELINE_EPOCHS == epochs) {
+        printf(", %s the original generator",
+               (BASELINE_DIGEST == digest) ? "same as" : "DIFFERENT from");
+    }
+    printf("\n");
+
+    // the timed epoch has every field and 60 SVs
+    fillPosition(location, extended);
+    location.gpsLocation.flags = 0xffff;
+    extended.flags = ~0ULL;
+    fillSvs(svNotify, 60);
+    double start = nowNs();
+    for (int i = 0; i < TIMED_EPOCHS; i++) {
+        vector<string> nmea;
+        loc_nmea_generate_pos(location, extended, systemInfo, 1, false, nmea);
+        loc_nmea_generate_sv(svNotify, nmea);
+    }
+    double vectorNs = (nowNs() - start) / TIMED_EPOCHS;
+    printf("std::vector<std::string> output %8.0f ns/epoch\n", vectorNs);
+#ifdef LOC_NMEA_BUFFER_SIZE
+    printf("LocNmeaBuffer output differs in %u of %d epochs\n", mismatches, epochs);
+    start = nowNs();
+    for (int i = 0; i < TIMED_EPOCHS; i++) {
+        LocNmeaBuffer nmeaBuffer;
+        loc_nmea_buffer_init(nmeaBuffer, buffer, sizeof(buffer), sentences,
+                             LOC_NMEA_MAX_SENTENCES);
+        loc_nmea_generate_pos(location, extended, systemInfo, 1, false, nmeaBuffer);
+        loc_nmea_generate_sv(svNotify, nmeaBuffer);
+    }
+    printf("LocNmeaBuffer output            %8.0f ns/epoch\n", (nowNs() - start) / TIMED_EPOCHS);
+#endif
+    return 0;
+}
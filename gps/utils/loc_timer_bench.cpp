@@ -0,0 +1,174 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Measures what arming, re-arming and disarming <count> long running
+// LocTimers costs, then checks that short timers re-armed while running
+// each fire exactly once:
+//     loc_timer_bench [<count>]
+// Re-arming is timed both as stop() followed by start() and as restart().
+// Build with -DLOC_TIMER_NO_RESTART against a LocTimer.h without restart().
+
+#include "LocTimer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+#define REARM_ROUNDS 5
+#define CHURN_TIMERS 200
+#define CHURN_ROUNDS 20
+
+static atomic<uint32_t> sFired(0);
+
+class BenchTimer : public LocTimer {
+public:
+    atomic<uint32_t> mFired;
+    inline BenchTimer() : LocTimer(), mFired(0) {}
+    virtual void timeOutCallback() override {
+        mFired++;
+        sFired++;
+    }
+};
+
+// fires once the timer thread has handled everything queued before it
+class SyncTimer : public LocTimer {
+public:
+    atomic<bool> mFired;
+    inline SyncTimer() : LocTimer(), mFired(false) {}
+    virtual void timeOutCallback() override {
+        mFired = true;
+    }
+};
+
+static void waitForTimerThread() {
+    SyncTimer sync;
+    sync.start(0, false);
+    while (!sync.mFired) {
+        usleep(100);
+    }
+}
+
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// long enough to never fire while the bench runs
+static uint32_t longTimeOut() {
+    return 60000 + rand() % 10000;
+}
+
+static void stopAndStart(BenchTimer& timer, uint32_t timeOutInMs) {
+    timer.stop();
+    timer.start(timeOutInMs, false);
+}
+
+#ifndef LOC_TIMER_NO_RESTART
+static void restart(BenchTimer& timer, uint32_t timeOutInMs) {
+    timer.restart(timeOutInMs, false);
+}
+#endif
+
+static void rearmAll(const char* name, void (*rearm)(BenchTimer&, uint32_t),
+                     vector<BenchTimer>& timers) {
+    double start = nowMs();
+    for (int round = 0; round < REARM_ROUNDS; round++) {
+        for (BenchTimer& timer : timers) {
+            rearm(timer, longTimeOut());
+        }
+    }
+    waitForTimerThread();
+    printf("re-arm x%d, %-14s %9.1f ms\n", REARM_ROUNDS, name, nowMs() - start);
+}
+
+// short timers, a third of them re-armed every 2 ms while they run
+static void churn(const char* name, void (*rearm)(BenchTimer&, uint32_t),
+                  vector<BenchTimer>& timers) {
+    for (uint32_t i = 0; i < CHURN_TIMERS; i++) {
+        timers[i].mFired = 0;
+        timers[i].start(5 + i % 20, false);
+    }
+    for (uint32_t round = 0; round < CHURN_ROUNDS; round++) {
+        for (uint32_t i = 0; i < CHURN_TIMERS; i += 3) {
+            rearm(timers[i], 5 + (i + round) % 20);
+        }
+        usleep(2000);
+    }
+    usleep(200000);
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < CHURN_TIMERS; i++) {
+        if (1 != timers[i].mFired) {
+            bad++;
+        }
+    }
+    printf("churn, %-14s %u timers, %u did not fire exactly once\n", name, CHURN_TIMERS, bad);
+}
+
+int main(int argc, char** argv) {
+    int count = 5000;
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+    if (argc > 2 || count < CHURN_TIMERS) {
+        fprintf(stderr, "usage: %s [<count>], count >= %d\n", argv[0], CHURN_TIMERS);
+        return 1;
+    }
+    srand(1);
+    vector<BenchTimer> timers(count);
+
+    double start = nowMs();
+    for (BenchTimer& timer : timers) {
+        timer.start(longTimeOut(), false);
+    }
+    waitForTimerThread();
+    printf("%d timers\nstart                    %9.1f ms\n", count, nowMs() - start);
+    rearmAll("stop + start", stopAndStart, timers);
+#ifndef LOC_TIMER_NO_RESTART
+    rearmAll("restart", restart, timers);
+#endif
+    start = nowMs();
+    for (BenchTimer& timer : timers) {
+        timer.stop();
+    }
+    waitForTimerThread();
+    printf("stop                     %9.1f ms\n", nowMs() - start);
+
+    churn("stop + start", stopAndStart, timers);
+#ifndef LOC_TIMER_NO_RESTART
+    churn("restart", restart, timers);
+#endif
+    // timers still running are left for the process exit to reclaim
+    fflush(stdout);
+    _exit(0);
+}
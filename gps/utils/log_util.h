@@ -96,6 +96,8 @@ typedef struct loc_logger_s
   unsigned long  DEBUG_LEVEL;
   unsigned long  TIMESTAMP;
   bool           LOG_BUFFER_ENABLE;
+  bool           LOG_BUFFER_BINARY;
+  unsigned long  LOGCAT_LEVEL;
 } loc_logger_s_type;
 
 
@@ -140,8 +142,18 @@ inline void log_buffer_init(bool enabled) {
     loc_logger.LOG_BUFFER_ENABLE = enabled;
 }
 
+/* binary: keep lines in the log buffer as format plus arguments,
+           formatted only when the buffer is dumped
+   logcatLevel: while the log buffer is enabled, lines above this level
+           go to the log buffer only */
+inline void log_buffer_mode_init(bool binary, unsigned long logcatLevel) {
+    loc_logger.LOG_BUFFER_BINARY = binary;
+    loc_logger.LOGCAT_LEVEL = logcatLevel;
+}
+
 extern char* get_timestamp(char* str, unsigned long buf_size);
 extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
+extern void log_buffer_insert_binary(int level, const char *tag, const char *format, ...);
 
 /*=============================================================================
  *
@@ -154,10 +166,14 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define TOTAL_LOG_LEVELS 5
 #define LOGGING_BUFFER_MAX_LEN 1024
 #define IF_LOG_BUFFER_ENABLE if (loc_logger.LOG_BUFFER_ENABLE)
+#define IF_LOC_LOGCAT(level) \
+    if (!loc_logger.LOG_BUFFER_ENABLE || loc_logger.LOGCAT_LEVEL >= (level))
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
 {                                                                                             \
     IF_LOG_BUFFER_ENABLE {                                                                    \
-        if (flag == 0) {                                                                      \
+        if (flag == 0 && loc_logger.LOG_BUFFER_BINARY) {                                      \
+            log_buffer_insert_binary(level, LOG_TAG, "" format, ##x);                         \
+        } else if (flag == 0) {                                                               \
             char timestr[32];                                                                 \
             get_timestamp(timestr, sizeof(timestr));                                          \
             char log_str[LOGGING_BUFFER_MAX_LEN];                                             \
@@ -181,11 +197,16 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define IF_LOC_LOGD if((loc_logger.DEBUG_LEVEL >= 4) && (loc_logger.DEBUG_LEVEL <= 5))
 #define IF_LOC_LOGV if((loc_logger.DEBUG_LEVEL >= 5) && (loc_logger.DEBUG_LEVEL <= 5))
 
-#define LOC_LOGE(...) IF_LOC_LOGE { ALOGE(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 0, __VA_ARGS__);}
-#define LOC_LOGW(...) IF_LOC_LOGW { ALOGW(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 1, __VA_ARGS__);}
-#define LOC_LOGI(...) IF_LOC_LOGI { ALOGI(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 2, __VA_ARGS__);}
-#define LOC_LOGD(...) IF_LOC_LOGD { ALOGD(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 3, __VA_ARGS__);}
-#define LOC_LOGV(...) IF_LOC_LOGV { ALOGV(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 4, __VA_ARGS__);}
+#define LOC_LOGE(...) IF_LOC_LOGE { IF_LOC_LOGCAT(1) { ALOGE(__VA_ARGS__); } \
+        INSERT_BUFFER(LOG_NDEBUG, 0, __VA_ARGS__);}
+#define LOC_LOGW(...) IF_LOC_LOGW { IF_LOC_LOGCAT(2) { ALOGW(__VA_ARGS__); } \
+        INSERT_BUFFER(LOG_NDEBUG, 1, __VA_ARGS__);}
+#define LOC_LOGI(...) IF_LOC_LOGI { IF_LOC_LOGCAT(3) { ALOGI(__VA_ARGS__); } \
+        INSERT_BUFFER(LOG_NDEBUG, 2, __VA_ARGS__);}
+#define LOC_LOGD(...) IF_LOC_LOGD { IF_LOC_LOGCAT(4) { ALOGD(__VA_ARGS__); } \
+        INSERT_BUFFER(LOG_NDEBUG, 3, __VA_ARGS__);}
+#define LOC_LOGV(...) IF_LOC_LOGV { IF_LOC_LOGCAT(5) { ALOGV(__VA_ARGS__); } \
+        INSERT_BUFFER(LOG_NDEBUG, 4, __VA_ARGS__);}
 
 #else /* DEBUG_DMN_LOC_API */
 
@@ -31,19 +31,62 @@
 #define LOG_TAG "LocSvc_utils_q"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <loc_pla.h>
 #include <log_util.h>
 #include "linked_list.h"
 #include "msg_q.h"
 
+typedef enum {
+   MSG_Q_KIND_LINKED_LIST = 0,      /* mutex + condvar protected linked list */
+   MSG_Q_KIND_RING,                 /* lock-free bounded MPSC ring */
+} msg_q_kind;
+
+/* Both queue flavors start with their kind so that the public API can
+   dispatch on an opaque handle. */
+#define MSG_Q_KIND(q) (*(msg_q_kind*)(q))
+
 typedef struct msg_q {
+   msg_q_kind kind;                 /* Must be first, see MSG_Q_KIND */
    void* msg_list;                  /* Linked list to store information */
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
    int unblocked;                   /* Has this message queue been unblocked? */
 } msg_q;
 
+typedef struct msg_q_ring_cell {
+   atomic_size_t seq;               /* Slot sequence, see msg_q_ring_enqueue */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_ring_cell;
+
+typedef struct msg_q_ring {
+   msg_q_kind kind;                 /* Must be first, see MSG_Q_KIND */
+   msg_q_ring_cell* cells;          /* Preallocated slots, power of 2 in count */
+   size_t mask;                     /* Slot count - 1 */
+   atomic_size_t enqueue_pos;       /* Next slot to be claimed by producers */
+   size_t dequeue_pos;              /* Next slot to be read, consumer only */
+   atomic_int futex_word;           /* Bumped by producers to wake the consumer */
+   atomic_int waiting;              /* Consumer is (about to be) parked */
+   atomic_int unblocked;            /* Has this message queue been unblocked? */
+   atomic_int overflowed;           /* overflow_list holds messages */
+   pthread_mutex_t overflow_mutex;  /* Protects overflow_list */
+   void* overflow_list;             /* Spill over when the ring is full */
+} msg_q_ring;
+
+typedef enum {
+   RING_DEQUEUE_OK,
+   RING_DEQUEUE_EMPTY,
+   RING_DEQUEUE_BUSY,               /* A slot is claimed but not yet published */
+} ring_dequeue_result;
+
 /*===========================================================================
 FUNCTION    convert_linked_list_err_type
 
@@ -83,6 +126,257 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
+static inline void msg_q_ring_wake(msg_q_ring* q, int count)
+{
+   atomic_fetch_add(&q->futex_word, 1);
+   syscall(SYS_futex, (int*)&q->futex_word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_enqueue
+
+DESCRIPTION
+   Claims the next free slot of the ring and publishes msg_obj into it.
+   Each slot carries a sequence number: a slot at position pos is free for
+   the producer when seq == pos, and readable by the consumer when
+   seq == pos + 1. The consumer hands the slot back for the next lap by
+   setting seq to pos + capacity.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if msg_obj was enqueued; 0 if the ring is full
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_ring_enqueue(msg_q_ring* q, void* msg_obj, void (*dealloc)(void*))
+{
+   msg_q_ring_cell* cell;
+   size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+   for (;;) {
+      cell = &q->cells[pos & q->mask];
+      size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+      intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+      if (0 == dif) {
+         if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed)) {
+            break;
+         }
+      } else if (dif < 0) {
+         return 0;
+      } else {
+         pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+      }
+   }
+
+   cell->msg_obj = msg_obj;
+   cell->dealloc = dealloc;
+   atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_pop
+
+DESCRIPTION
+   Reads the oldest slot of the ring, if it has been published.
+
+DEPENDENCIES
+   Must only be called from the consumer thread.
+
+RETURN VALUE
+   RING_DEQUEUE_OK if *msg_obj and *dealloc are valid; RING_DEQUEUE_EMPTY
+   if the ring holds nothing; RING_DEQUEUE_BUSY if a producer is in the
+   middle of publishing the next slot.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static ring_dequeue_result msg_q_ring_pop(msg_q_ring* q, void** msg_obj,
+                                          void (**dealloc)(void*))
+{
+   size_t pos = q->dequeue_pos;
+   msg_q_ring_cell* cell = &q->cells[pos & q->mask];
+   size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+   if (seq == pos + 1) {
+      *msg_obj = cell->msg_obj;
+      *dealloc = cell->dealloc;
+      atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+      q->dequeue_pos = pos + 1;
+      return RING_DEQUEUE_OK;
+   }
+
+   return (atomic_load_explicit(&q->enqueue_pos, memory_order_acquire) != pos) ?
+          RING_DEQUEUE_BUSY : RING_DEQUEUE_EMPTY;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_dequeue
+
+DESCRIPTION
+   Single consumer side of the queue. The overflow list is only looked at
+   once the ring is completely drained, so that a producer which spilled
+   over never has its later messages delivered ahead of earlier ones.
+
+DEPENDENCIES
+   Must only be called from the consumer thread.
+
+RETURN VALUE
+   Same as msg_q_ring_pop
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static ring_dequeue_result msg_q_ring_dequeue(msg_q_ring* q, void** msg_obj)
+{
+   void (*dealloc)(void*);
+   ring_dequeue_result rv = msg_q_ring_pop(q, msg_obj, &dealloc);
+
+   if (RING_DEQUEUE_EMPTY == rv &&
+       atomic_load_explicit(&q->overflowed, memory_order_acquire)) {
+      pthread_mutex_lock(&q->overflow_mutex);
+      if (!linked_list_empty(q->overflow_list) &&
+          eLINKED_LIST_SUCCESS == linked_list_remove(q->overflow_list, msg_obj)) {
+         rv = RING_DEQUEUE_OK;
+      }
+      if (linked_list_empty(q->overflow_list)) {
+         atomic_store_explicit(&q->overflowed, 0, memory_order_release);
+      }
+      pthread_mutex_unlock(&q->overflow_mutex);
+   }
+   return rv;
+}
+
+static msq_q_err_type msg_q_ring_snd(msg_q_ring* q, void* msg_obj, void (*dealloc)(void*))
+{
+   if (atomic_load(&q->unblocked)) {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   /* Once a producer spills over, everybody follows it into the overflow
+      list until the consumer drained it, which keeps per producer FIFO. */
+   if (atomic_load_explicit(&q->overflowed, memory_order_acquire) ||
+       !msg_q_ring_enqueue(q, msg_obj, dealloc)) {
+      pthread_mutex_lock(&q->overflow_mutex);
+      atomic_store_explicit(&q->overflowed, 1, memory_order_release);
+      rv = convert_linked_list_err_type(linked_list_add(q->overflow_list, msg_obj, dealloc));
+      pthread_mutex_unlock(&q->overflow_mutex);
+      LOC_LOGV("%s: ring full, message %p spilled over\n", __FUNCTION__, msg_obj);
+   }
+
+   /* pairs with the fence in msg_q_ring_rcv, either the consumer sees the
+      message or we see it waiting */
+   atomic_thread_fence(memory_order_seq_cst);
+   if (atomic_load_explicit(&q->waiting, memory_order_relaxed)) {
+      msg_q_ring_wake(q, 1);
+   }
+
+   return rv;
+}
+
+static msq_q_err_type msg_q_ring_rcv(msg_q_ring* q, void** msg_obj)
+{
+   if (atomic_load(&q->unblocked)) {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   for (;;) {
+      ring_dequeue_result result = msg_q_ring_dequeue(q, msg_obj);
+      if (RING_DEQUEUE_OK == result) {
+         return eMSG_Q_SUCCESS;
+      } else if (RING_DEQUEUE_BUSY == result) {
+         /* the producer is between claiming and publishing, a few
+            instructions away */
+         sched_yield();
+         continue;
+      }
+
+      int key = atomic_load(&q->futex_word);
+      atomic_store(&q->waiting, 1);
+      atomic_thread_fence(memory_order_seq_cst);
+      result = msg_q_ring_dequeue(q, msg_obj);
+      if (RING_DEQUEUE_EMPTY == result) {
+         if (atomic_load(&q->unblocked)) {
+            atomic_store(&q->waiting, 0);
+            return eMSG_Q_UNAVAILABLE_RESOURCE;
+         }
+         syscall(SYS_futex, (int*)&q->futex_word, FUTEX_WAIT_PRIVATE, key, NULL, NULL, 0);
+      }
+      atomic_store(&q->waiting, 0);
+      if (RING_DEQUEUE_OK == result) {
+         return eMSG_Q_SUCCESS;
+      }
+   }
+}
+
+static msq_q_err_type msg_q_ring_rcv_batch(msg_q_ring* q, void** msg_objs,
+                                           size_t max_count, size_t* count)
+{
+   msq_q_err_type rv = msg_q_ring_rcv(q, &msg_objs[0]);
+   if (eMSG_Q_SUCCESS != rv) {
+      return rv;
+   }
+
+   size_t n = 1;
+   while (n < max_count && RING_DEQUEUE_OK == msg_q_ring_dequeue(q, &msg_objs[n])) {
+      n++;
+   }
+   *count = n;
+   return eMSG_Q_SUCCESS;
+}
+
+static msq_q_err_type msg_q_ring_rmv(msg_q_ring* q, void** msg_obj)
+{
+   if (atomic_load(&q->unblocked)) {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   ring_dequeue_result result;
+   while (RING_DEQUEUE_BUSY == (result = msg_q_ring_dequeue(q, msg_obj))) {
+      sched_yield();
+   }
+   if (RING_DEQUEUE_EMPTY == result) {
+      LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
+      return eLINKED_LIST_EMPTY;
+   }
+   return eMSG_Q_SUCCESS;
+}
+
+static msq_q_err_type msg_q_ring_flush(msg_q_ring* q)
+{
+   void* msg_obj;
+   void (*dealloc)(void*);
+   ring_dequeue_result result;
+
+   /* overflow entries have their dealloc invoked by linked_list_flush */
+   while (RING_DEQUEUE_EMPTY !=
+          (result = msg_q_ring_pop(q, &msg_obj, &dealloc))) {
+      if (RING_DEQUEUE_BUSY == result) {
+         sched_yield();
+      } else if (NULL != dealloc) {
+         dealloc(msg_obj);
+      }
+   }
+
+   pthread_mutex_lock(&q->overflow_mutex);
+   msq_q_err_type rv = convert_linked_list_err_type(linked_list_flush(q->overflow_list));
+   atomic_store(&q->overflowed, 0);
+   pthread_mutex_unlock(&q->overflow_mutex);
+   return rv;
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -151,6 +445,89 @@ const void* msg_q_init2()
   return q;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_init_ring
+
+  ===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, size_t capacity)
+{
+   if( msg_q_data == NULL || capacity == 0 || capacity > (SIZE_MAX >> 2) )
+   {
+      LOC_LOGE("%s: Invalid parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   size_t slots = 1;
+   while( slots < capacity )
+   {
+      slots <<= 1;
+   }
+
+   msg_q_ring* tmp_msg_q = (msg_q_ring*)calloc(1, sizeof(msg_q_ring));
+   if( tmp_msg_q == NULL )
+   {
+      LOC_LOGE("%s: Unable to allocate space for message queue!\n", __FUNCTION__);
+      return eMSG_Q_FAILURE_GENERAL;
+   }
+
+   tmp_msg_q->cells = (msg_q_ring_cell*)calloc(slots, sizeof(msg_q_ring_cell));
+   if( tmp_msg_q->cells == NULL )
+   {
+      LOC_LOGE("%s: Unable to allocate %zu ring slots!\n", __FUNCTION__, slots);
+      free(tmp_msg_q);
+      return eMSG_Q_FAILURE_GENERAL;
+   }
+
+   if( linked_list_init(&tmp_msg_q->overflow_list) != 0 )
+   {
+      LOC_LOGE("%s: Unable to initialize overflow list!\n", __FUNCTION__);
+      free(tmp_msg_q->cells);
+      free(tmp_msg_q);
+      return eMSG_Q_FAILURE_GENERAL;
+   }
+
+   if( pthread_mutex_init(&tmp_msg_q->overflow_mutex, NULL) != 0 )
+   {
+      LOC_LOGE("%s: Unable to initialize overflow mutex!\n", __FUNCTION__);
+      linked_list_destroy(&tmp_msg_q->overflow_list);
+      free(tmp_msg_q->cells);
+      free(tmp_msg_q);
+      return eMSG_Q_FAILURE_GENERAL;
+   }
+
+   for( size_t i = 0; i < slots; i++ )
+   {
+      atomic_init(&tmp_msg_q->cells[i].seq, i);
+   }
+   tmp_msg_q->kind = MSG_Q_KIND_RING;
+   tmp_msg_q->mask = slots - 1;
+   atomic_init(&tmp_msg_q->enqueue_pos, 0);
+   tmp_msg_q->dequeue_pos = 0;
+   atomic_init(&tmp_msg_q->futex_word, 0);
+   atomic_init(&tmp_msg_q->waiting, 0);
+   atomic_init(&tmp_msg_q->unblocked, 0);
+   atomic_init(&tmp_msg_q->overflowed, 0);
+
+   *msg_q_data = tmp_msg_q;
+
+   return eMSG_Q_SUCCESS;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init2_ring
+
+  ===========================================================================*/
+const void* msg_q_init2_ring(size_t capacity)
+{
+  void* q = NULL;
+  if (eMSG_Q_SUCCESS != msg_q_init_ring(&q, capacity)) {
+    q = NULL;
+  }
+  return q;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -164,6 +541,20 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
       return eMSG_Q_INVALID_HANDLE;
    }
 
+   if( *msg_q_data != NULL && MSG_Q_KIND(*msg_q_data) == MSG_Q_KIND_RING )
+   {
+      msg_q_ring* p_ring = (msg_q_ring*)*msg_q_data;
+      /* as linked_list_destroy does for the list kind, hand the messages
+         still queued to their dealloc */
+      msg_q_ring_flush(p_ring);
+      linked_list_destroy(&p_ring->overflow_list);
+      pthread_mutex_destroy(&p_ring->overflow_mutex);
+      free(p_ring->cells);
+      free(p_ring);
+      *msg_q_data = NULL;
+      return eMSG_Q_SUCCESS;
+   }
+
    msg_q* p_msg_q = (msg_q*)*msg_q_data;
 
    linked_list_destroy(&p_msg_q->msg_list);
@@ -197,6 +588,11 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
       return eMSG_Q_INVALID_PARAMETER;
    }
 
+   if( MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING )
+   {
+      return msg_q_ring_snd((msg_q_ring*)msg_q_data, msg_obj, dealloc);
+   }
+
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
@@ -241,6 +637,11 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_INVALID_PARAMETER;
    }
 
+   if( MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING )
+   {
+      return msg_q_ring_rcv((msg_q_ring*)msg_q_data, msg_obj);
+   }
+
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
@@ -267,6 +668,80 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_batch
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               size_t max_count, size_t* count)
+{
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   if( msg_objs == NULL || count == NULL || max_count == 0 )
+   {
+      LOC_LOGE("%s: Invalid msg_objs parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   *count = 0;
+
+   if( MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING )
+   {
+      return msg_q_ring_rcv_batch((msg_q_ring*)msg_q_data, msg_objs, max_count, count);
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+
+   if( p_msg_q->unblocked )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   /* Wait for data in the message queue */
+   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   {
+      pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+   }
+
+   /* Take everything pending, up to max_count, in one lock hold */
+   while( *count < max_count && !linked_list_empty(p_msg_q->msg_list) )
+   {
+      rv = convert_linked_list_err_type(
+            linked_list_remove(p_msg_q->msg_list, &msg_objs[*count]));
+      if( rv != eMSG_Q_SUCCESS )
+      {
+         break;
+      }
+      (*count)++;
+   }
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   if( *count > 0 )
+   {
+      rv = eMSG_Q_SUCCESS;
+   }
+   else if( rv == eMSG_Q_SUCCESS )
+   {
+      /* woken up by msg_q_unblock */
+      rv = eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   LOC_LOGV("%s: Received %zu messages rv = %d\n", __FUNCTION__, *count, rv);
+
+   return rv;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rmv
@@ -285,6 +760,10 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_INVALID_PARAMETER;
    }
 
+   if (MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING) {
+      return msg_q_ring_rmv((msg_q_ring*)msg_q_data, msg_obj);
+   }
+
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
@@ -326,16 +805,23 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
       return eMSG_Q_INVALID_HANDLE;
    }
 
-   msg_q* p_msg_q = (msg_q*)msg_q_data;
-
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
+   if( MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING )
+   {
+      rv = msg_q_ring_flush((msg_q_ring*)msg_q_data);
+   }
+   else
+   {
+      msg_q* p_msg_q = (msg_q*)msg_q_data;
 
-   /* Remove all elements from the list */
-   rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
+      pthread_mutex_lock(&p_msg_q->list_mutex);
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+      /* Remove all elements from the list */
+      rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
+
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+   }
 
    LOC_LOGD("%s: Message Queue flushed\n", __FUNCTION__);
 
@@ -355,6 +841,19 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
       return eMSG_Q_INVALID_HANDLE;
    }
 
+   if( MSG_Q_KIND(msg_q_data) == MSG_Q_KIND_RING )
+   {
+      msg_q_ring* p_ring = (msg_q_ring*)msg_q_data;
+      if( atomic_exchange(&p_ring->unblocked, 1) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+      LOC_LOGD("%s: Unblocking Message Queue\n", __FUNCTION__);
+      msg_q_ring_wake(p_ring, INT_MAX);
+      return eMSG_Q_SUCCESS;
+   }
+
    msg_q* p_msg_q = (msg_q*)msg_q_data;
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
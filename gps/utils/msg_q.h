@@ -90,6 +90,54 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init_ring
+
+DESCRIPTION
+   Initializes a message queue backed by a fixed capacity, lock-free
+   multi-producer single-consumer ring instead of a linked list. Sending
+   does not allocate and does not take a lock; the single consumer parks
+   on a futex only when the ring is empty. Should the ring ever fill up,
+   messages spill into a mutex protected overflow list rather than being
+   dropped, so no message is lost and per producer order is kept.
+
+   Every other msg_q_* function works on the returned handle unchanged,
+   with the restriction that msg_q_rcv / msg_q_rmv / msg_q_flush must only
+   be called from one (consumer) thread at a time.
+
+   msg_q_data: pointer to an opaque Q handle to be returned; NULL if fails
+   capacity:   number of ring slots, rounded up to a power of 2
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, size_t capacity);
+
+/*===========================================================================
+FUNCTION    msg_q_init2_ring
+
+DESCRIPTION
+   Initializes a ring backed message queue, see msg_q_init_ring.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   opaque handle to the Q created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_q_init2_ring(size_t capacity);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 
@@ -157,6 +205,33 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj);
 
+/*===========================================================================
+FUNCTION    msg_q_rcv_batch
+
+DESCRIPTION
+   Retrieves every pending message from the message queue, up to max_count,
+   oldest first. Blocks like msg_q_rcv until at least one message is
+   available, but then takes the rest of the backlog in the same lock hold
+   (or, for a ring queue, without parking again).
+
+   msg_q_data: Message Queue to copy data from.
+   msg_objs:   Array of at least max_count pointers to receive the messages.
+   max_count:  Maximum number of messages to retrieve.
+   count:      Number of messages placed into msg_objs.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               size_t max_count, size_t* count);
+
 /*===========================================================================
 FUNCTION    msg_q_rmv
 
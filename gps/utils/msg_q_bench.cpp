@@ -0,0 +1,190 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Measures msg_q and MsgTask throughput with <producers> threads each
+// sending <count> messages to one consumer, once over the linked list
+// msg_q and once over the MPSC ring msg_q:
+//     msg_q_bench [<count> [<producers>]]
+// Every message carries its producer and sequence number, and the consumer
+// checks that each producer's messages arrive in order. Reported per case
+// are messages/s and the messages out of order.
+
+#include "msg_q.h"
+#include "MsgTask.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+#define RING_CAPACITY 1024
+#define RCV_BATCH 32
+
+struct Producer {
+    void* queue;
+    const MsgTask* msgTask;
+    uint32_t id;
+    uint32_t count;
+};
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline uintptr_t encode(uint32_t id, uint32_t seq) {
+    return ((uintptr_t)id << 24) | seq;
+}
+
+static void* sendToMsgQ(void* arg) {
+    Producer* producer = (Producer*)arg;
+    for (uint32_t seq = 1; seq <= producer->count; seq++) {
+        msg_q_snd(producer->queue, (void*)encode(producer->id, seq), NULL);
+    }
+    return NULL;
+}
+
+static void runMsgQ(const char* name, void* queue, uint32_t producers, uint32_t count) {
+    vector<Producer> args(producers);
+    vector<pthread_t> threads(producers);
+    vector<uint32_t> last(producers, 0);
+    uint64_t total = (uint64_t)producers * count;
+    uint64_t received = 0;
+    uint64_t outOfOrder = 0;
+    double start = nowSec();
+    for (uint32_t i = 0; i < producers; i++) {
+        args[i] = {queue, NULL, i, count};
+        pthread_create(&threads[i], NULL, sendToMsgQ, &args[i]);
+    }
+    while (received < total) {
+        void* msgs[RCV_BATCH];
+        size_t n = 0;
+        if (eMSG_Q_SUCCESS != msg_q_rcv_batch(queue, msgs, RCV_BATCH, &n)) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uintptr_t msg = (uintptr_t)msgs[i];
+            uint32_t id = msg >> 24;
+            uint32_t seq = msg & 0xffffff;
+            if (seq != last[id] + 1) {
+                outOfOrder++;
+            }
+            last[id] = seq;
+        }
+        received += n;
+    }
+    double elapsed = nowSec() - start;
+    for (uint32_t i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    msg_q_destroy(&queue);
+    printf("msg_q %-6s %u producers %10.0f msg/s  %llu/%llu received, %llu out of order\n",
+           name, producers, received / elapsed, (unsigned long long)received,
+           (unsigned long long)total, (unsigned long long)outOfOrder);
+}
+
+// MsgTask side: procs run on the task thread only, so the checks need no lock
+static vector<uint32_t> sLast;
+static uint64_t sOutOfOrder;
+static atomic<uint64_t> sProcessed(0);
+
+struct BenchMsg : public LocMsg {
+    uint32_t mId;
+    uint32_t mSeq;
+    inline BenchMsg(uint32_t id, uint32_t seq) : LocMsg(), mId(id), mSeq(seq) {}
+    inline virtual void proc() const {
+        if (mSeq != sLast[mId] + 1) {
+            sOutOfOrder++;
+        }
+        sLast[mId] = mSeq;
+        sProcessed.fetch_add(1, memory_order_release);
+    }
+};
+
+static void* sendToMsgTask(void* arg) {
+    Producer* producer = (Producer*)arg;
+    for (uint32_t seq = 1; seq <= producer->count; seq++) {
+        producer->msgTask->sendMsg(new BenchMsg(producer->id, seq));
+    }
+    return NULL;
+}
+
+static void runMsgTask(const char* name, size_t ringCapacity, uint32_t producers,
+                       uint32_t count) {
+    MsgTask* msgTask = new MsgTask("MsgQBench", false, ringCapacity);
+    vector<Producer> args(producers);
+    vector<pthread_t> threads(producers);
+    uint64_t total = (uint64_t)producers * count;
+    sLast.assign(producers, 0);
+    sOutOfOrder = 0;
+    sProcessed = 0;
+    double start = nowSec();
+    for (uint32_t i = 0; i < producers; i++) {
+        args[i] = {NULL, msgTask, i, count};
+        pthread_create(&threads[i], NULL, sendToMsgTask, &args[i]);
+    }
+    while (sProcessed.load(memory_order_acquire) < total) {
+        usleep(100);
+    }
+    double elapsed = nowSec() - start;
+    for (uint32_t i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    printf("MsgTask %-4s %u producers %10.0f msg/s  %llu/%llu processed, %llu out of order\n",
+           name, producers, total / elapsed, (unsigned long long)sProcessed.load(),
+           (unsigned long long)total, (unsigned long long)sOutOfOrder);
+    msgTask->destroy();
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = 200000;
+    uint32_t producers = 4;
+    if (argc > 1) {
+        count = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        producers = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || 0 == count || count > 0xffffff || 0 == producers || producers > 64) {
+        fprintf(stderr, "usage: %s [<count> [<producers>]]\n", argv[0]);
+        return 1;
+    }
+
+    runMsgQ("list", (void*)msg_q_init2(), producers, count);
+    runMsgQ("ring", (void*)msg_q_init2_ring(RING_CAPACITY), producers, count);
+    runMsgTask("list", 0, producers, count);
+    runMsgTask("ring", RING_CAPACITY, producers, count);
+    return 0;
+}